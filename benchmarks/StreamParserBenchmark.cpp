@@ -0,0 +1,132 @@
+#include "SSEParser.h"
+#include "StreamDeltaParser.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QVector>
+#include <cstdio>
+
+// Compares the forward-only delta scanner against the QJsonDocument path on
+// SSE streams. Pass .sse files as arguments (e.g. captured from a real
+// provider), or run without arguments to use the synthetic streams in
+// benchmarks/data, which are hand-written in the shape of OpenRouter replies.
+
+namespace {
+
+constexpr int ITERATIONS = 200;
+
+QVector<QByteArray> loadEvents(const QString& path)
+{
+    QVector<QByteArray> events;
+
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::fprintf(stderr, "Cannot open %s\n", qPrintable(path));
+        return events;
+    }
+
+    SSEParser parser;
+    parser.feed(file.readAll());
+
+    SSEEvent event;
+    while (parser.nextEvent(event)) {
+        if (!event.isDone()) {
+            events.append(QByteArray(event.data.constData(), event.data.size()));
+        }
+    }
+    if (parser.flush(event) && !event.isDone()) {
+        events.append(QByteArray(event.data.constData(), event.data.size()));
+    }
+
+    return events;
+}
+
+template <typename ParseFn>
+double measureNsPerEvent(const QVector<QByteArray>& events, ParseFn parse, qint64& checksum)
+{
+    StreamDelta delta;
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < ITERATIONS; ++i) {
+        delta = StreamDelta();
+        for (const QByteArray& data : events) {
+            parse(data, delta);
+            checksum += delta.content.size() + delta.totalTokens;
+        }
+    }
+
+    return static_cast<double>(timer.nsecsElapsed()) / (ITERATIONS * events.size());
+}
+
+bool verify(const QVector<QByteArray>& events)
+{
+    StreamDelta fast;
+    StreamDelta generic;
+
+    for (const QByteArray& data : events) {
+        if (!StreamDeltaParser::parseFast(data, fast)) {
+            std::fprintf(stderr, "Fast path rejected: %s\n", data.left(120).constData());
+            return false;
+        }
+        StreamDeltaParser::parseGeneric(data, generic);
+
+        if (fast.content != generic.content || fast.finishReason != generic.finishReason
+            || fast.totalTokens != generic.totalTokens || fast.id != generic.id || fast.model != generic.model) {
+            std::fprintf(stderr, "Mismatch on: %s\n", data.left(120).constData());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QStringList files = app.arguments().mid(1);
+    if (files.isEmpty()) {
+        QDir dataDir(QStringLiteral(CHATTY_BENCHMARK_DATA_DIR));
+        for (const QFileInfo& info : dataDir.entryInfoList({"*.sse"}, QDir::Files)) {
+            files.append(info.absoluteFilePath());
+        }
+    }
+
+    if (files.isEmpty()) {
+        std::fprintf(stderr, "No SSE streams found\n");
+        return 1;
+    }
+
+    int failures = 0;
+
+    for (const QString& path : files) {
+        QVector<QByteArray> events = loadEvents(path);
+        if (events.isEmpty()) {
+            ++failures;
+            continue;
+        }
+
+        if (!verify(events)) {
+            ++failures;
+            continue;
+        }
+
+        qint64 checksum = 0;
+        const double genericNs = measureNsPerEvent(events, &StreamDeltaParser::parseGeneric, checksum);
+        const double fastNs = measureNsPerEvent(events, &StreamDeltaParser::parseFast, checksum);
+
+        std::printf("%s: %d events\n", qPrintable(QFileInfo(path).fileName()), static_cast<int>(events.size()));
+        std::printf("  QJsonDocument: %8.1f ns/event\n", genericNs);
+        std::printf("  Delta scanner: %8.1f ns/event (%.1fx)\n", fastNs, fastNs > 0.0 ? genericNs / fastNs : 0.0);
+        std::printf("  (checksum %lld)\n", static_cast<long long>(checksum));
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,192 @@
+#include "OpenRouterAPI.h"
+#include "NetworkService.h"
+#include "MockOpenRouterServer.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QEventLoop>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <cstdio>
+
+// Drives the full OpenRouterAPI streaming path (network, SSE parsing, delta
+// parsing, coalescing, retries) against the in-process mock server, so the
+// numbers are reproducible and need no network access or API key. Each
+// scenario also checks the results against what the server sent, and the
+// benchmark exits non-zero on any mismatch.
+//
+// Usage: StreamingPipelineBenchmark [requests] [concurrency]
+
+namespace {
+
+constexpr int DEFAULT_REQUESTS = 40;
+constexpr int DEFAULT_CONCURRENCY = 4;
+constexpr int SCENARIO_TIMEOUT_MS = 5 * 60 * 1000;
+
+struct Scenario {
+    const char* name;
+    MockServerConfig config;
+};
+
+QVector<Scenario> scenarios()
+{
+    MockServerConfig fast;
+    fast.tokensPerSecond = 0.0;
+    fast.responseTokens = 500;
+    fast.timeToFirstByteMs = 0;
+    fast.timeToFirstTokenMs = 0;
+    
+    MockServerConfig realistic;
+    realistic.tokensPerSecond = 200.0;
+    realistic.tokensPerChunk = 2;
+    realistic.jitterMs = 20;
+    
+    MockServerConfig flaky = realistic;
+    flaky.errorRate = 0.2;
+    flaky.errorStatus = 503;
+    flaky.disconnectRate = 0.1;
+    flaky.malformedChunkRate = 0.01;
+    
+    return {
+        {"unthrottled", fast},
+        {"realistic", realistic},
+        {"flaky", flaky},
+    };
+}
+
+bool runScenario(const Scenario& scenario, int requests, int concurrency)
+{
+    MockOpenRouterServer server;
+    server.setConfig(scenario.config);
+    if (!server.listen()) {
+        std::fprintf(stderr, "%s: cannot start the mock server\n", scenario.name);
+        return false;
+    }
+    
+    NetworkService network;
+    OpenRouterAPI api(&network);
+    api.setBaseURL(server.baseUrl());
+    api.setAPIKey("mock-key");
+    api.setModel("mock/model-0");
+    api.setStreamFlushInterval(0);
+    
+    std::vector<Message> conversation;
+    conversation.emplace_back("You are a helpful assistant.", MessageRole::System);
+    conversation.emplace_back("Tell me about streaming parsers.", MessageRole::User);
+    
+    int started = 0;
+    int finished = 0;
+    int succeeded = 0;
+    qint64 characters = 0;
+    QSet<RequestId> active;
+    QHash<RequestId, QString> replies;
+    QHash<RequestId, int> completions;
+    QStringList mismatches;
+    const QString expected = MockOpenRouterServer::expectedContent(scenario.config.responseTokens);
+    
+    QEventLoop loop;
+    auto startNext = [&]() {
+        while (started < requests && active.size() < concurrency) {
+            const RequestId requestId = api.sendMessage(conversation);
+            active.insert(requestId);
+            completions.insert(requestId, 0);
+            ++started;
+        }
+    };
+    
+    QObject::connect(&api, &OpenRouterAPI::streamReceived, [&](RequestId requestId, const QString& content) {
+        characters += content.size();
+        replies[requestId] += content;
+    });
+    QObject::connect(&api, &OpenRouterAPI::streamCompleted, [&](RequestId requestId, bool success) {
+        if (!completions.contains(requestId)) {
+            mismatches << QString("completion for unknown request %1").arg(requestId);
+            return;
+        }
+        if (++completions[requestId] > 1) return; // Reported below
+        active.remove(requestId);
+        ++finished;
+        if (success) ++succeeded;
+        
+        // Malformed chunks are dropped by design, so only clean streams must match word for word
+        if (success && scenario.config.malformedChunkRate == 0.0 && replies.value(requestId) != expected) {
+            mismatches << QString("request %1 reassembled text differs from the stream (%2 of %3 characters)")
+                              .arg(requestId).arg(replies.value(requestId).size()).arg(expected.size());
+        }
+        if (finished == requests) {
+            loop.quit();
+        } else {
+            startNext();
+        }
+    });
+    
+    QElapsedTimer timer;
+    timer.start();
+    QTimer::singleShot(0, &loop, startNext);
+    
+    // A lost completion would otherwise hang the run; it is reported below
+    QTimer::singleShot(SCENARIO_TIMEOUT_MS, &loop, &QEventLoop::quit);
+    loop.exec();
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    
+    const LatencyTracker& latency = api.latency();
+    const LatencySummary ttft = latency.summary("mock/model-0", LatencyTracker::Metric::TimeToFirstToken);
+    const LatencySummary gaps = latency.summary("mock/model-0", LatencyTracker::Metric::InterTokenGap);
+    const LatencySummary total = latency.summary("mock/model-0", LatencyTracker::Metric::Total);
+    const ReliabilityStats reliability = api.getReliabilityStats();
+    const MockServerStats serverStats = server.stats();
+    
+    std::printf("%s: %d/%d succeeded in %.2f s (%.1f req/s, %.0f chars/s), %d connections\n",
+                scenario.name, succeeded, requests, seconds, requests / seconds, characters / seconds,
+                serverStats.connections);
+    std::printf("  TTFT ms      p50 %6.0f  p95 %6.0f  p99 %6.0f\n", ttft.p50, ttft.p95, ttft.p99);
+    std::printf("  Gap ms       p50 %6.0f  p95 %6.0f  p99 %6.0f\n", gaps.p50, gaps.p95, gaps.p99);
+    std::printf("  Total ms     p50 %6.0f  p95 %6.0f  p99 %6.0f\n", total.p50, total.p95, total.p99);
+    std::printf("  Retries %d, recovered %d, failed after retries %d; server errors %d, disconnects %d, malformed %d\n",
+                reliability.retries, reliability.recoveredRequests, reliability.failedAfterRetries,
+                serverStats.errorsSent, serverStats.disconnects, serverStats.malformedChunks);
+    
+    // Every attempt ends in a completed stream, an error status or a
+    // disconnect; each failed attempt is retried or fails its request
+    if (succeeded != serverStats.completedStreams) {
+        mismatches << QString("%1 requests succeeded but the server completed %2 streams")
+                          .arg(succeeded).arg(serverStats.completedStreams);
+    }
+    const int expectedRetries = serverStats.errorsSent + serverStats.disconnects - (requests - succeeded);
+    if (reliability.retries != expectedRetries) {
+        mismatches << QString("%1 retries, expected %2 from %3 errors and %4 disconnects with %5 failed requests")
+                          .arg(reliability.retries).arg(expectedRetries).arg(serverStats.errorsSent)
+                          .arg(serverStats.disconnects).arg(requests - succeeded);
+    }
+    for (auto it = completions.cbegin(); it != completions.cend(); ++it) {
+        if (it.value() != 1) {
+            mismatches << QString("request %1 completed %2 times").arg(it.key()).arg(it.value());
+        }
+    }
+    
+    for (const QString& mismatch : std::as_const(mismatches)) {
+        std::fprintf(stderr, "  MISMATCH: %s\n", qPrintable(mismatch));
+    }
+    return mismatches.isEmpty();
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    
+    const int requestsArg = app.arguments().value(1).toInt();
+    const int concurrencyArg = app.arguments().value(2).toInt();
+    const int requests = requestsArg > 0 ? requestsArg : DEFAULT_REQUESTS;
+    const int concurrency = concurrencyArg > 0 ? concurrencyArg : DEFAULT_CONCURRENCY;
+    
+    bool ok = true;
+    for (const Scenario& scenario : scenarios()) {
+        ok = runScenario(scenario, requests, concurrency) && ok;
+    }
+    
+    return ok ? 0 : 1;
+}
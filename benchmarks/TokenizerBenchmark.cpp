@@ -0,0 +1,226 @@
+#include "ContextBudgeter.h"
+#include "SSEParser.h"
+#include "StreamDeltaParser.h"
+#include "Tokenizer.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QVector>
+#include <cstdio>
+#include <vector>
+
+// Measures how long the BPE tokenizer takes to count a ~100k-token
+// conversation, cold and with the per-message cache warm, then checks that
+// trimming it into a small window keeps the newest user prompt.
+//
+// Usage: TokenizerBenchmark [directory with vocab.json and merges.txt]
+// Without a directory, CHATTY_TOKENIZER_DIR is used; failing that, a small
+// vocabulary is trained on the benchmark text so the run is self-contained.
+
+namespace {
+
+constexpr int TARGET_TOKENS = 100000;
+constexpr int TRAINED_MERGES = 1000;
+
+// Assistant text reassembled from the synthetic streams in benchmarks/data
+QString loadCorpus()
+{
+    QString text;
+    QDir dataDir(QStringLiteral(CHATTY_BENCHMARK_DATA_DIR));
+    
+    for (const QFileInfo& info : dataDir.entryInfoList({"*.sse"}, QDir::Files)) {
+        QFile file(info.absoluteFilePath());
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        
+        SSEParser parser;
+        parser.feed(file.readAll());
+        
+        StreamDelta delta;
+        SSEEvent event;
+        while (parser.nextEvent(event)) {
+            if (!event.isDone() && StreamDeltaParser::parse(event.data, delta)) {
+                text += delta.content;
+            }
+        }
+    }
+    
+    return text;
+}
+
+QVector<ushort> byteToUnicode()
+{
+    QVector<ushort> table(256);
+    int next = 256;
+    for (int b = 0; b < 256; ++b) {
+        const bool printable = (b >= 33 && b <= 126) || (b >= 161 && b <= 172) || (b >= 174 && b <= 255);
+        table[b] = static_cast<ushort>(printable ? b : next++);
+    }
+    return table;
+}
+
+// Minimal BPE training over space-separated words; good enough to give the
+// tokenizer a realistic number of merges to apply
+bool trainVocabulary(const QString& corpus, Tokenizer& tokenizer)
+{
+    const QVector<ushort> byteChars = byteToUnicode();
+    
+    QHash<QStringList, int> words;
+    for (const QString& word : corpus.split(' ', Qt::SkipEmptyParts)) {
+        QStringList symbols;
+        for (char byte : (" " + word).toUtf8()) {
+            symbols.append(QString(QChar(byteChars[static_cast<unsigned char>(byte)])));
+        }
+        words[symbols]++;
+    }
+    
+    QJsonObject vocab;
+    for (int b = 0; b < 256; ++b) {
+        vocab.insert(QString(QChar(byteChars[b])), vocab.size());
+    }
+    
+    QByteArray merges = "#version: 0.2\n";
+    for (int m = 0; m < TRAINED_MERGES; ++m) {
+        QHash<QPair<QString, QString>, int> pairs;
+        for (auto it = words.constBegin(); it != words.constEnd(); ++it) {
+            for (int i = 0; i + 1 < it.key().size(); ++i) {
+                pairs[qMakePair(it.key()[i], it.key()[i + 1])] += it.value();
+            }
+        }
+        if (pairs.isEmpty()) break;
+        
+        QPair<QString, QString> best;
+        int bestCount = 0;
+        for (auto it = pairs.constBegin(); it != pairs.constEnd(); ++it) {
+            if (it.value() > bestCount) {
+                best = it.key();
+                bestCount = it.value();
+            }
+        }
+        if (bestCount < 2) break;
+        
+        const QString merged = best.first + best.second;
+        vocab.insert(merged, vocab.size());
+        merges += (best.first + " " + best.second).toUtf8() + "\n";
+        
+        QHash<QStringList, int> next;
+        for (auto it = words.constBegin(); it != words.constEnd(); ++it) {
+            QStringList symbols;
+            const QStringList& old = it.key();
+            for (int i = 0; i < old.size(); ++i) {
+                if (i + 1 < old.size() && old[i] == best.first && old[i + 1] == best.second) {
+                    symbols.append(merged);
+                    ++i;
+                } else {
+                    symbols.append(old[i]);
+                }
+            }
+            next[symbols] += it.value();
+        }
+        words = std::move(next);
+    }
+    
+    return tokenizer.loadFromData(QJsonDocument(vocab).toJson(QJsonDocument::Compact), merges);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    
+    const QString corpus = loadCorpus();
+    if (corpus.isEmpty()) {
+        std::fprintf(stderr, "No SSE streams found\n");
+        return 1;
+    }
+    
+    Tokenizer tokenizer;
+    QString vocabDir = app.arguments().value(1, qEnvironmentVariable("CHATTY_TOKENIZER_DIR"));
+    if (!vocabDir.isEmpty()) {
+        if (!tokenizer.load(vocabDir)) return 1;
+        std::printf("Vocabulary: %s (%d entries)\n", qPrintable(vocabDir), tokenizer.vocabularySize());
+    } else {
+        QElapsedTimer trainTimer;
+        trainTimer.start();
+        if (!trainVocabulary(corpus, tokenizer)) {
+            std::fprintf(stderr, "Failed to build a vocabulary\n");
+            return 1;
+        }
+        std::printf("Vocabulary: trained on benchmark text (%d entries, %lld ms)\n",
+                    tokenizer.vocabularySize(), static_cast<long long>(trainTimer.elapsed()));
+    }
+    
+    // Build a conversation of alternating turns until it holds ~100k tokens
+    const int corpusTokens = qMax(1, tokenizer.countTokens(corpus));
+    std::vector<Message> conversation;
+    int approxTokens = 0;
+    for (int turn = 0; approxTokens < TARGET_TOKENS; ++turn) {
+        const int offset = (turn * 977) % qMax(1, corpus.size() / 2);
+        const QString text = corpus.mid(offset, 1200 + (turn % 7) * 300);
+        conversation.emplace_back(text, turn % 2 == 0 ? MessageRole::User : MessageRole::Assistant);
+        approxTokens += corpusTokens * text.size() / qMax(1, static_cast<int>(corpus.size()));
+    }
+    tokenizer.clearCache();
+    
+    auto countAll = [&]() {
+        qint64 total = 0;
+        for (const Message& message : conversation) {
+            total += tokenizer.countTokens(message);
+        }
+        return total;
+    };
+    
+    QElapsedTimer timer;
+    timer.start();
+    const qint64 coldTokens = countAll();
+    const double coldMs = timer.nsecsElapsed() / 1e6;
+    
+    timer.restart();
+    const qint64 warmTokens = countAll();
+    const double warmMs = timer.nsecsElapsed() / 1e6;
+    
+    // Re-count after the newest turn changes, as happens on every send
+    conversation.back().setContent(conversation.back().content + " and one more sentence.");
+    timer.restart();
+    countAll();
+    const double incrementalMs = timer.nsecsElapsed() / 1e6;
+    
+    std::printf("Conversation: %d messages, %lld tokens\n",
+                static_cast<int>(conversation.size()), static_cast<long long>(coldTokens));
+    std::printf("  Cold count:        %8.2f ms (%.0f tokens/ms)\n", coldMs, coldMs > 0.0 ? coldTokens / coldMs : 0.0);
+    std::printf("  Cached recount:    %8.2f ms\n", warmMs);
+    std::printf("  After one edit:    %8.2f ms\n", incrementalMs);
+    
+    // Trimming must never drop the newest user prompt, even when it is large
+    // and followed by the empty reply placeholder the chat view streams into
+    std::vector<Message> pending = conversation;
+    pending.emplace_back(corpus.left(12000), MessageRole::User);
+    const QString promptId = pending.back().id;
+    pending.emplace_back(QString(), MessageRole::Assistant);
+    
+    ContextBudgeter budgeter;
+    budgeter.setContextWindow(8192);
+    const ContextBudget budget = budgeter.apply(pending);
+    bool promptKept = false;
+    bool opensOnUser = true;
+    bool seenTurn = false;
+    for (const Message& message : budget.messages) {
+        promptKept = promptKept || message.id == promptId;
+        if (!seenTurn && !message.isSystemMessage()) {
+            opensOnUser = message.isFromUser();
+            seenTurn = true;
+        }
+    }
+    std::printf("  Budget check:      %d of %d messages kept, newest prompt %s, history opens on %s\n",
+                static_cast<int>(budget.messages.size()), static_cast<int>(pending.size()),
+                promptKept ? "kept" : "DROPPED", opensOnUser ? "a user turn" : "AN ORPHANED REPLY");
+    
+    return coldTokens == warmTokens && promptKept && opensOnUser ? 0 : 1;
+}
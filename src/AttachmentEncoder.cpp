@@ -0,0 +1,102 @@
+#include "AttachmentEncoder.h"
+#include <QThreadPool>
+#include <atomic>
+
+namespace {
+
+std::atomic<qint64> s_encodedBytes{0};
+
+} // namespace
+
+void AttachmentEncoder::encodeAsync(const std::shared_ptr<Attachment>& attachment)
+{
+    if (!attachment || !attachment->isImage || attachment->size == 0 || isEncoded(attachment)) {
+        return;
+    }
+    
+    // The job keeps the attachment alive; the raw data it reads is held by
+    // its own reference, so releasing it from another thread is safe
+    QThreadPool::globalInstance()->start([attachment]() {
+        ensureEncoded(attachment);
+    });
+}
+
+QByteArray AttachmentEncoder::dataUrl(const std::shared_ptr<Attachment>& attachment)
+{
+    std::shared_ptr<const QByteArray> url = ensureEncoded(attachment);
+    return url ? *url : QByteArray();
+}
+
+bool AttachmentEncoder::isEncoded(const std::shared_ptr<Attachment>& attachment)
+{
+    return attachment && std::atomic_load(&attachment->encodedDataUrl) != nullptr;
+}
+
+void AttachmentEncoder::adoptDataUrl(Attachment& attachment, const QByteArray& url)
+{
+    attachment.encodedDataUrl = track(new QByteArray(url));
+    attachment.data.reset();
+}
+
+qint64 AttachmentEncoder::encodedBytes()
+{
+    return s_encodedBytes.load(std::memory_order_relaxed);
+}
+
+std::shared_ptr<const QByteArray> AttachmentEncoder::track(QByteArray* url)
+{
+    const qint64 size = url->capacity();
+    s_encodedBytes.fetch_add(size, std::memory_order_relaxed);
+    
+    // Release the accounted bytes when the last payload or attachment lets go
+    return std::shared_ptr<const QByteArray>(url, [size](const QByteArray* buffer) {
+        s_encodedBytes.fetch_sub(size, std::memory_order_relaxed);
+        delete buffer;
+    });
+}
+
+std::shared_ptr<const QByteArray> AttachmentEncoder::encode(const QString& mimeType, const QByteArray& data)
+{
+    const QByteArray prefix = "data:" + mimeType.toUtf8() + ";base64,";
+    
+    auto* url = new QByteArray;
+    url->reserve(prefix.size() + ((data.size() + 2) / 3) * 4);
+    url->append(prefix);
+    
+    // Encode in small steps straight into the reserved buffer, so the only
+    // transient copy is one chunk rather than the whole image in base64
+    for (qsizetype offset = 0; offset < data.size(); offset += ENCODE_CHUNK_BYTES) {
+        const qsizetype length = qMin(ENCODE_CHUNK_BYTES, data.size() - offset);
+        url->append(QByteArray::fromRawData(data.constData() + offset, length).toBase64());
+    }
+    
+    return track(url);
+}
+
+std::shared_ptr<const QByteArray> AttachmentEncoder::ensureEncoded(const std::shared_ptr<Attachment>& attachment)
+{
+    if (!attachment || !attachment->isImage || attachment->size == 0) {
+        return nullptr;
+    }
+    
+    std::shared_ptr<const QByteArray> existing = std::atomic_load(&attachment->encodedDataUrl);
+    if (existing) {
+        return existing;
+    }
+    
+    // Released only after the URL is published, so no raw data means the
+    // URL is there now
+    const std::shared_ptr<const QByteArray> raw = std::atomic_load(&attachment->data);
+    if (!raw) {
+        return std::atomic_load(&attachment->encodedDataUrl);
+    }
+    
+    // If the UI thread and the pool race here, the first result to be
+    // published wins and the other copy is dropped immediately
+    std::shared_ptr<const QByteArray> encoded = encode(attachment->mimeType, *raw);
+    if (std::atomic_compare_exchange_strong(&attachment->encodedDataUrl, &existing, encoded)) {
+        std::atomic_store(&attachment->data, std::shared_ptr<const QByteArray>());
+        return encoded;
+    }
+    return existing;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Message.h"
+#include <QByteArray>
+#include <memory>
+
+// Produces the base64 data URL that image attachments are sent as. The URL
+// is encoded once per attachment, normally on a worker thread right after
+// the attachment is created, and the resulting buffer is shared by every
+// request payload that includes the image instead of being re-encoded on
+// each turn. The raw image bytes are released once the URL exists.
+class AttachmentEncoder {
+public:
+    // Starts encoding on the global thread pool; no-op if already encoded
+    static void encodeAsync(const std::shared_ptr<Attachment>& attachment);
+    
+    // Returns the encoded URL, encoding on the calling thread if the
+    // background job has not finished yet. Empty for non-image attachments.
+    static QByteArray dataUrl(const std::shared_ptr<Attachment>& attachment);
+    
+    static bool isEncoded(const std::shared_ptr<Attachment>& attachment);
+    
+    // Installs a data URL encoded earlier (e.g. read back from a saved
+    // conversation) on an attachment that has not been shared yet
+    static void adoptDataUrl(Attachment& attachment, const QByteArray& url);
+    
+    // Bytes held by the encoded data URLs of all live attachments
+    static qint64 encodedBytes();
+
+private:
+    // Raw bytes per base64 step; a multiple of 3 so no chunk is padded
+    static constexpr qsizetype ENCODE_CHUNK_BYTES = 3 * 16 * 1024;
+    
+    static std::shared_ptr<const QByteArray> track(QByteArray* url);
+    static std::shared_ptr<const QByteArray> encode(const QString& mimeType, const QByteArray& data);
+    static std::shared_ptr<const QByteArray> ensureEncoded(const std::shared_ptr<Attachment>& attachment);
+};
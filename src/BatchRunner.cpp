@@ -0,0 +1,344 @@
+#include "BatchRunner.h"
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QSaveFile>
+#include <QDebug>
+
+double BatchStats::itemsPerMinute() const
+{
+    return elapsedMs > 0 ? completed() * 60000.0 / elapsedMs : 0.0;
+}
+
+double BatchStats::tokensPerSecond() const
+{
+    return elapsedMs > 0 ? completionTokens * 1000.0 / elapsedMs : 0.0;
+}
+
+BatchRunner::BatchRunner(OpenRouterAPI *api, QObject *parent)
+    : QObject(parent)
+    , m_api(api)
+{
+    // Every request's signals arrive here; items are picked out by handle
+    connect(m_api, &OpenRouterAPI::responseReplayed, this, &BatchRunner::onResponseReplayed);
+    connect(m_api, &OpenRouterAPI::streamReceived, this, &BatchRunner::onStreamReceived);
+    connect(m_api, &OpenRouterAPI::firstTokenReceived, this, &BatchRunner::onFirstTokenReceived);
+    connect(m_api, &OpenRouterAPI::promptCacheUsage, this, &BatchRunner::onPromptCacheUsage);
+    connect(m_api, &OpenRouterAPI::requestFinished, this, &BatchRunner::onRequestFinished);
+    connect(m_api, &OpenRouterAPI::streamError, this, &BatchRunner::onStreamError);
+    connect(m_api, &OpenRouterAPI::streamCompleted, this, &BatchRunner::onStreamCompleted);
+}
+
+void BatchRunner::setMaxConcurrent(int requests)
+{
+    m_maxConcurrent = qMax(1, requests);
+    fillSlots();
+}
+
+bool BatchRunner::start(const QString& inputPath, const QString& outputPath)
+{
+    if (m_running) {
+        m_errorString = "A batch is already running";
+        return false;
+    }
+    
+    m_input.setFileName(inputPath);
+    if (!m_input.open(QIODevice::ReadOnly)) {
+        m_errorString = QString("Cannot open %1: %2").arg(inputPath, m_input.errorString());
+        return false;
+    }
+    
+    // Successes from an earlier, interrupted run are kept and appended to
+    if (!loadCompletedIds(outputPath)) {
+        m_input.close();
+        return false;
+    }
+    m_output.setFileName(outputPath);
+    if (!m_output.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        m_errorString = QString("Cannot write %1: %2").arg(outputPath, m_output.errorString());
+        m_input.close();
+        return false;
+    }
+    
+    m_items.clear();
+    m_lineNumber = 0;
+    m_stats = BatchStats();
+    m_running = true;
+    m_cancelled = false;
+    m_inputDone = false;
+    m_errorString.clear();
+    m_elapsed.start();
+    
+    fillSlots();
+    finishIfDone();
+    return true;
+}
+
+void BatchRunner::cancel()
+{
+    if (!m_running) return;
+    
+    // Stopped items are not written, so a rerun picks them up again
+    m_cancelled = true;
+    for (auto it = m_items.cbegin(); it != m_items.cend(); ++it) {
+        m_api->stopRequest(it.key());
+    }
+    finishIfDone();
+}
+
+BatchStats BatchRunner::stats() const
+{
+    BatchStats stats = m_stats;
+    stats.inFlight = m_items.size();
+    stats.elapsedMs = m_running ? m_elapsed.elapsed() : m_stats.elapsedMs;
+    return stats;
+}
+
+bool BatchRunner::loadCompletedIds(const QString& outputPath)
+{
+    m_completedIds.clear();
+    
+    QFile file(outputPath);
+    if (!file.open(QIODevice::ReadOnly)) return true;
+    
+    // Failures are retried, so their old records go; so does a line torn by
+    // the interruption, which fails to parse
+    QByteArray kept;
+    bool dropped = false;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine();
+        const QJsonObject obj = QJsonDocument::fromJson(line).object();
+        const QString id = obj.value("id").toString();
+        if (obj.value("success").toBool() && !m_completedIds.contains(id)) {
+            m_completedIds.insert(id);
+            kept += line.endsWith('\n') ? line : line + '\n';
+        } else {
+            dropped = true;
+        }
+    }
+    file.close();
+    if (!dropped) return true;
+    
+    QSaveFile rewritten(outputPath);
+    if (!rewritten.open(QIODevice::WriteOnly) || rewritten.write(kept) != kept.size() || !rewritten.commit()) {
+        m_errorString = QString("Cannot rewrite %1: %2").arg(outputPath, rewritten.errorString());
+        return false;
+    }
+    return true;
+}
+
+void BatchRunner::fillSlots()
+{
+    while (m_running && !m_cancelled && !m_inputDone && m_items.size() < m_maxConcurrent) {
+        if (m_input.atEnd()) {
+            m_inputDone = true;
+            break;
+        }
+    
+        const QByteArray line = m_input.readLine().trimmed();
+        ++m_lineNumber;
+        if (line.isEmpty()) continue;
+        ++m_stats.read;
+    
+        Item item;
+        item.id = QString("line-%1").arg(m_lineNumber);
+        std::vector<Message> conversation;
+        const bool parsed = parseLine(line, item, conversation);
+        if (m_completedIds.contains(item.id)) {
+            ++m_stats.skipped;
+            continue;
+        }
+        m_completedIds.insert(item.id);
+    
+        if (!parsed) {
+            writeResult(item, false, 0, 0);
+            ++m_stats.failed;
+            emit itemFinished(item.id, false);
+            continue;
+        }
+    
+        item.timer.start();
+        const RequestId requestId = m_api->sendMessage(conversation, item.modelId,
+                                                       NetworkService::Priority::Background);
+        if (item.modelId.isEmpty()) {
+            item.modelId = m_api->model();
+        }
+        m_items.insert(requestId, item);
+    }
+    
+    if (m_running) {
+        emit progress(stats());
+    }
+}
+
+bool BatchRunner::parseLine(const QByteArray& line, Item& item, std::vector<Message>& conversation) const
+{
+    QJsonParseError error;
+    const QJsonObject obj = QJsonDocument::fromJson(line, &error).object();
+    if (error.error != QJsonParseError::NoError) {
+        item.error = QString("Invalid JSON on line %1: %2").arg(m_lineNumber).arg(error.errorString());
+        return false;
+    }
+    
+    // Numeric ids are common in evaluation sets
+    const QJsonValue id = obj.value("id");
+    if (id.isString() && !id.toString().isEmpty()) {
+        item.id = id.toString();
+    } else if (id.isDouble()) {
+        item.id = QString::number(id.toDouble(), 'g', 15);
+    }
+    item.modelId = obj.value("model").toString();
+    
+    if (obj.value("messages").isArray()) {
+        for (const QJsonValue& value : obj.value("messages").toArray()) {
+            const QJsonObject messageObj = value.toObject();
+            const QString role = messageObj.value("role").toString();
+            MessageRole messageRole = MessageRole::User;
+            if (role == "system") {
+                messageRole = MessageRole::System;
+            } else if (role == "assistant") {
+                messageRole = MessageRole::Assistant;
+            }
+            conversation.emplace_back(messageObj.value("content").toString(), messageRole);
+        }
+    } else {
+        if (obj.contains("system")) {
+            conversation.emplace_back(obj.value("system").toString(), MessageRole::System);
+        }
+        if (obj.contains("prompt")) {
+            conversation.emplace_back(obj.value("prompt").toString(), MessageRole::User);
+        }
+    }
+    
+    if (conversation.empty()) {
+        item.error = QString("Line %1 has neither \"prompt\" nor \"messages\"").arg(m_lineNumber);
+        return false;
+    }
+    return true;
+}
+
+void BatchRunner::onResponseReplayed(RequestId requestId)
+{
+    auto it = m_items.find(requestId);
+    if (it != m_items.end()) {
+        it->fromCache = true;
+    }
+}
+
+void BatchRunner::onStreamReceived(RequestId requestId, const QString& content)
+{
+    auto it = m_items.find(requestId);
+    if (it != m_items.end()) {
+        it->content += content;
+    }
+}
+
+void BatchRunner::onFirstTokenReceived(RequestId requestId, qint64 elapsedMs)
+{
+    auto it = m_items.find(requestId);
+    if (it != m_items.end()) {
+        it->firstTokenMs = elapsedMs;
+    }
+}
+
+void BatchRunner::onPromptCacheUsage(RequestId requestId, int promptTokens)
+{
+    auto it = m_items.find(requestId);
+    if (it != m_items.end()) {
+        it->promptTokens = promptTokens;
+        it->promptTokensEstimated = false;
+    }
+}
+
+void BatchRunner::onRequestFinished(const RequestTimeline& timeline)
+{
+    auto it = m_items.find(timeline.requestId);
+    if (it != m_items.end()) {
+        it->attempts = timeline.attempts;
+        it->httpStatus = timeline.httpStatus;
+        
+        // Most models report no usage; keep the budgeter's estimate until
+        // (and unless) promptCacheUsage brings the server's count
+        if (it->promptTokens < 0) {
+            it->promptTokens = timeline.promptTokens;
+            it->promptTokensEstimated = true;
+        }
+    }
+}
+
+void BatchRunner::onStreamError(RequestId requestId, const QString& error)
+{
+    auto it = m_items.find(requestId);
+    if (it == m_items.end()) return;
+    
+    it->error = error;
+}
+
+void BatchRunner::onStreamCompleted(RequestId requestId, bool success)
+{
+    if (!m_items.contains(requestId)) return;
+    finishItem(requestId, success && m_items.value(requestId).error.isEmpty());
+}
+
+void BatchRunner::finishItem(RequestId requestId, bool success)
+{
+    // The count is still available while streamCompleted is being handled
+    const int completionTokens = m_api->streamTokenCount(requestId);
+    const Item item = m_items.take(requestId);
+    
+    if (!m_cancelled || success) {
+        writeResult(item, success, completionTokens, item.timer.elapsed());
+        if (success) {
+            ++m_stats.succeeded;
+            m_stats.completionTokens += completionTokens;
+            m_stats.promptTokens += qMax(0, item.promptTokens);
+        } else {
+            ++m_stats.failed;
+        }
+        emit itemFinished(item.id, success);
+    }
+    
+    fillSlots();
+    finishIfDone();
+}
+
+void BatchRunner::writeResult(const Item& item, bool success, int completionTokens, qint64 totalMs)
+{
+    QJsonObject obj;
+    obj["id"] = item.id;
+    obj["model"] = item.modelId;
+    obj["success"] = success;
+    if (success) {
+        obj["content"] = item.content;
+    } else {
+        obj["error"] = item.error.isEmpty() ? QString("Request did not complete") : item.error;
+    }
+    if (item.promptTokens >= 0) {
+        obj["prompt_tokens"] = item.promptTokens;
+        obj["prompt_tokens_estimated"] = item.promptTokensEstimated;
+    }
+    obj["completion_tokens"] = completionTokens;
+    obj["first_token_ms"] = item.firstTokenMs;
+    obj["total_ms"] = totalMs;
+    obj["attempts"] = item.attempts;
+    obj["http_status"] = item.httpStatus;
+    obj["cached"] = item.fromCache;
+    
+    // Flushed per line so an interruption loses at most the items in flight
+    m_output.write(QJsonDocument(obj).toJson(QJsonDocument::Compact));
+    m_output.write("\n");
+    if (!m_output.flush()) {
+        qWarning() << "Cannot write batch result:" << m_output.fileName() << m_output.errorString();
+    }
+}
+
+void BatchRunner::finishIfDone()
+{
+    if (!m_running || !m_items.isEmpty()) return;
+    if (!m_inputDone && !m_cancelled) return;
+    
+    m_running = false;
+    m_stats.elapsedMs = m_elapsed.elapsed();
+    m_input.close();
+    m_output.close();
+    emit finished(stats());
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "OpenRouterAPI.h"
+#include <QObject>
+#include <QString>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <vector>
+
+// Running totals for one batch
+struct BatchStats {
+    int read = 0;               // Input lines consumed so far
+    int skipped = 0;            // Already succeeded in an earlier run, or a repeated id
+    int succeeded = 0;
+    int failed = 0;
+    int inFlight = 0;
+    qint64 promptTokens = 0;    // Server-reported where the backend sends usage, else estimated
+    qint64 completionTokens = 0;
+    qint64 elapsedMs = 0;
+    
+    int completed() const { return succeeded + failed; }
+    double itemsPerMinute() const;
+    double tokensPerSecond() const;     // Completion tokens over wall time
+};
+
+// Runs every prompt in a JSONL file through OpenRouterAPI, the same client
+// path the chat view uses, with at most maxConcurrent requests in flight.
+// Each input line is either
+//   {"id": "q1", "model": "...", "system": "...", "prompt": "..."}
+// or
+//   {"id": "q2", "model": "...", "messages": [{"role": "user", "content": "..."}]}
+// where id defaults to "line-<n>" and model to the API's current model.
+//
+// One result object per item is appended to the output as soon as it ends,
+// with its latency, token counts and any error. Rerunning with the same
+// output skips the items that already succeeded and retries the rest, so an
+// interrupted batch resumes where it stopped. Failure records from the
+// earlier run are dropped first, and a repeated id is skipped, so the output
+// holds one record per id. Requests go out at background priority through
+// the rate-limit scheduler, keeping interactive chats ahead of the batch.
+class BatchRunner : public QObject {
+    Q_OBJECT
+
+public:
+    explicit BatchRunner(OpenRouterAPI *api, QObject *parent = nullptr);
+    
+    void setMaxConcurrent(int requests);
+    int maxConcurrent() const { return m_maxConcurrent; }
+    
+    bool start(const QString& inputPath, const QString& outputPath);
+    void cancel();
+    bool isRunning() const { return m_running; }
+    BatchStats stats() const;
+    QString errorString() const { return m_errorString; }
+
+signals:
+    void itemFinished(const QString& itemId, bool success);
+    void progress(const BatchStats& stats);
+    void finished(const BatchStats& stats);
+
+private slots:
+    void onResponseReplayed(RequestId requestId);
+    void onStreamReceived(RequestId requestId, const QString& content);
+    void onFirstTokenReceived(RequestId requestId, qint64 elapsedMs);
+    void onPromptCacheUsage(RequestId requestId, int promptTokens);
+    void onRequestFinished(const RequestTimeline& timeline);
+    void onStreamError(RequestId requestId, const QString& error);
+    void onStreamCompleted(RequestId requestId, bool success);
+
+private:
+    struct Item {
+        QString id;
+        QString modelId;
+        QString content;
+        QString error;
+        int promptTokens = -1;
+        bool promptTokensEstimated = false;
+        qint64 firstTokenMs = -1;
+        int attempts = 1;
+        int httpStatus = 0;
+        bool fromCache = false;
+        QElapsedTimer timer;
+    };
+    
+    bool loadCompletedIds(const QString& outputPath);
+    void fillSlots();
+    bool parseLine(const QByteArray& line, Item& item, std::vector<Message>& conversation) const;
+    void finishItem(RequestId requestId, bool success);
+    void writeResult(const Item& item, bool success, int completionTokens, qint64 totalMs);
+    void finishIfDone();
+    
+    OpenRouterAPI *m_api;
+    QFile m_input;
+    QFile m_output;
+    QSet<QString> m_completedIds;       // Ids with a record in the output (or in flight)
+    QHash<RequestId, Item> m_items;
+    int m_lineNumber = 0;
+    int m_maxConcurrent = 4;
+    bool m_running = false;
+    bool m_cancelled = false;
+    bool m_inputDone = false;
+    BatchStats m_stats;
+    QElapsedTimer m_elapsed;
+    QString m_errorString;
+};
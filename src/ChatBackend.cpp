@@ -0,0 +1,259 @@
+#include "ChatBackend.h"
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QRegularExpression>
+
+namespace {
+
+const QString LOCAL_MODEL_PREFIX = QStringLiteral("local:");
+const QString DEFAULT_BACKEND_ID = QStringLiteral("openrouter");
+
+class OpenRouterBackend : public ChatBackend {
+public:
+    explicit OpenRouterBackend(const BackendConfig& config) : ChatBackend(config) {}
+    
+    BackendCapabilities capabilities() const override
+    {
+        BackendCapabilities caps;
+        caps.requiresApiKey = true;
+        caps.promptCaching = true;
+        caps.rateLimitHeaders = true;
+        return caps;
+    }
+    
+    QUrl chatUrl() const override { return endpoint("/chat/completions"); }
+    QUrl modelsUrl() const override { return endpoint("/models"); }
+    
+    QJsonObject payloadHeader(const QString& modelId, int maxTokens, double temperature,
+                              bool requestUsage) const override
+    {
+        QJsonObject payload;
+        payload["model"] = modelId;
+        payload["stream"] = true;
+        payload["temperature"] = temperature;
+        payload["max_tokens"] = maxTokens;
+        if (requestUsage) {
+            // Ask for the usage block so cached-token counts come back
+            payload["usage"] = QJsonObject{{"include", true}};
+        }
+        return payload;
+    }
+};
+
+class OpenAICompatibleBackend : public ChatBackend {
+public:
+    explicit OpenAICompatibleBackend(const BackendConfig& config) : ChatBackend(config) {}
+    
+    BackendCapabilities capabilities() const override
+    {
+        return BackendCapabilities();
+    }
+    
+    QUrl chatUrl() const override { return endpoint("/chat/completions"); }
+    QUrl modelsUrl() const override { return endpoint("/models"); }
+    
+    QJsonObject payloadHeader(const QString& modelId, int maxTokens, double temperature,
+                              bool requestUsage) const override
+    {
+        Q_UNUSED(requestUsage)
+        QJsonObject payload;
+        payload["model"] = modelId;
+        payload["stream"] = true;
+        payload["temperature"] = temperature;
+        payload["max_tokens"] = maxTokens;
+        // Token counts in the final chunk; servers that do not know the option ignore it
+        payload["stream_options"] = QJsonObject{{"include_usage", true}};
+        return payload;
+    }
+};
+
+class OllamaBackend : public ChatBackend {
+public:
+    explicit OllamaBackend(const BackendConfig& config) : ChatBackend(config) {}
+    
+    BackendCapabilities capabilities() const override
+    {
+        BackendCapabilities caps;
+        caps.framing = StreamFraming::NdJson;
+        caps.dialect = PayloadDialect::Ollama;
+        return caps;
+    }
+    
+    QUrl chatUrl() const override { return endpoint("/api/chat"); }
+    QUrl modelsUrl() const override { return endpoint("/api/tags"); }
+    
+    QJsonObject payloadHeader(const QString& modelId, int maxTokens, double temperature,
+                              bool requestUsage) const override
+    {
+        Q_UNUSED(requestUsage)
+        QJsonObject options;
+        options["temperature"] = temperature;
+        options["num_predict"] = maxTokens;
+    
+        QJsonObject payload;
+        payload["model"] = modelId;
+        payload["stream"] = true;
+        payload["options"] = options;
+        return payload;
+    }
+    
+    bool parseStreamChunk(const QByteArray& chunk, StreamDelta& delta) const override
+    {
+        // {"message":{"content":"..."},"done":false}, then a final object
+        // with "done":true and the prompt_eval_count / eval_count totals
+        QJsonParseError error;
+        const QJsonObject obj = QJsonDocument::fromJson(chunk, &error).object();
+        if (error.error != QJsonParseError::NoError) return false;
+    
+        delta.resetChunkFields();
+        if (delta.model.isEmpty()) {
+            delta.model = obj.value("model").toString();
+        }
+        if (obj.contains("error")) {
+            delta.errorMessage = obj.value("error").toString();
+            return true;
+        }
+    
+        delta.content = obj.value("message").toObject().value("content").toString();
+        if (obj.value("done").toBool()) {
+            delta.finishReason = obj.value("done_reason").toString("stop");
+            delta.promptTokens = obj.value("prompt_eval_count").toInt();
+            delta.completionTokens = obj.value("eval_count").toInt();
+            delta.totalTokens = delta.promptTokens + delta.completionTokens;
+            delta.hasUsage = delta.totalTokens > 0;
+        }
+        return true;
+    }
+    
+    bool parseModels(const QByteArray& body, std::vector<ModelInfo>& models) const override
+    {
+        QJsonParseError error;
+        const QJsonObject root = QJsonDocument::fromJson(body, &error).object();
+        if (error.error != QJsonParseError::NoError || !root.value("models").isArray()) return false;
+    
+        for (const QJsonValue& value : root.value("models").toArray()) {
+            const QJsonObject obj = value.toObject();
+            const QString name = obj.value("name").toString();
+            if (name.isEmpty()) continue;
+    
+            ModelInfo model(name, name);
+            const QJsonObject details = obj.value("details").toObject();
+            model.description = details.value("parameter_size").toString();
+    
+            // Vision models carry a CLIP projector or a multimodal family
+            const QJsonArray families = details.value("families").toArray();
+            for (const QJsonValue& family : families) {
+                const QString familyName = family.toString();
+                if (familyName == "clip" || familyName == "mllama") {
+                    model.supportsImages = true;
+                }
+            }
+            models.push_back(model);
+        }
+        return true;
+    }
+};
+
+} // namespace
+
+QString BackendConfig::kindName(BackendKind kind)
+{
+    switch (kind) {
+        case BackendKind::OpenRouter: return "openrouter";
+        case BackendKind::OpenAICompatible: return "openai";
+        case BackendKind::Ollama: return "ollama";
+    }
+    return "openai";
+}
+
+BackendKind BackendConfig::kindFromName(const QString& name)
+{
+    if (name == "openrouter") return BackendKind::OpenRouter;
+    if (name == "ollama") return BackendKind::Ollama;
+    return BackendKind::OpenAICompatible;
+}
+
+std::shared_ptr<const ChatBackend> ChatBackend::create(const BackendConfig& config)
+{
+    switch (config.kind) {
+        case BackendKind::OpenRouter:
+            return std::make_shared<OpenRouterBackend>(config);
+        case BackendKind::Ollama:
+            return std::make_shared<OllamaBackend>(config);
+        case BackendKind::OpenAICompatible:
+            break;
+    }
+    return std::make_shared<OpenAICompatibleBackend>(config);
+}
+
+void ChatBackend::prepareRequest(QNetworkRequest& request) const
+{
+    if (!m_config.apiKey.isEmpty()) {
+        request.setRawHeader("Authorization", QString("Bearer %1").arg(m_config.apiKey).toUtf8());
+    }
+    request.setRawHeader("User-Agent", "Chatty/1.0.0");
+    request.setRawHeader("Accept", "application/json");
+}
+
+bool ChatBackend::parseStreamChunk(const QByteArray& chunk, StreamDelta& delta) const
+{
+    return StreamDeltaParser::parse(chunk, delta);
+}
+
+bool ChatBackend::parseModels(const QByteArray& body, std::vector<ModelInfo>& models) const
+{
+    // OpenAI-style {"data":[{"id":...}]}; context lengths are server extensions
+    QJsonParseError error;
+    const QJsonObject root = QJsonDocument::fromJson(body, &error).object();
+    if (error.error != QJsonParseError::NoError || !root.value("data").isArray()) return false;
+    
+    for (const QJsonValue& value : root.value("data").toArray()) {
+        const QJsonObject obj = value.toObject();
+        const QString id = obj.value("id").toString();
+        if (id.isEmpty()) continue;
+    
+        ModelInfo model(id, id);
+        if (obj.contains("max_model_len")) {
+            model.maxTokens = obj.value("max_model_len").toInt(model.maxTokens);          // vLLM
+        } else if (obj.value("meta").isObject()) {
+            model.maxTokens = obj.value("meta").toObject().value("n_ctx_train").toInt(model.maxTokens); // llama.cpp
+        }
+        models.push_back(model);
+    }
+    return true;
+}
+
+bool BackendConfig::isValidId(const QString& id)
+{
+    // No '/' or ':' so "local:<id>/" parses back unambiguously; the default
+    // backend's id is taken, as the scheduler keys rate limits by backend id
+    static const QRegularExpression pattern(QStringLiteral("^[A-Za-z0-9_.-]+$"));
+    return pattern.match(id).hasMatch() && id.compare(DEFAULT_BACKEND_ID, Qt::CaseInsensitive) != 0;
+}
+
+QString ChatBackend::qualifiedModelId(const QString& modelId) const
+{
+    return LOCAL_MODEL_PREFIX + m_config.id + "/" + modelId;
+}
+
+QString ChatBackend::wireModelId(const QString& modelId) const
+{
+    const QString prefix = LOCAL_MODEL_PREFIX + m_config.id + "/";
+    return modelId.startsWith(prefix) ? modelId.mid(prefix.size()) : modelId;
+}
+
+QString ChatBackend::backendIdOf(const QString& modelId)
+{
+    if (!modelId.startsWith(LOCAL_MODEL_PREFIX)) return QString();
+    const int slash = modelId.indexOf('/', LOCAL_MODEL_PREFIX.size());
+    return slash < 0 ? QString() : modelId.mid(LOCAL_MODEL_PREFIX.size(), slash - LOCAL_MODEL_PREFIX.size());
+}
+
+QUrl ChatBackend::endpoint(const QString& path) const
+{
+    QString base = m_config.baseUrl;
+    while (base.endsWith('/')) {
+        base.chop(1);
+    }
+    return QUrl(base + path);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "ModelIndex.h"
+#include "StreamDeltaParser.h"
+#include <QByteArray>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QString>
+#include <QUrl>
+#include <memory>
+#include <vector>
+
+enum class BackendKind {
+    OpenRouter,
+    OpenAICompatible,   // llama.cpp server, vLLM, Ollama's /v1, LM Studio
+    Ollama              // Ollama's native /api/chat
+};
+
+// How a streamed reply is framed on the wire
+enum class StreamFraming {
+    ServerSentEvents,
+    NdJson              // One JSON object per line
+};
+
+// Shape of the messages array in a request body
+enum class PayloadDialect {
+    OpenAI,             // Content parts with image_url data URLs
+    Ollama              // Plain content plus a base64 "images" array
+};
+
+struct BackendCapabilities {
+    StreamFraming framing = StreamFraming::ServerSentEvents;
+    PayloadDialect dialect = PayloadDialect::OpenAI;
+    bool requiresApiKey = false;
+    bool promptCaching = false;      // Honours cache_control breakpoints
+    bool rateLimitHeaders = false;   // Sends X-RateLimit-* and Retry-After
+};
+
+// One configured inference endpoint. Models from any backend other than
+// the default are listed as "local:<id>/<model>", which also routes
+// requests; the namespace keeps them clear of OpenRouter's
+// "<provider>/<model>" ids.
+struct BackendConfig {
+    QString id;                 // Short, unique; letters, digits, '-', '_', '.'
+
+    QString name;               // Shown as the models' provider
+    BackendKind kind = BackendKind::OpenAICompatible;
+    QString baseUrl;
+    QString apiKey;             // Optional for local servers
+    int requestTimeout = 0;     // Seconds to the first byte (0 = global setting)
+    bool enabled = true;
+    
+    static QString kindName(BackendKind kind);
+    static BackendKind kindFromName(const QString& name);
+    static bool isValidId(const QString& id);
+};
+
+// Dialect of one backend: endpoints, headers, the request header fields,
+// stream chunk parsing and the models list. Instances are immutable once
+// created and are shared with the network thread.
+class ChatBackend {
+public:
+    static std::shared_ptr<const ChatBackend> create(const BackendConfig& config);
+    virtual ~ChatBackend() = default;
+    
+    const BackendConfig& config() const { return m_config; }
+    virtual BackendCapabilities capabilities() const = 0;
+    
+    virtual QUrl chatUrl() const = 0;
+    virtual QUrl modelsUrl() const = 0;
+    virtual void prepareRequest(QNetworkRequest& request) const;
+    
+    // Top-level request fields; the caller splices in "messages"
+    virtual QJsonObject payloadHeader(const QString& modelId, int maxTokens, double temperature,
+                                      bool requestUsage) const = 0;
+    
+    // One SSE data field or NDJSON line into delta
+    virtual bool parseStreamChunk(const QByteArray& chunk, StreamDelta& delta) const;
+    
+    // Models list response; ids are as the server knows them
+    virtual bool parseModels(const QByteArray& body, std::vector<ModelInfo>& models) const;
+    
+    // Catalogue id <-> the id sent to this backend. Ids outside the
+    // "local:" namespace (the default backend's) pass through unchanged.
+    QString qualifiedModelId(const QString& modelId) const;
+    QString wireModelId(const QString& modelId) const;
+    
+    // Backend id of a "local:<id>/<model>" catalogue id, else empty
+    static QString backendIdOf(const QString& modelId);
+
+protected:
+    explicit ChatBackend(const BackendConfig& config) : m_config(config) {}
+    QUrl endpoint(const QString& path) const;
+    
+    BackendConfig m_config;
+};
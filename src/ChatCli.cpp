@@ -0,0 +1,290 @@
+#include "ChatCli.h"
+#include "OpenRouterAPI.h"
+#include "BatchRunner.h"
+#include "Settings.h"
+#include "FileManager.h"
+#include "NetworkService.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QFileInfo>
+#include <QDebug>
+#include <cstdio>
+#include <cstring>
+
+ChatCli::ChatCli(QObject *parent)
+    : QObject(parent)
+    , m_out(stdout)
+    , m_err(stderr)
+{
+}
+
+ChatCli::~ChatCli() = default;
+
+bool ChatCli::requested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--cli") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int ChatCli::run(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    
+    // Same identity as the GUI, so settings, cache and app data are shared
+    app.setApplicationName("Chatty");
+    app.setApplicationVersion("1.0.0");
+    app.setOrganizationName("Chatty Team");
+    app.setOrganizationDomain("chatty.ai");
+    
+    ChatCli cli;
+    if (!cli.start(app.arguments())) {
+        return cli.exitCode();
+    }
+    return app.exec();
+}
+
+bool ChatCli::start(const QStringList& arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Send a prompt to a model and stream the reply to stdout.");
+    parser.addHelpOption();
+    parser.addVersionOption();
+    
+    QCommandLineOption cliOption("cli", "Run without the GUI.");
+    QCommandLineOption modelOption({"m", "model"}, "Model to ask (default: the selected model).", "id");
+    QCommandLineOption systemOption({"s", "system"}, "System prompt.", "text");
+    QCommandLineOption attachOption({"a", "attach"}, "Attach a file; may be repeated.", "file");
+    QCommandLineOption conversationOption({"c", "conversation"}, "Continue a saved conversation.", "file");
+    QCommandLineOption saveOption("save", "Save the conversation, with the reply, to this file.", "file");
+    QCommandLineOption temperatureOption({"t", "temperature"}, "Sampling temperature.", "value");
+    QCommandLineOption batchOption("batch", "Run every prompt in a JSONL file instead.", "file");
+    QCommandLineOption outputOption({"o", "output"}, "Batch results (default: <batch>.results.jsonl).", "file");
+    QCommandLineOption jobsOption({"j", "jobs"}, "Batch requests in flight at once.", "count");
+    parser.addOptions({cliOption, modelOption, systemOption, attachOption, conversationOption, saveOption,
+                       temperatureOption, batchOption, outputOption, jobsOption});
+    parser.addPositionalArgument("prompt", "Prompt text; read from stdin when omitted or \"-\".", "[prompt...]");
+    
+    if (!parser.parse(arguments)) {
+        m_err << "chatty: " << parser.errorText() << "\n" << parser.helpText();
+        m_exitCode = 2;
+        return false;
+    }
+    if (parser.isSet("help")) {
+        m_out << parser.helpText();
+        return false;
+    }
+    if (parser.isSet("version")) {
+        m_out << QCoreApplication::applicationName() << " " << QCoreApplication::applicationVersion() << "\n";
+        return false;
+    }
+    
+    m_settings = std::make_unique<Settings>(this);
+    if (!m_settings->Load()) {
+        qWarning() << "Failed to load settings, using defaults";
+    }
+    
+    m_networkService = std::make_unique<NetworkService>(this);
+    m_api = std::make_unique<OpenRouterAPI>(m_networkService.get(), this);
+    m_fileManager = std::make_unique<FileManager>(m_networkService.get(), this);
+    configureApi(m_settings->GetSettings());
+    
+    if (parser.isSet(modelOption)) {
+        m_api->setModel(parser.value(modelOption));
+    }
+    if (parser.isSet(temperatureOption)) {
+        bool ok = false;
+        const double temperature = parser.value(temperatureOption).toDouble(&ok);
+        if (!ok) {
+            m_err << "chatty: invalid temperature: " << parser.value(temperatureOption) << "\n";
+            m_exitCode = 2;
+            return false;
+        }
+        m_api->setTemperature(temperature);
+    }
+    
+    if (parser.isSet(batchOption)) {
+        const int concurrency = parser.isSet(jobsOption)
+            ? parser.value(jobsOption).toInt()
+            : m_settings->GetSettings().batchConcurrency;
+        return startBatch(parser.value(batchOption), parser.value(outputOption), concurrency);
+    }
+    
+    if (!buildConversation(parser.positionalArguments(), parser.value(systemOption),
+                           parser.value(conversationOption), parser.values(attachOption))) {
+        return false;
+    }
+    m_savePath = parser.value(saveOption);
+    
+    connect(m_api.get(), &OpenRouterAPI::streamReceived, this, &ChatCli::onStreamReceived);
+    connect(m_api.get(), &OpenRouterAPI::streamError, this, &ChatCli::onStreamError);
+    connect(m_api.get(), &OpenRouterAPI::streamCompleted, this, &ChatCli::onStreamCompleted);
+    m_requestId = m_api->sendMessage(m_conversation);
+    return true;
+}
+
+void ChatCli::configureApi(const AppSettings& settings)
+{
+    // Last known catalogue gives context windows and prices without a round
+    // trip; the request goes out right after, so wait for it
+    m_api->setCacheDirectory(m_fileManager->getCachePath(), true);
+    
+    // Every delta goes straight to stdout
+    m_api->setStreamFlushInterval(0);
+    m_api->setOutputReserve(settings.responseTokenReserve);
+    m_api->setRequestTimeout(settings.requestTimeout);
+    m_api->setStallTimeout(settings.streamStallTimeout);
+    m_api->setMaxRetries(settings.maxRetries);
+    m_api->setRateLimits(settings.rateLimitPerMinute, settings.modelRateLimitPerMinute);
+    m_api->setPromptCachingEnabled(settings.enablePromptCaching);
+    m_api->setTemperature(settings.temperature);
+    m_api->setResponseCacheEnabled(settings.enableResponseCache, settings.cacheSampledResponses);
+    m_api->setResponseCacheSize(qint64(settings.responseCacheSizeMB) * 1024 * 1024);
+    m_api->setLatencyLogPath(settings.latencyLogPath);
+    
+    m_api->setBaseURL(settings.baseURL);
+    m_api->setBackends(settings.backends);
+    if (!settings.apiKey.isEmpty()) {
+        m_api->setAPIKey(settings.apiKey);
+    }
+    m_api->setModel(settings.selectedModel);
+}
+
+bool ChatCli::buildConversation(const QStringList& prompt, const QString& systemPrompt,
+                                const QString& conversationPath, const QStringList& attachments)
+{
+    if (!conversationPath.isEmpty() && !m_fileManager->loadConversation(conversationPath, m_conversation)) {
+        m_err << "chatty: cannot read conversation " << conversationPath << "\n";
+        m_exitCode = 1;
+        return false;
+    }
+    if (!systemPrompt.isEmpty()) {
+        // Replaces the system prompt of a loaded conversation rather than adding a second one
+        if (!m_conversation.empty() && m_conversation.front().isSystemMessage()) {
+            m_conversation.front().setContent(systemPrompt);
+        } else {
+            m_conversation.insert(m_conversation.begin(), Message(systemPrompt, MessageRole::System));
+        }
+    }
+    
+    // Piped input is read whole; a prompt is short next to the round trip
+    QString text = prompt.join(' ');
+    if (prompt.isEmpty() || text == "-") {
+        QFile input;
+        if (input.open(stdin, QIODevice::ReadOnly)) {
+            text = QString::fromUtf8(input.readAll());
+        }
+    }
+    
+    Message userMessage(text.trimmed(), MessageRole::User);
+    for (const QString& path : attachments) {
+        auto attachment = m_fileManager->createAttachment(path);
+        if (!attachment) {
+            m_err << "chatty: cannot attach " << path << "\n";
+            m_exitCode = 1;
+            return false;
+        }
+        userMessage.addAttachment(attachment);
+    }
+    
+    // A saved conversation may already end with the question
+    if (!userMessage.content.isEmpty() || !userMessage.attachments.empty()) {
+        m_conversation.push_back(userMessage);
+    } else if (m_conversation.empty() || !m_conversation.back().isFromUser()) {
+        m_err << "chatty: no prompt given\n";
+        m_exitCode = 2;
+        return false;
+    }
+    return true;
+}
+
+bool ChatCli::startBatch(const QString& inputPath, const QString& outputPath, int concurrency)
+{
+    QString resultsPath = outputPath;
+    if (resultsPath.isEmpty()) {
+        const QFileInfo info(inputPath);
+        resultsPath = info.absolutePath() + "/" + info.completeBaseName() + ".results.jsonl";
+    }
+    
+    m_batchRunner = std::make_unique<BatchRunner>(m_api.get(), this);
+    m_batchRunner->setMaxConcurrent(concurrency);
+    connect(m_batchRunner.get(), &BatchRunner::itemFinished, this, [this](const QString& itemId, bool success) {
+        const BatchStats stats = m_batchRunner->stats();
+        m_err << (success ? "ok     " : "failed ") << itemId
+              << "  (" << stats.completed() << " done, " << stats.inFlight << " running)\n";
+        m_err.flush();
+    });
+    connect(m_batchRunner.get(), &BatchRunner::finished, this, &ChatCli::onBatchFinished);
+    
+    if (!m_batchRunner->start(inputPath, resultsPath)) {
+        m_err << "chatty: " << m_batchRunner->errorString() << "\n";
+        m_exitCode = 1;
+        return false;
+    }
+    return true;
+}
+
+void ChatCli::onStreamReceived(RequestId requestId, const QString& content)
+{
+    if (requestId != m_requestId) return;
+    
+    m_reply += content;
+    m_out << content;
+    m_out.flush();
+}
+
+void ChatCli::onStreamError(RequestId requestId, const QString& error)
+{
+    if (requestId != m_requestId) return;
+    
+    m_failed = true;
+    m_err << "chatty: " << error << "\n";
+    m_err.flush();
+}
+
+void ChatCli::onStreamCompleted(RequestId requestId, bool success)
+{
+    if (requestId != m_requestId) return;
+    
+    if (!m_reply.isEmpty() && !m_reply.endsWith('\n')) {
+        m_out << "\n";
+        m_out.flush();
+    }
+    
+    success = success && !m_failed;
+    if (success && !m_savePath.isEmpty()) {
+        m_conversation.emplace_back(m_reply, MessageRole::Assistant);
+        if (!m_fileManager->saveConversation(m_savePath, m_conversation)) {
+            m_err << "chatty: cannot save conversation to " << m_savePath << "\n";
+            success = false;
+        }
+    }
+    finish(success ? 0 : 1);
+}
+
+void ChatCli::onBatchFinished(const BatchStats& stats)
+{
+    m_err << QString("%1 succeeded, %2 failed, %3 skipped in %4 s (%5 items/min, %6 tokens/s)\n")
+        .arg(stats.succeeded)
+        .arg(stats.failed)
+        .arg(stats.skipped)
+        .arg(stats.elapsedMs / 1000.0, 0, 'f', 1)
+        .arg(stats.itemsPerMinute(), 0, 'f', 1)
+        .arg(stats.tokensPerSecond(), 0, 'f', 1);
+    m_err.flush();
+    finish(stats.failed > 0 ? 1 : 0);
+}
+
+void ChatCli::finish(int exitCode)
+{
+    m_exitCode = exitCode;
+    
+    // Queued: a batch with nothing left to run finishes before exec() starts
+    QMetaObject::invokeMethod(QCoreApplication::instance(), [exitCode]() {
+        QCoreApplication::exit(exitCode);
+    }, Qt::QueuedConnection);
+}
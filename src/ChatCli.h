@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Message.h"
+#include "ChatNetworkCore.h"
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+#include <memory>
+#include <vector>
+
+class Settings;
+class NetworkService;
+class OpenRouterAPI;
+class FileManager;
+class BatchRunner;
+struct BatchStats;
+struct AppSettings;
+
+// Headless front end for `chatty --cli`: sends one prompt (or a batch file)
+// through the same OpenRouterAPI, Settings and FileManager the window uses,
+// and streams the reply to stdout as it arrives. Runs on QCoreApplication,
+// so no windowing system, platform plugin or style is initialized, and the
+// model list is taken from the on-disk cache rather than fetched.
+class ChatCli : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ChatCli(QObject *parent = nullptr);
+    ~ChatCli();
+    
+    // True when argv asks for headless mode; checked before any application object exists
+    static bool requested(int argc, char *argv[]);
+    static int run(int argc, char *argv[]);
+    
+    // Parses the arguments and sends the request. False when there is
+    // nothing left to wait for (help, usage errors); exitCode() says how it ended.
+    bool start(const QStringList& arguments);
+    int exitCode() const { return m_exitCode; }
+
+private slots:
+    void onStreamReceived(RequestId requestId, const QString& content);
+    void onStreamError(RequestId requestId, const QString& error);
+    void onStreamCompleted(RequestId requestId, bool success);
+    void onBatchFinished(const BatchStats& stats);
+
+private:
+    void configureApi(const AppSettings& settings);
+    bool buildConversation(const QStringList& prompt, const QString& systemPrompt,
+                           const QString& conversationPath, const QStringList& attachments);
+    bool startBatch(const QString& inputPath, const QString& outputPath, int concurrency);
+    void finish(int exitCode);
+    
+    std::unique_ptr<Settings> m_settings;
+    std::unique_ptr<NetworkService> m_networkService;
+    std::unique_ptr<OpenRouterAPI> m_api;
+    std::unique_ptr<FileManager> m_fileManager;
+    std::unique_ptr<BatchRunner> m_batchRunner;
+    
+    QTextStream m_out;
+    QTextStream m_err;
+    
+    std::vector<Message> m_conversation;
+    QString m_reply;
+    QString m_savePath;
+    RequestId m_requestId = 0;
+    bool m_failed = false;
+    int m_exitCode = 0;
+};
@@ -0,0 +1,686 @@
+#include "ChatNetworkCore.h"
+#include <QMutexLocker>
+#include <QRandomGenerator>
+#include <QUrl>
+#include <QDebug>
+
+namespace {
+
+qint64 steadyNowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+ChatNetworkCore::ChatNetworkCore(QObject *parent)
+    : QObject(parent)
+{
+    // Watches active streams for a missing first byte or a stall
+    m_streamTimer = new QTimer(this);
+    m_streamTimer->setSingleShot(false);
+    m_streamTimer->setInterval(WATCHDOG_INTERVAL_MS);
+    connect(m_streamTimer, &QTimer::timeout, this, &ChatNetworkCore::onStreamWatchdog);
+    
+    // Admits chat requests under the key and model rate limits
+    m_scheduler = new RequestScheduler(this);
+    connect(m_scheduler, &RequestScheduler::dispatched, this, &ChatNetworkCore::onRequestDispatched);
+    connect(m_scheduler, &RequestScheduler::queued, this, [this](quint64 requestId, int waitMs, const QString& reason) {
+        if (StreamState* stream = m_streams.value(requestId, nullptr)) {
+            stream->wasQueued = true;
+        }
+        emit requestQueued(requestId, waitMs, reason);
+    });
+    
+    // Deltas leave this thread at most once per display frame
+    m_coalescer = new StreamCoalescer(this);
+    connect(m_coalescer, &StreamCoalescer::flushed, this, [this](quint64 requestId, const QString& text) {
+        const StreamState* stream = m_streams.value(requestId, nullptr);
+        emit deltaReady(requestId, text, stream ? stream->tokenCount : 0);
+    });
+    
+    // Keep the TLS connection to the endpoint warm between requests
+    m_keepAliveTimer = new QTimer(this);
+    m_keepAliveTimer->setInterval(KEEP_ALIVE_CHECK_MS);
+    connect(m_keepAliveTimer, &QTimer::timeout, this, &ChatNetworkCore::onKeepAliveTimer);
+}
+
+ChatNetworkCore::~ChatNetworkCore()
+{
+    for (StreamState* stream : std::as_const(m_streams)) {
+        if (stream->reply) {
+            stream->reply->disconnect(this);
+            stream->reply->abort();
+            stream->reply->deleteLater();
+        }
+        delete stream;
+    }
+    m_streams.clear();
+}
+
+void ChatNetworkCore::initialize()
+{
+    // QNetworkAccessManager and its replies belong to the thread that creates them
+    if (!m_network) {
+        m_network = new NetworkService(this);
+        connect(m_network, &NetworkService::statsChanged, this, [this]() {
+            QMutexLocker locker(&m_statsMutex);
+            m_networkStats = m_network->stats();
+        });
+    }
+}
+
+ConnectionStats ChatNetworkCore::connectionStats() const
+{
+    QMutexLocker locker(&m_statsMutex);
+    return m_connectionStats;
+}
+
+ReliabilityStats ChatNetworkCore::reliabilityStats() const
+{
+    QMutexLocker locker(&m_statsMutex);
+    return m_reliabilityStats;
+}
+
+NetworkStats ChatNetworkCore::networkStats() const
+{
+    QMutexLocker locker(&m_statsMutex);
+    return m_networkStats;
+}
+
+void ChatNetworkCore::setFlushInterval(int milliseconds)
+{
+    m_coalescer->setFlushInterval(milliseconds);
+}
+
+void ChatNetworkCore::setRequestTimeout(int seconds)
+{
+    m_requestTimeoutSeconds = qMax(1, seconds);
+}
+
+void ChatNetworkCore::setStallTimeout(int seconds)
+{
+    m_stallTimeoutSeconds = qMax(1, seconds);
+}
+
+void ChatNetworkCore::setMaxRetries(int retries)
+{
+    m_maxRetries = qMax(0, retries);
+}
+
+void ChatNetworkCore::setRateLimits(int requestsPerMinute, int requestsPerMinutePerModel)
+{
+    m_scheduler->setKeyRateLimit(requestsPerMinute);
+    m_scheduler->setModelRateLimit(requestsPerMinutePerModel);
+}
+
+void ChatNetworkCore::setTokenizer(std::shared_ptr<const Tokenizer> tokenizer)
+{
+    m_tokenizer = std::move(tokenizer);
+}
+
+void ChatNetworkCore::setEndpoint(const QString& baseUrl)
+{
+    if (m_baseURL == baseUrl) return;
+    
+    m_baseURL = baseUrl;
+    m_connectionOpened = false;
+    prewarm();
+}
+
+void ChatNetworkCore::setKeepWarm(bool enabled)
+{
+    m_keepWarm = enabled;
+    if (enabled) {
+        m_lastUserActivity = std::chrono::steady_clock::now();
+        prewarm();
+        m_keepAliveTimer->start();
+    } else {
+        m_keepAliveTimer->stop();
+    }
+}
+
+void ChatNetworkCore::prewarm()
+{
+    if (!m_keepWarm || !m_network) return;
+    
+    QUrl url(m_baseURL);
+    if (!url.isValid() || url.host().isEmpty()) return;
+    
+    // Pay DNS, TCP and TLS setup now instead of on the first token
+    m_network->prewarm(url);
+    
+    m_connectionOpened = true;
+    markNetworkActivity();
+}
+
+bool ChatNetworkCore::isConnectionWarm() const
+{
+    if (!m_connectionOpened) return false;
+    
+    return steadyNowMs() - m_lastNetworkActivityMs.load() < CONNECTION_IDLE_SECONDS * 1000;
+}
+
+void ChatNetworkCore::onKeepAliveTimer()
+{
+    if (!m_streams.isEmpty()) {
+        markNetworkActivity();
+        return;
+    }
+    
+    auto now = std::chrono::steady_clock::now();
+    if (now - m_lastUserActivity > std::chrono::seconds(KEEP_WARM_WINDOW_SECONDS)) {
+        return; // Let the connection lapse once the user has gone away
+    }
+    
+    if (!isConnectionWarm()) {
+        prewarm();
+    }
+}
+
+void ChatNetworkCore::markNetworkActivity()
+{
+    m_lastNetworkActivityMs = steadyNowMs();
+}
+
+void ChatNetworkCore::start(const ChatRequest& request)
+{
+    initialize();
+    
+    auto* stream = new StreamState;
+    stream->id = request.id;
+    stream->modelId = request.modelId;
+    stream->priority = request.priority;
+    stream->backend = request.backend;
+    stream->framing = request.backend ? request.backend->capabilities().framing : StreamFraming::ServerSentEvents;
+    stream->requestTimeoutSeconds = request.requestTimeoutSeconds;
+    stream->startTime = request.startTime;
+    stream->request = request.request;
+    stream->payload = request.payload;
+    stream->promptTokens = request.promptTokens;
+    stream->costPerToken = request.costPerToken;
+    stream->completionCostPerToken = request.completionCostPerToken;
+    stream->timeline.requestId = request.id;
+    stream->timeline.modelId = request.modelId;
+    stream->timeline.queuedAt = request.queuedAt;
+    stream->expectedWarm = isConnectionWarm();
+    m_lastUserActivity = std::chrono::steady_clock::now();
+    m_streams.insert(request.id, stream);
+    
+    // Starts now, or once the rate limits allow it
+    m_scheduler->submit(request.id, backendId(stream), stream->modelId, stream->priority);
+}
+
+void ChatNetworkCore::startAttempt(StreamState* stream)
+{
+    const RequestId requestId = stream->id;
+    
+    stream->attemptStart = std::chrono::steady_clock::now();
+    stream->lastByteTime = stream->attemptStart;
+    stream->receivedBytes = false;
+    stream->timedOut = false;
+    stream->tlsHandshakeSeen = false;
+    
+    // Connection and response phases describe the latest attempt
+    RequestTimeline& timeline = stream->timeline;
+    timeline.attempts = stream->attempt + 1;
+    timeline.connectStartMs = -1;
+    timeline.tlsDoneMs = -1;
+    timeline.requestSentMs = -1;
+    timeline.headersMs = -1;
+    timeline.firstByteMs = -1;
+    
+    stream->reply = m_network->post(stream->request, stream->payload, stream->priority);
+    stream->reply->setProperty("requestId", requestId);
+    
+    connect(stream->reply, &QNetworkReply::readyRead, this, &ChatNetworkCore::onChatReplyReadyRead);
+    connect(stream->reply, &QNetworkReply::encrypted, this, [this, requestId]() {
+        // Only emitted when this request had to perform its own TLS handshake
+        if (StreamState* state = m_streams.value(requestId, nullptr)) {
+            state->tlsHandshakeSeen = true;
+            state->timeline.tlsDoneMs = sinceQueued(state);
+        }
+    });
+    connect(stream->reply, &QNetworkReply::metaDataChanged, this, [this, requestId]() {
+        StreamState* state = m_streams.value(requestId, nullptr);
+        if (state && state->timeline.headersMs < 0) {
+            state->timeline.headersMs = sinceQueued(state);
+        }
+    });
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    // Only emitted when no pooled connection could be reused
+    connect(stream->reply, &QNetworkReply::socketStartedConnecting, this, [this, requestId]() {
+        if (StreamState* state = m_streams.value(requestId, nullptr)) {
+            state->timeline.connectStartMs = sinceQueued(state);
+        }
+    });
+    connect(stream->reply, &QNetworkReply::requestSent, this, [this, requestId]() {
+        if (StreamState* state = m_streams.value(requestId, nullptr)) {
+            state->timeline.requestSentMs = sinceQueued(state);
+        }
+    });
+#endif
+    connect(stream->reply, &QNetworkReply::finished, this, &ChatNetworkCore::onChatReplyFinished);
+    connect(stream->reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::errorOccurred),
+            this, &ChatNetworkCore::onNetworkError);
+    
+    if (!m_streamTimer->isActive()) {
+        m_streamTimer->start();
+    }
+}
+
+bool ChatNetworkCore::shouldRetry(const StreamState* stream, QNetworkReply* reply) const
+{
+    // Never replay once any part of the answer has been shown
+    if (stream->cancelled || stream->errorReported || stream->firstTokenSeen) return false;
+    if (stream->attempt >= m_maxRetries) return false;
+    if (stream->timedOut) return true;
+    
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status == 429 || status == 500 || status == 502 || status == 503 || status == 504) return true;
+    if (status >= 400) return false;
+    
+    switch (reply->error()) {
+        case QNetworkReply::ConnectionRefusedError:
+        case QNetworkReply::RemoteHostClosedError:
+        case QNetworkReply::TimeoutError:
+        case QNetworkReply::TemporaryNetworkFailureError:
+        case QNetworkReply::NetworkSessionFailedError:
+        case QNetworkReply::ProxyConnectionClosedError:
+        case QNetworkReply::ProxyTimeoutError:
+        case QNetworkReply::UnknownNetworkError:
+            return true;
+        default:
+            return false;
+    }
+}
+
+int ChatNetworkCore::retryDelay(int attempt) const
+{
+    // Exponential backoff with equal jitter: half fixed, half random
+    const int delay = qMin(RETRY_MAX_DELAY_MS, RETRY_BASE_DELAY_MS << qMin(attempt, 10));
+    return delay / 2 + static_cast<int>(QRandomGenerator::global()->bounded(delay / 2 + 1));
+}
+
+void ChatNetworkCore::scheduleRetry(StreamState* stream, QNetworkReply* reply)
+{
+    const RequestId requestId = stream->id;
+    
+    // A server-requested delay wins over our own backoff
+    int delayMs = retryDelay(stream->attempt);
+    if (!stream->timedOut) {
+        delayMs = static_cast<int>(qMax<qint64>(delayMs, RequestScheduler::retryAfterMs(reply)));
+    }
+    const QString reason = stream->timedOut ? stream->timeoutReason : reply->errorString();
+    
+    ++stream->attempt;
+    {
+        QMutexLocker locker(&m_statsMutex);
+        ++m_reliabilityStats.retries;
+    }
+    qWarning() << "Retrying request" << requestId << "in" << delayMs << "ms:" << reason;
+    
+    // Start the next attempt from a clean slate
+    reply->disconnect(this);
+    reply->deleteLater();
+    stream->reply = nullptr;
+    stream->parser.reset();
+    stream->lineBuffer.clear();
+    stream->delta = StreamDelta();
+    stream->tokenCount = 0;
+    m_coalescer->discard(requestId);
+    
+    emit requestRetrying(requestId, stream->attempt, delayMs, reason);
+    
+    QTimer::singleShot(delayMs, this, [this, requestId]() {
+        StreamState* pending = m_streams.value(requestId, nullptr);
+        if (pending && !pending->reply && !pending->cancelled) {
+            // Back through the scheduler so retries respect the limits too
+            m_scheduler->submit(requestId, backendId(pending), pending->modelId, pending->priority);
+        }
+    });
+}
+
+void ChatNetworkCore::onRequestDispatched(quint64 requestId)
+{
+    StreamState* stream = m_streams.value(requestId, nullptr);
+    if (!stream || stream->cancelled || stream->reply) return;
+    
+    if (stream->timeline.dispatchedMs < 0) {
+        stream->timeline.dispatchedMs = sinceQueued(stream);
+    }
+    if (stream->wasQueued) {
+        stream->wasQueued = false;
+        emit requestDispatched(requestId);
+    }
+    
+    startAttempt(stream);
+}
+
+void ChatNetworkCore::onStreamWatchdog()
+{
+    const auto now = std::chrono::steady_clock::now();
+    QList<QNetworkReply*> expired;
+    
+    for (StreamState* stream : std::as_const(m_streams)) {
+        if (!stream->reply || stream->cancelled || stream->timedOut) continue;
+    
+        if (!stream->receivedBytes) {
+            // Local servers may need longer to load a model than a hosted API takes to answer
+            const int timeoutSeconds = stream->requestTimeoutSeconds > 0 ? stream->requestTimeoutSeconds
+                                                                         : m_requestTimeoutSeconds;
+            if (now - stream->attemptStart > std::chrono::seconds(timeoutSeconds)) {
+                QMutexLocker locker(&m_statsMutex);
+                ++m_reliabilityStats.firstByteTimeouts;
+                stream->timeoutReason = QString("No response from server after %1 s").arg(timeoutSeconds);
+                stream->timedOut = true;
+                expired.append(stream->reply);
+            }
+        } else if (now - stream->lastByteTime > std::chrono::seconds(m_stallTimeoutSeconds)) {
+            QMutexLocker locker(&m_statsMutex);
+            ++m_reliabilityStats.stalledStreams;
+            stream->timeoutReason = QString("Stream stalled: no data for %1 s").arg(m_stallTimeoutSeconds);
+            stream->timedOut = true;
+            expired.append(stream->reply);
+        }
+    }
+    
+    // Aborting finishes the reply synchronously, which may remove its stream
+    for (QNetworkReply* reply : expired) {
+        reply->abort();
+    }
+    
+    if (m_streams.isEmpty()) {
+        m_streamTimer->stop();
+    }
+}
+
+void ChatNetworkCore::stop(RequestId requestId)
+{
+    StreamState* stream = m_streams.value(requestId, nullptr);
+    if (!stream) return;
+    
+    stream->cancelled = true;
+    if (stream->reply) {
+        stream->reply->abort();
+        return;
+    }
+    
+    // Waiting for a retry or in the rate-limit queue; there is no reply to finish it
+    m_scheduler->cancel(requestId);
+    m_coalescer->discard(requestId);
+    m_streams.remove(requestId);
+    delete stream;
+    emit streamCompleted(requestId, false);
+}
+
+void ChatNetworkCore::stopAll()
+{
+    const QList<RequestId> requestIds = m_streams.keys();
+    for (RequestId requestId : requestIds) {
+        stop(requestId);
+    }
+}
+
+StreamState* ChatNetworkCore::streamForReply(QNetworkReply* reply) const
+{
+    if (!reply) return nullptr;
+    
+    const QVariant requestId = reply->property("requestId");
+    if (!requestId.isValid()) return nullptr;
+    
+    StreamState* stream = m_streams.value(requestId.toULongLong(), nullptr);
+    return (stream && stream->reply == reply) ? stream : nullptr;
+}
+
+QString ChatNetworkCore::backendId(const StreamState* stream)
+{
+    // Rate limits are kept per backend, i.e. per API key
+    return stream->backend ? stream->backend->config().id : QString();
+}
+
+void ChatNetworkCore::onChatReplyFinished()
+{
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    StreamState* stream = streamForReply(reply);
+    if (!stream) return;
+    
+    const RequestId requestId = stream->id;
+    
+    // Dispatch a final event the server did not terminate
+    if (!stream->cancelled) {
+        readStream(stream, reply, true);
+    }
+    
+    // An in-band error chunk fails the request even when the HTTP status was fine
+    bool success = (reply->error() == QNetworkReply::NoError && !stream->cancelled && !stream->errorReported);
+    
+    // Rate-limit headers and Retry-After shape when this and later requests
+    // to the same backend go
+    const bool rateLimitHeaders = stream->backend && stream->backend->capabilities().rateLimitHeaders;
+    m_scheduler->recordResponse(backendId(stream), stream->modelId, reply, rateLimitHeaders);
+    
+    if (!success && shouldRetry(stream, reply)) {
+        scheduleRetry(stream, reply);
+        return;
+    }
+    
+    if (stream->attempt > 0 && !stream->cancelled) {
+        QMutexLocker locker(&m_statsMutex);
+        if (success) {
+            ++m_reliabilityStats.recoveredRequests;
+        } else {
+            ++m_reliabilityStats.failedAfterRetries;
+        }
+    }
+    
+    // Deliver buffered text before the completion so nothing arrives after it
+    if (stream->cancelled) {
+        m_coalescer->discard(requestId);
+    } else {
+        m_coalescer->flush(requestId);
+    }
+    
+    if (!success && !stream->errorReported && stream->timedOut) {
+        emit streamError(requestId, stream->timeoutReason);
+    } else if (!success && !stream->errorReported && reply->error() != QNetworkReply::OperationCanceledError) {
+        QString errorMsg = QString("Request failed: %1").arg(reply->errorString());
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 429) {
+            const qint64 retryAfter = RequestScheduler::retryAfterMs(reply);
+            errorMsg = retryAfter > 0
+                ? QString("Rate limited by the provider; try again in %1 s").arg((retryAfter + 999) / 1000)
+                : QString("Rate limited by the provider; try again shortly");
+        }
+        emit streamError(requestId, errorMsg);
+    }
+    
+    updateTokenStats(stream);
+    recordUsage(stream);
+    
+    RequestTimeline& timeline = stream->timeline;
+    timeline.completedMs = sinceQueued(stream);
+    timeline.connectionReused = timeline.connectStartMs < 0 && !stream->tlsHandshakeSeen;
+    timeline.tokenCount = stream->tokenCount;
+    timeline.promptTokens = stream->promptTokens;
+    timeline.success = success;
+    timeline.httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    emit requestFinished(timeline);
+    
+    if (success && stream->usageReported) {
+        emit promptCacheUsage(requestId, stream->promptTokens, stream->cachedTokens);
+    }
+    markNetworkActivity();
+    m_connectionOpened = (reply->error() == QNetworkReply::NoError);
+    
+    m_streams.remove(requestId);
+    delete stream;
+    reply->deleteLater();
+    
+    emit streamCompleted(requestId, success);
+}
+
+void ChatNetworkCore::onChatReplyReadyRead()
+{
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    StreamState* stream = streamForReply(reply);
+    if (!stream || stream->cancelled) return;
+    
+    markNetworkActivity();
+    if (!stream->receivedBytes) {
+        stream->timeline.firstByteMs = sinceQueued(stream);
+    }
+    stream->receivedBytes = true;
+    stream->lastByteTime = std::chrono::steady_clock::now();
+    readStream(stream, reply, false);
+}
+
+void ChatNetworkCore::readStream(StreamState* stream, QNetworkReply* reply, bool atEnd)
+{
+    SSEEvent event;
+    if (stream->framing == StreamFraming::ServerSentEvents) {
+        stream->parser.readFrom(reply);
+        while (stream->parser.nextEvent(event)) {
+            processStreamEvent(stream, event);
+        }
+        if (atEnd && stream->parser.flush(event)) {
+            processStreamEvent(stream, event);
+        }
+        return;
+    }
+    
+    // NDJSON: each complete line is one chunk, delivered through the same path
+    QByteArray& buffer = stream->lineBuffer;
+    buffer.append(reply->readAll());
+    qsizetype lineStart = 0;
+    qsizetype newline;
+    while ((newline = buffer.indexOf('\n', lineStart)) >= 0) {
+        event.data = buffer.mid(lineStart, newline - lineStart).trimmed();
+        lineStart = newline + 1;
+        if (!event.data.isEmpty()) {
+            processStreamEvent(stream, event);
+        }
+    }
+    buffer.remove(0, lineStart);
+    
+    if (atEnd && !buffer.trimmed().isEmpty()) {
+        event.data = buffer.trimmed();
+        buffer.clear();
+        processStreamEvent(stream, event);
+    }
+}
+
+void ChatNetworkCore::onNetworkError(QNetworkReply::NetworkError error)
+{
+    Q_UNUSED(error)
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply) return;
+    
+    // Reported from onChatReplyFinished, once it is known whether the request will be retried
+    qWarning() << "Network error:" << reply->errorString();
+}
+
+void ChatNetworkCore::processStreamEvent(StreamState* stream, const SSEEvent& event)
+{
+    if (event.isDone()) {
+        // Stream finished
+        return;
+    }
+    
+    StreamDelta& delta = stream->delta;
+    const bool parsed = stream->backend ? stream->backend->parseStreamChunk(event.data, delta)
+                                        : StreamDeltaParser::parse(event.data, delta);
+    if (!parsed) {
+        qWarning() << "Failed to parse stream chunk:" << event.data.left(200);
+        return;
+    }
+    
+    if (!delta.errorMessage.isEmpty()) {
+        stream->errorReported = true;
+        m_coalescer->flush(stream->id);
+        emit streamError(stream->id, delta.errorMessage);
+        return;
+    }
+    
+    if (!delta.finishReason.isEmpty()) {
+        stream->timeline.finishReason = delta.finishReason;
+    }
+    
+    if (!delta.content.isEmpty()) {
+        const auto now = std::chrono::steady_clock::now();
+        if (!stream->firstTokenSeen) {
+            recordFirstToken(stream);
+        } else {
+            stream->timeline.interTokenGapsMs.append(static_cast<qint32>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(now - stream->lastTokenTime).count()));
+        }
+        stream->lastTokenTime = now;
+        // Without a vocabulary each delta is roughly one token
+        const bool counted = m_tokenizer && m_tokenizer->isLoaded();
+        stream->tokenCount += counted ? m_tokenizer->countTokens(delta.content) : 1;
+        updateTokenStats(stream);
+        m_coalescer->append(stream->id, delta.content);
+    }
+    
+    // Update usage statistics if available
+    if (delta.hasUsage && delta.totalTokens > 0) {
+        m_totalTokensUsed = delta.totalTokens;
+        stream->promptTokens = delta.promptTokens;
+        stream->cachedTokens = delta.cachedTokens;
+        stream->usageReported = true;
+        if (delta.completionTokens > 0) {
+            stream->tokenCount = delta.completionTokens;
+        }
+    }
+}
+
+void ChatNetworkCore::updateTokenStats(const StreamState* stream)
+{
+    auto now = std::chrono::steady_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - stream->startTime);
+    
+    if (duration.count() > 0 && stream->tokenCount > 0) {
+        m_tokensPerSecond = (stream->tokenCount * 1000.0) / duration.count();
+    }
+}
+
+void ChatNetworkCore::recordUsage(const StreamState* stream)
+{
+    // Server-reported usage when present, otherwise tokenizer counts. Older
+    // catalogues only carry a prompt price, which then covers both sides.
+    const double completionCost = stream->completionCostPerToken > 0.0
+        ? stream->completionCostPerToken : stream->costPerToken;
+    m_estimatedCost = m_estimatedCost.load() + stream->promptTokens * stream->costPerToken
+        + stream->tokenCount * completionCost;
+}
+
+void ChatNetworkCore::recordFirstToken(StreamState* stream)
+{
+    stream->firstTokenSeen = true;
+    
+    const qint64 elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - stream->startTime).count();
+    
+    // A fresh handshake on this reply means the warm connection was not there to reuse
+    const bool reused = stream->expectedWarm && !stream->tlsHandshakeSeen;
+    
+    {
+        QMutexLocker locker(&m_statsMutex);
+        if (reused) {
+            int n = ++m_connectionStats.warmRequests;
+            m_connectionStats.averageWarmTTFT += (elapsedMs - m_connectionStats.averageWarmTTFT) / n;
+        } else {
+            int n = ++m_connectionStats.coldRequests;
+            m_connectionStats.averageColdTTFT += (elapsedMs - m_connectionStats.averageColdTTFT) / n;
+        }
+    }
+    
+    stream->timeline.firstTokenMs = elapsedMs;
+    emit firstTokenReceived(stream->id, elapsedMs, reused);
+}
+
+qint64 ChatNetworkCore::sinceQueued(const StreamState* stream)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - stream->startTime).count();
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include "ChatBackend.h"
+#include "SSEParser.h"
+#include "StreamDeltaParser.h"
+#include "StreamCoalescer.h"
+#include "NetworkService.h"
+#include "Tokenizer.h"
+#include "RequestTimeline.h"
+#include "RequestScheduler.h"
+#include <QObject>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QTimer>
+#include <QString>
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <memory>
+#include <atomic>
+#include <chrono>
+
+// Handle identifying one in-flight chat completion
+using RequestId = quint64;
+
+// A chat completion ready to go out: the request and payload are built on
+// the caller's thread, everything after that happens in ChatNetworkCore
+struct ChatRequest {
+    RequestId id = 0;
+    QString modelId;
+    NetworkService::Priority priority = NetworkService::Priority::Interactive;
+    std::shared_ptr<const ChatBackend> backend;
+    int requestTimeoutSeconds = 0;   // 0 = the core's setting
+    QNetworkRequest request;
+    QByteArray payload;
+    int promptTokens = 0;       // Estimate until the server reports usage
+    double costPerToken = 0.0;
+    double completionCostPerToken = 0.0;
+    std::chrono::steady_clock::time_point startTime;
+    QDateTime queuedAt;
+};
+
+// Independent state of one streaming chat completion
+struct StreamState {
+    RequestId id = 0;
+    QString modelId;
+    NetworkService::Priority priority = NetworkService::Priority::Interactive;
+    bool wasQueued = false;     // Held back by the rate-limit scheduler
+    std::shared_ptr<const ChatBackend> backend;
+    StreamFraming framing = StreamFraming::ServerSentEvents;
+    QNetworkReply* reply = nullptr;
+    SSEParser parser;
+    QByteArray lineBuffer;      // Partial NDJSON line
+    StreamDelta delta;
+    std::chrono::steady_clock::time_point startTime;
+    int tokenCount = 0;
+    int promptTokens = 0;       // Estimate until the server reports usage
+    int cachedTokens = 0;
+    bool usageReported = false;
+    double costPerToken = 0.0;
+    double completionCostPerToken = 0.0;
+    bool cancelled = false;
+    bool errorReported = false;
+    
+    // Retry and watchdog
+    QNetworkRequest request;
+    QByteArray payload;
+    int attempt = 0;
+    int requestTimeoutSeconds = 0;
+    bool receivedBytes = false;
+    bool timedOut = false;
+    QString timeoutReason;
+    std::chrono::steady_clock::time_point attemptStart;
+    std::chrono::steady_clock::time_point lastByteTime;
+    
+    // Latency breakdown, reported through requestFinished when the request ends
+    RequestTimeline timeline;
+    std::chrono::steady_clock::time_point lastTokenTime;
+    
+    // Connection reuse
+    bool expectedWarm = false;
+    bool tlsHandshakeSeen = false;
+    bool firstTokenSeen = false;
+};
+
+// Retry and watchdog activity since startup
+struct ReliabilityStats {
+    int retries = 0;
+    int recoveredRequests = 0;   // Succeeded after at least one retry
+    int failedAfterRetries = 0;
+    int stalledStreams = 0;      // Went silent after the first byte
+    int firstByteTimeouts = 0;   // Never produced a first byte
+};
+
+// Time-to-first-token split by whether the request found a warm connection
+struct ConnectionStats {
+    int warmRequests = 0;
+    int coldRequests = 0;
+    double averageWarmTTFT = 0.0;
+    double averageColdTTFT = 0.0;
+};
+
+// Streaming half of OpenRouterAPI, run on its own thread so socket reads,
+// SSE splitting and JSON parsing never wait for a repaint (and a busy
+// stream never stalls the GUI). Owns a private NetworkService created on
+// that thread, the rate-limit scheduler, the retry watchdog and the
+// coalescer, so only coalesced text crosses back to the caller. Chat
+// traffic therefore has its own connection pool, separate from the
+// application-wide NetworkService used for the models list and downloads.
+//
+// Call the slots with QMetaObject::invokeMethod; every signal is emitted on
+// the core's thread. The statistics accessors may be called from any thread.
+class ChatNetworkCore : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ChatNetworkCore(QObject *parent = nullptr);
+    ~ChatNetworkCore();
+    
+    // Thread-safe statistics
+    double tokensPerSecond() const { return m_tokensPerSecond.load(); }
+    int totalTokensUsed() const { return m_totalTokensUsed.load(); }
+    double estimatedCost() const { return m_estimatedCost.load(); }
+    ConnectionStats connectionStats() const;
+    ReliabilityStats reliabilityStats() const;
+    NetworkStats networkStats() const;          // Of the core's own connection pool
+    bool isConnectionWarm() const;
+
+public slots:
+    // Creates the network stack; connect to QThread::started
+    void initialize();
+    
+    void start(const ChatRequest& request);
+    void stop(RequestId requestId);
+    void stopAll();
+    
+    // Connection warmth
+    void setEndpoint(const QString& baseUrl);
+    void setKeepWarm(bool enabled);
+    void prewarm();
+    
+    // Configuration
+    void setFlushInterval(int milliseconds);
+    void setRequestTimeout(int seconds);
+    void setStallTimeout(int seconds);
+    void setMaxRetries(int retries);
+    void setRateLimits(int requestsPerMinute, int requestsPerMinutePerModel);
+    void setTokenizer(std::shared_ptr<const Tokenizer> tokenizer);
+
+signals:
+    void deltaReady(RequestId requestId, const QString& content, int tokenCount);
+    void streamCompleted(RequestId requestId, bool success);
+    void streamError(RequestId requestId, const QString& error);
+    void firstTokenReceived(RequestId requestId, qint64 elapsedMs, bool reusedConnection);
+    void requestRetrying(RequestId requestId, int attempt, int delayMs, const QString& reason);
+    void promptCacheUsage(RequestId requestId, int promptTokens, int cachedTokens);
+    void requestQueued(RequestId requestId, int waitMs, const QString& reason);
+    void requestDispatched(RequestId requestId);
+    void requestFinished(const RequestTimeline& timeline);
+
+private slots:
+    void onChatReplyFinished();
+    void onChatReplyReadyRead();
+    void onNetworkError(QNetworkReply::NetworkError error);
+    void onKeepAliveTimer();
+    void onStreamWatchdog();
+    void onRequestDispatched(quint64 requestId);
+
+private:
+    StreamState* streamForReply(QNetworkReply* reply) const;
+    static QString backendId(const StreamState* stream);
+    void startAttempt(StreamState* stream);
+    bool shouldRetry(const StreamState* stream, QNetworkReply* reply) const;
+    void scheduleRetry(StreamState* stream, QNetworkReply* reply);
+    int retryDelay(int attempt) const;
+    void readStream(StreamState* stream, QNetworkReply* reply, bool atEnd);
+    void processStreamEvent(StreamState* stream, const SSEEvent& event);
+    void updateTokenStats(const StreamState* stream);
+    void recordUsage(const StreamState* stream);
+    void recordFirstToken(StreamState* stream);
+    static qint64 sinceQueued(const StreamState* stream);
+    void markNetworkActivity();
+    
+    NetworkService *m_network = nullptr;
+    QTimer *m_streamTimer;
+    StreamCoalescer *m_coalescer;
+    RequestScheduler *m_scheduler;
+    std::shared_ptr<const Tokenizer> m_tokenizer;
+    
+    // Streaming state, keyed by request handle
+    QHash<RequestId, StreamState*> m_streams;
+    
+    // Retry and watchdog
+    int m_requestTimeoutSeconds = 30;
+    int m_stallTimeoutSeconds = 30;
+    int m_maxRetries = 3;
+    
+    static constexpr int WATCHDOG_INTERVAL_MS = 1000;
+    static constexpr int RETRY_BASE_DELAY_MS = 500;
+    static constexpr int RETRY_MAX_DELAY_MS = 8000;
+    
+    // Read from other threads. Only this thread writes, so plain
+    // load/store pairs are enough for the running totals.
+    std::atomic<double> m_tokensPerSecond{0.0};
+    std::atomic<int> m_totalTokensUsed{0};
+    std::atomic<double> m_estimatedCost{0.0};
+    mutable QMutex m_statsMutex;
+    ConnectionStats m_connectionStats;
+    ReliabilityStats m_reliabilityStats;
+    NetworkStats m_networkStats;                // Copied from m_network on each change
+    
+    // Connection warmth
+    QString m_baseURL;
+    QTimer *m_keepAliveTimer;
+    std::atomic<qint64> m_lastNetworkActivityMs{0};   // steady_clock, ms since epoch
+    std::atomic<bool> m_connectionOpened{false};
+    std::chrono::steady_clock::time_point m_lastUserActivity;
+    bool m_keepWarm = false;
+    
+    static constexpr int KEEP_ALIVE_CHECK_MS = 15 * 1000;
+    static constexpr int CONNECTION_IDLE_SECONDS = 50;   // Re-warm before servers drop idle sockets
+    static constexpr int KEEP_WARM_WINDOW_SECONDS = 15 * 60; // Stop re-warming after long inactivity
+};
@@ -3,6 +3,9 @@
 #include "MessageWidget.h"
 #include "MarkdownRenderer.h"
 #include "FileManager.h"
+#include "AttachmentEncoder.h"
+#include "ModelComparisonWidget.h"
+#include "StreamJournal.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -20,6 +23,8 @@
 #include <QFileInfo>
 #include <QApplication>
 #include <QClipboard>
+#include <QThread>
+#include <QStandardPaths>
 
 ChatWidget::ChatWidget(OpenRouterAPI *api, FileManager *fileManager, QWidget *parent)
     : QWidget(parent)
@@ -54,13 +59,34 @@ ChatWidget::ChatWidget(OpenRouterAPI *api, FileManager *fileManager, QWidget *pa
         connect(m_api, &OpenRouterAPI::streamReceived, this, &ChatWidget::onStreamReceived);
         connect(m_api, &OpenRouterAPI::streamCompleted, this, &ChatWidget::onStreamCompleted);
         connect(m_api, &OpenRouterAPI::streamError, this, &ChatWidget::onStreamError);
+        connect(m_api, &OpenRouterAPI::firstTokenReceived, this, &ChatWidget::onFirstTokenReceived);
+        connect(m_api, &OpenRouterAPI::contextTrimmed, this, &ChatWidget::onContextTrimmed);
+        connect(m_api, &OpenRouterAPI::requestRetrying, this, &ChatWidget::onRequestRetrying);
+        connect(m_api, &OpenRouterAPI::promptCacheUsage, this, &ChatWidget::onPromptCacheUsage);
+        connect(m_api, &OpenRouterAPI::requestQueued, this, &ChatWidget::onRequestQueued);
+        connect(m_api, &OpenRouterAPI::requestDispatched, this, &ChatWidget::onRequestDispatched);
+        connect(m_api, &OpenRouterAPI::responseReplayed, this, &ChatWidget::onResponseReplayed);
     }
     
+    // Streaming replies are journalled off the GUI thread
+    m_journalDirectory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/journal";
+    m_journalThread = new QThread(this);
+    m_journalThread->setObjectName("StreamJournal");
+    m_journal = new StreamJournal(m_journalDirectory);
+    m_journal->moveToThread(m_journalThread);
+    connect(m_journalThread, &QThread::finished, m_journal, &QObject::deleteLater);
+    m_journalThread->start();
+    
     // Initialize state
     m_lastStatsUpdate = std::chrono::steady_clock::now();
 }
 
-ChatWidget::~ChatWidget() = default;
+ChatWidget::~ChatWidget()
+{
+    // An unfinished journal is left on disk and recovered on the next start
+    m_journalThread->quit();
+    m_journalThread->wait();
+}
 
 void ChatWidget::setupUI()
 {
@@ -131,6 +157,11 @@ void ChatWidget::setupInputArea()
         }
     });
     
+    m_compareButton = new QPushButton("Compare");
+    m_compareButton->setProperty("class", "secondary-button");
+    m_compareButton->setCheckable(true);
+    m_compareButton->setVisible(false);
+    
     m_sendButton = new QPushButton("Send");
     m_sendButton->setProperty("class", "primary-button");
     m_sendButton->setEnabled(false);
@@ -143,6 +174,7 @@ void ChatWidget::setupInputArea()
     // Assemble input controls
     m_inputControlsLayout->addWidget(m_inputTextEdit, 1);
     m_inputControlsLayout->addWidget(m_attachButton);
+    m_inputControlsLayout->addWidget(m_compareButton);
     m_inputControlsLayout->addWidget(m_sendButton);
     m_inputControlsLayout->addWidget(m_clearButton);
     
@@ -210,8 +242,23 @@ void ChatWidget::addMessage(const Message &message)
 
 void ChatWidget::clearHistory()
 {
+    // Cancel any response still streaming into this conversation
+    if (m_api && m_activeRequestId != 0) {
+        m_api->stopRequest(m_activeRequestId);
+    }
+    m_activeRequestId = 0;
+    finishJournal();
+    endComparison();
+    m_isStreaming = false;
+    m_streamingMessage = nullptr;
+    
     // Clear messages
     m_messages.clear();
+    m_promptTokensSent = 0;
+    m_promptTokensCached = 0;
+    if (m_api) {
+        m_api->clearPayloadCache();
+    }
     
     // Clear message widgets
     for (MessageWidget* widget : m_messageWidgets) {
@@ -346,6 +393,11 @@ void ChatWidget::sendMessage()
         return;
     }
     
+    // A comparison that produced nothing to keep is still on screen
+    if (!m_isStreaming) {
+        endComparison();
+    }
+    
     // Create user message
     Message userMessage(text, MessageRole::User);
     for (auto attachment : m_pendingAttachments) {
@@ -358,6 +410,11 @@ void ChatWidget::sendMessage()
     m_inputTextEdit->clear();
     clearAttachments();
     
+    if (m_compareButton->isChecked() && m_comparisonModels.size() > 1 && m_api) {
+        startComparison();
+        return;
+    }
+    
     // Create assistant message for streaming
     m_currentMessage = Message("", MessageRole::Assistant);
     m_currentMessage.startStreaming();
@@ -366,8 +423,21 @@ void ChatWidget::sendMessage()
     // Add placeholder for assistant response
     addMessage(m_currentMessage);
     
+    // Journal the reply as it streams so a crash cannot lose it; the
+    // journal thread encodes the history from this shared snapshot
+    m_journalReplyId = m_currentMessage.id;
+    auto history = std::make_shared<const std::vector<Message>>(m_messages.begin(), m_messages.end() - 1);
+    StreamJournal* journal = m_journal;
+    const QString replyId = m_journalReplyId;
+    const QString modelId = m_api ? m_api->model() : QString();
+    QMetaObject::invokeMethod(journal, [journal, replyId, history, modelId]() {
+        journal->begin(replyId, history, modelId);
+    }, Qt::QueuedConnection);
+    
     // Update UI state
     m_isStreaming = true;
+    m_contextNotice.clear();
+    m_typingIndicator->setToolTip(QString());
     m_typingIndicator->setText("AI is thinking...");
     m_typingIndicator->setVisible(true);
     m_streamProgress->setVisible(true);
@@ -376,7 +446,7 @@ void ChatWidget::sendMessage()
     
     // Send to API
     if (m_api) {
-        m_api->sendMessage(m_messages);
+        m_activeRequestId = m_api->sendMessage(m_messages);
     }
 }
 
@@ -388,13 +458,28 @@ void ChatWidget::onInputTextChanged()
     m_typingTimer->start(500);
 }
 
-void ChatWidget::onStreamReceived(const QString &content)
+void ChatWidget::onStreamReceived(RequestId requestId, const QString &content)
 {
+    if (m_comparison && m_comparison->contains(requestId)) {
+        m_comparison->appendContent(requestId, content, m_api->streamTokenCount(requestId));
+        return;
+    }
+    
+    if (requestId != m_activeRequestId) return;
     if (!m_isStreaming || !m_streamingMessage) return;
     
+    if (!m_journalReplyId.isEmpty()) {
+        StreamJournal* journal = m_journal;
+        const QString replyId = m_journalReplyId;
+        QMetaObject::invokeMethod(journal, [journal, replyId, content]() {
+            journal->append(replyId, content);
+        }, Qt::QueuedConnection);
+    }
+    
     // Update the streaming message
     m_streamingMessage->content += content;
-    m_streamingMessage->updateStreaming(m_streamingMessage->content);
+    m_streamingMessage->updateStreaming(m_streamingMessage->content,
+                                        m_api ? m_api->streamTokenCount(requestId) : -1);
     
     // Update the message widget
     if (!m_messageWidgets.empty()) {
@@ -412,11 +497,30 @@ void ChatWidget::onStreamReceived(const QString &content)
     emit tokenStatsChanged(getTotalTokens(), getAverageTokensPerSecond());
 }
 
-void ChatWidget::onStreamCompleted(bool success)
+void ChatWidget::onStreamCompleted(RequestId requestId, bool success)
 {
+    if (m_comparison && m_comparison->contains(requestId)) {
+        m_comparison->complete(requestId, success);
+        if (m_comparison->isFinished()) {
+            m_streamProgress->setVisible(false);
+            if (m_comparison->hasKeepableCandidate()) {
+                m_typingIndicator->setText("All models finished - keep one answer to continue");
+            } else {
+                // Nothing to keep; the failed columns stay visible until dismissed or the next send
+                m_isStreaming = false;
+                m_typingIndicator->setVisible(false);
+                updateSendButton();
+            }
+        }
+        return;
+    }
+    
+    if (requestId != m_activeRequestId) return;
     if (!m_isStreaming) return;
     
     m_isStreaming = false;
+    m_activeRequestId = 0;
+    finishJournal();
     m_typingIndicator->setVisible(false);
     m_streamProgress->setVisible(false);
     updateSendButton();
@@ -443,9 +547,17 @@ void ChatWidget::onStreamCompleted(bool success)
     emit tokenStatsChanged(getTotalTokens(), getAverageTokensPerSecond());
 }
 
-void ChatWidget::onStreamError(const QString &error)
+void ChatWidget::onStreamError(RequestId requestId, const QString &error)
 {
+    if (m_comparison && m_comparison->contains(requestId)) {
+        m_comparison->setError(requestId, error);
+        return;
+    }
+    
+    if (requestId != m_activeRequestId) return;
+    
     m_isStreaming = false;
+    finishJournal();
     m_typingIndicator->setText(QString("Error: %1").arg(error));
     m_streamProgress->setVisible(false);
     updateSendButton();
@@ -461,6 +573,213 @@ void ChatWidget::onStreamError(const QString &error)
     });
 }
 
+void ChatWidget::onFirstTokenReceived(RequestId requestId, qint64 elapsedMs, bool reusedConnection)
+{
+    if (m_comparison && m_comparison->contains(requestId)) {
+        m_comparison->setFirstToken(requestId, elapsedMs);
+        return;
+    }
+    
+    if (requestId != m_activeRequestId) return;
+    if (m_streamingMessage && m_streamingMessage->fromCache) return;
+    
+    m_typingIndicator->setText(QString("Responding... (first token in %1 ms, %2 connection)%3")
+        .arg(elapsedMs)
+        .arg(reusedConnection ? "warm" : "new")
+        .arg(m_contextNotice.isEmpty() ? QString() : " - " + m_contextNotice));
+}
+
+void ChatWidget::onContextTrimmed(RequestId requestId, int droppedMessages, int elidedImages, int estimatedTokens)
+{
+    if (requestId != m_activeRequestId) return;
+    
+    QStringList parts;
+    if (droppedMessages > 0) {
+        parts.append(QString("%1 older message%2 left out").arg(droppedMessages).arg(droppedMessages == 1 ? "" : "s"));
+    }
+    if (elidedImages > 0) {
+        parts.append(QString("%1 older image%2 omitted").arg(elidedImages).arg(elidedImages == 1 ? "" : "s"));
+    }
+    m_contextNotice = parts.join(", ") + " to fit the model's context";
+    
+    m_typingIndicator->setText("AI is thinking... (" + m_contextNotice + ")");
+    m_typingIndicator->setToolTip(QString("About %1 tokens of history were sent").arg(estimatedTokens));
+}
+
+void ChatWidget::onRequestRetrying(RequestId requestId, int attempt, int delayMs, const QString &reason)
+{
+    if (requestId != m_activeRequestId) return;
+    
+    m_typingIndicator->setText(QString("Connection problem, retrying in %1 s (attempt %2)...")
+        .arg(QString::number(delayMs / 1000.0, 'f', 1))
+        .arg(attempt));
+    m_typingIndicator->setToolTip(reason);
+}
+
+void ChatWidget::onRequestQueued(RequestId requestId, int waitMs, const QString &reason)
+{
+    if (requestId != m_activeRequestId) return;
+    
+    m_typingIndicator->setText(waitMs > 0
+        ? QString("Waiting for rate limit (%1 s)...").arg((waitMs + 999) / 1000)
+        : QString("Waiting for rate limit..."));
+    m_typingIndicator->setToolTip(reason);
+}
+
+void ChatWidget::onRequestDispatched(RequestId requestId)
+{
+    if (requestId != m_activeRequestId) return;
+    
+    m_typingIndicator->setText("AI is thinking...");
+    m_typingIndicator->setToolTip(QString());
+}
+
+void ChatWidget::onResponseReplayed(RequestId requestId, const QDateTime &cachedAt)
+{
+    if (requestId != m_activeRequestId || !m_streamingMessage) return;
+    
+    m_streamingMessage->fromCache = true;
+    m_typingIndicator->setText("Replayed from response cache");
+    m_typingIndicator->setToolTip(QString("Reply saved %1; no request was sent")
+        .arg(cachedAt.toString("yyyy-MM-dd hh:mm")));
+}
+
+void ChatWidget::onPromptCacheUsage(RequestId requestId, int promptTokens, int cachedTokens)
+{
+    if (requestId != m_activeRequestId || promptTokens <= 0) return;
+    
+    m_promptTokensSent += promptTokens;
+    m_promptTokensCached += cachedTokens;
+    updateTokenStats();
+}
+
+void ChatWidget::finishJournal()
+{
+    if (m_journalReplyId.isEmpty()) return;
+    
+    StreamJournal* journal = m_journal;
+    const QString replyId = m_journalReplyId;
+    QMetaObject::invokeMethod(journal, [journal, replyId]() {
+        journal->finish(replyId);
+    }, Qt::QueuedConnection);
+    m_journalReplyId.clear();
+}
+
+int ChatWidget::recoverInterruptedResponses()
+{
+    std::vector<RecoveredStream> recovered = StreamJournal::recover(m_journalDirectory);
+    if (recovered.empty()) return 0;
+    
+    // Older interruptions are saved as conversation files; the newest one
+    // is opened here when nothing else is on screen
+    const bool openNewest = m_messages.empty() && !m_isStreaming;
+    for (size_t i = 0; i < recovered.size(); ++i) {
+        const RecoveredStream& stream = recovered[i];
+        const bool isNewest = (i + 1 == recovered.size());
+        
+        if (isNewest && openNewest) {
+            for (const Message& message : stream.messages) {
+                addMessage(message);
+            }
+            StreamJournal::removeJournal(stream.journalPath);
+            continue;
+        }
+        
+        if (!m_fileManager) continue;
+        const QString filename = QString("%1/recovered_%2_%3.json")
+            .arg(m_fileManager->getConversationsPath())
+            .arg(stream.startedAt.toString("yyyyMMdd_HHmmss"))
+            .arg(i);
+        if (m_fileManager->saveConversation(filename, stream.messages)) {
+            StreamJournal::removeJournal(stream.journalPath);
+        }
+    }
+    
+    m_typingIndicator->setText(recovered.size() == 1
+        ? QString("Recovered an interrupted response")
+        : QString("Recovered %1 interrupted responses").arg(recovered.size()));
+    m_typingIndicator->setVisible(true);
+    QTimer::singleShot(5000, this, [this]() {
+        if (!m_isStreaming) m_typingIndicator->setVisible(false);
+    });
+    
+    emit conversationChanged();
+    return static_cast<int>(recovered.size());
+}
+
+void ChatWidget::setComparisonModels(const QStringList &modelIds)
+{
+    m_comparisonModels = modelIds;
+    m_compareButton->setVisible(modelIds.size() > 1);
+    m_compareButton->setToolTip("Send the next message to: " + modelIds.join(", "));
+    if (modelIds.size() < 2) {
+        m_compareButton->setChecked(false);
+    }
+}
+
+void ChatWidget::startComparison()
+{
+    m_comparison = new ModelComparisonWidget(m_markdownRenderer.get());
+    connect(m_comparison, &ModelComparisonWidget::candidateKept, this, &ChatWidget::onComparisonKept);
+    connect(m_comparison, &ModelComparisonWidget::dismissed, this, &ChatWidget::onComparisonDismissed);
+    
+    // Insert before stretch
+    m_messageLayout->insertWidget(m_messageLayout->count() - 1, m_comparison);
+    
+    // All models are asked at once; the slowest one bounds the wait
+    const QVector<RequestId> requestIds = m_api->sendFanOut(m_messages, m_comparisonModels);
+    for (int i = 0; i < requestIds.size(); ++i) {
+        m_comparison->addCandidate(requestIds[i], m_comparisonModels[i]);
+    }
+    
+    m_isStreaming = true;
+    m_contextNotice.clear();
+    m_typingIndicator->setToolTip(QString());
+    m_typingIndicator->setText(QString("Asking %1 models...").arg(requestIds.size()));
+    m_typingIndicator->setVisible(true);
+    m_streamProgress->setVisible(true);
+    m_streamProgress->setRange(0, 0); // Indeterminate
+    updateSendButton();
+    
+    QTimer::singleShot(100, this, &ChatWidget::scrollToBottom);
+}
+
+void ChatWidget::endComparison()
+{
+    if (!m_comparison) return;
+    
+    if (m_api) {
+        for (RequestId requestId : m_comparison->pendingRequests()) {
+            m_api->stopRequest(requestId);
+        }
+    }
+    m_comparison->deleteLater();
+    m_comparison = nullptr;
+}
+
+void ChatWidget::onComparisonKept(const Message &message)
+{
+    endComparison();
+    
+    m_isStreaming = false;
+    m_typingIndicator->setVisible(false);
+    m_streamProgress->setVisible(false);
+    
+    addMessage(message);
+    updateSendButton();
+    emit tokenStatsChanged(getTotalTokens(), getAverageTokensPerSecond());
+}
+
+void ChatWidget::onComparisonDismissed()
+{
+    endComparison();
+    
+    m_isStreaming = false;
+    m_typingIndicator->setVisible(false);
+    m_streamProgress->setVisible(false);
+    updateSendButton();
+}
+
 void ChatWidget::scrollToBottom()
 {
     QScrollBar* scrollBar = m_messageScrollArea->verticalScrollBar();
@@ -493,6 +812,8 @@ void ChatWidget::addAttachment(const QString &filePath)
     if (m_fileManager) {
         auto attachment = m_fileManager->createAttachment(filePath);
         if (attachment) {
+            // Encode the data URL now so sending never waits on base64
+            AttachmentEncoder::encodeAsync(attachment);
             m_pendingAttachments.push_back(attachment);
             
             // Create attachment preview
@@ -555,7 +876,11 @@ void ChatWidget::updateTokenStats()
         m_tokenCountLabel->setText(stats);
     } else {
         int totalTokens = getTotalTokens();
-        if (totalTokens > 0) {
+        if (totalTokens > 0 && m_promptTokensCached > 0) {
+            m_tokenCountLabel->setText(QString("Total tokens: %1 | Cache hit: %2%")
+                .arg(totalTokens)
+                .arg(100.0 * m_promptTokensCached / m_promptTokensSent, 0, 'f', 0));
+        } else if (totalTokens > 0) {
             m_tokenCountLabel->setText(QString("Total tokens: %1").arg(totalTokens));
         } else {
             m_tokenCountLabel->setText("Ready");
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Message.h"
+#include "OpenRouterAPI.h"
 #include <QWidget>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -18,15 +19,17 @@
 #include <vector>
 #include <memory>
 
-class OpenRouterAPI;
 class MessageWidget;
 class MarkdownRenderer;
 class FileManager;
+class ModelComparisonWidget;
+class StreamJournal;
 
 QT_BEGIN_NAMESPACE
 class QSplitter;
 class QListWidget;
 class QListWidgetItem;
+class QThread;
 QT_END_NAMESPACE
 
 class ChatWidget : public QWidget
@@ -48,6 +51,12 @@ public:
     void loadConversation(const QString &filename);
     void exportMarkdown(const QString &filename);
     
+    // Restores replies cut off by a crash; returns how many were found
+    int recoverInterruptedResponses();
+    
+    // Multi-model comparison
+    void setComparisonModels(const QStringList &modelIds);
+    
     // UI state
     void focusInput();
     bool isInputFocused() const;
@@ -70,9 +79,18 @@ protected:
 private slots:
     void sendMessage();
     void onInputTextChanged();
-    void onStreamReceived(const QString &content);
-    void onStreamCompleted(bool success);
-    void onStreamError(const QString &error);
+    void onStreamReceived(RequestId requestId, const QString &content);
+    void onStreamCompleted(RequestId requestId, bool success);
+    void onStreamError(RequestId requestId, const QString &error);
+    void onFirstTokenReceived(RequestId requestId, qint64 elapsedMs, bool reusedConnection);
+    void onContextTrimmed(RequestId requestId, int droppedMessages, int elidedImages, int estimatedTokens);
+    void onRequestRetrying(RequestId requestId, int attempt, int delayMs, const QString &reason);
+    void onPromptCacheUsage(RequestId requestId, int promptTokens, int cachedTokens);
+    void onRequestQueued(RequestId requestId, int waitMs, const QString &reason);
+    void onRequestDispatched(RequestId requestId);
+    void onResponseReplayed(RequestId requestId, const QDateTime &cachedAt);
+    void onComparisonKept(const Message &message);
+    void onComparisonDismissed();
     void scrollToBottom();
     void updateTypingIndicator();
     void clearAttachments();
@@ -88,6 +106,9 @@ private:
     void updateSendButton();
     void animateNewMessage();
     void updateTokenStats();
+    void startComparison();
+    void endComparison();
+    void finishJournal();
     
     // Message rendering
     void renderMessages();
@@ -134,6 +155,7 @@ private:
     QTextEdit *m_inputTextEdit;
     QPushButton *m_sendButton;
     QPushButton *m_attachButton;
+    QPushButton *m_compareButton;
     QPushButton *m_clearButton;
     
     // Attachment area
@@ -144,6 +166,7 @@ private:
     
     // Status indicators
     QLabel *m_typingIndicator;
+    QString m_contextNotice;
     QProgressBar *m_streamProgress;
     QLabel *m_tokenCountLabel;
     QTimer *m_typingTimer;
@@ -153,6 +176,17 @@ private:
     bool m_isStreaming = false;
     bool m_autoScroll = true;
     Message *m_streamingMessage = nullptr;
+    RequestId m_activeRequestId = 0;
+    QStringList m_comparisonModels;
+    
+    // Crash-safe copy of the streaming reply, written on its own thread
+    QThread *m_journalThread = nullptr;
+    StreamJournal *m_journal = nullptr;
+    QString m_journalDirectory;
+    QString m_journalReplyId;
+    ModelComparisonWidget *m_comparison = nullptr;
+    qint64 m_promptTokensSent = 0;      // Conversation totals reported by the provider
+    qint64 m_promptTokensCached = 0;
     
     // Animation
     int m_animationStep = 0;
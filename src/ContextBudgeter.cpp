@@ -0,0 +1,163 @@
+#include "ContextBudgeter.h"
+#include <QtGlobal>
+
+void ContextBudgeter::setContextWindow(int tokens)
+{
+    m_contextWindow = qMax(0, tokens);
+}
+
+void ContextBudgeter::setOutputReserve(int tokens)
+{
+    m_outputReserve = qMax(1, tokens);
+}
+
+int ContextBudgeter::outputReserve() const
+{
+    if (m_contextWindow == 0) {
+        return m_outputReserve;
+    }
+    
+    // Never let the reply reserve take more than a quarter of a small window
+    return qMax(1, qMin(m_outputReserve, m_contextWindow / 4));
+}
+
+int ContextBudgeter::estimateTokens(const Message& message) const
+{
+    // Roughly four characters per token when no vocabulary is available
+    const int textTokens = m_tokenizer ? m_tokenizer->countTokens(message)
+                                       : Tokenizer::estimateTokens(message.content);
+    return MESSAGE_OVERHEAD_TOKENS + textTokens + imageCount(message) * IMAGE_TOKENS;
+}
+
+int ContextBudgeter::imageCount(const Message& message)
+{
+    int count = 0;
+    for (const auto& attachment : message.attachments) {
+        if (attachment->isImage && attachment->size > 0) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+Message ContextBudgeter::elideImages(const Message& message)
+{
+    Message elided = message;
+    
+    // Distinct id so the payload cache keeps the full and elided forms apart
+    elided.id = message.id + "_elided";
+    
+    QStringList names;
+    std::vector<std::shared_ptr<Attachment>> kept;
+    for (const auto& attachment : message.attachments) {
+        if (attachment->isImage && attachment->size > 0) {
+            names.append(attachment->filename);
+        } else {
+            kept.push_back(attachment);
+        }
+    }
+    elided.attachments = kept;
+    
+    QString note = QString("[Image omitted to fit context: %1]").arg(names.join(", "));
+    elided.content = elided.content.isEmpty() ? note : elided.content + "\n" + note;
+    elided.revision = message.revision;
+    
+    return elided;
+}
+
+int ContextBudgeter::newestUserTurn(const std::vector<Message>& conversation)
+{
+    for (int i = static_cast<int>(conversation.size()) - 1; i >= 0; --i) {
+        if (conversation[i].isFromUser()) {
+            return i;
+        }
+    }
+    
+    // No user turn at all: keep the newest message
+    return qMax(0, static_cast<int>(conversation.size()) - 1);
+}
+
+ContextBudget ContextBudgeter::apply(const std::vector<Message>& conversation) const
+{
+    ContextBudget budget;
+    budget.maxOutputTokens = outputReserve();
+    
+    const int count = static_cast<int>(conversation.size());
+    
+    if (m_contextWindow == 0) {
+        budget.messages = conversation;
+        for (const auto& message : conversation) {
+            budget.estimatedPromptTokens += estimateTokens(message);
+        }
+        return budget;
+    }
+    
+    const int promptBudget = qMax(0, m_contextWindow - budget.maxOutputTokens);
+    
+    std::vector<Message> messages = conversation;
+    std::vector<int> tokens(messages.size());
+    int total = 0;
+    for (int i = 0; i < count; ++i) {
+        tokens[i] = estimateTokens(messages[i]);
+        total += tokens[i];
+    }
+    
+    // Elide images outside the most recent user turns, oldest first
+    if (total > promptBudget) {
+        int userTurns = 0;
+        int recentBoundary = 0;
+        for (int i = count - 1; i >= 0; --i) {
+            if (messages[i].isFromUser() && ++userTurns > RECENT_IMAGE_TURNS) {
+                recentBoundary = i + 1;
+                break;
+            }
+        }
+        
+        for (int i = 0; i < recentBoundary && total > promptBudget; ++i) {
+            const int images = imageCount(messages[i]);
+            if (images == 0) continue;
+            
+            messages[i] = elideImages(messages[i]);
+            const int elidedTokens = estimateTokens(messages[i]);
+            total += elidedTokens - tokens[i];
+            tokens[i] = elidedTokens;
+            budget.elidedImages += images;
+        }
+    }
+    
+    // Drop the oldest non-system turns, always keeping the newest user turn
+    // and anything after it
+    const int protectedFrom = newestUserTurn(messages);
+    std::vector<bool> keep(messages.size(), true);
+    for (int i = 0; i < protectedFrom; ++i) {
+        const bool quantumComplete = budget.droppedMessages % m_trimQuantum == 0;
+        if (total <= promptBudget && quantumComplete) break;
+        if (messages[i].isSystemMessage()) continue;
+        
+        keep[i] = false;
+        total -= tokens[i];
+        ++budget.droppedMessages;
+    }
+    
+    // Never leave the kept history opening on a reply whose question was dropped
+    if (budget.droppedMessages > 0) {
+        for (int i = 0; i < protectedFrom; ++i) {
+            if (!keep[i] || messages[i].isSystemMessage()) continue;
+            if (messages[i].isFromUser()) break;
+            
+            keep[i] = false;
+            total -= tokens[i];
+            ++budget.droppedMessages;
+        }
+    }
+    
+    budget.messages.reserve(messages.size() - budget.droppedMessages);
+    for (int i = 0; i < count; ++i) {
+        if (keep[i]) {
+            budget.messages.push_back(std::move(messages[i]));
+        }
+    }
+    budget.estimatedPromptTokens = total;
+    
+    return budget;
+}
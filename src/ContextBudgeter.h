@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Message.h"
+#include "Tokenizer.h"
+#include <memory>
+#include <vector>
+
+// Outcome of fitting a conversation into a model's context window
+struct ContextBudget {
+    std::vector<Message> messages;
+    int droppedMessages = 0;
+    int elidedImages = 0;
+    int estimatedPromptTokens = 0;
+    int maxOutputTokens = 0;
+    
+    bool trimmed() const { return droppedMessages > 0 || elidedImages > 0; }
+};
+
+// Fits a conversation into a context window minus a reserve for the reply.
+// System messages and the newest user turn (with anything after it) are
+// always kept. When the history is too long, images in older turns are
+// elided first, then the oldest turns are dropped until the estimate fits;
+// replies left without their user message are dropped with it.
+class ContextBudgeter {
+public:
+    ContextBudgeter() = default;
+    
+    // Configuration; a window of 0 means unknown and disables trimming
+    void setContextWindow(int tokens);
+    void setOutputReserve(int tokens);
+    int contextWindow() const { return m_contextWindow; }
+    int outputReserve() const;
+    void setTokenizer(std::shared_ptr<const Tokenizer> tokenizer) { m_tokenizer = std::move(tokenizer); }
+    
+    // Drop history in multiples of this many messages, so the surviving
+    // prefix stays identical across several turns (for prompt caching)
+    void setTrimQuantum(int messages) { m_trimQuantum = qMax(1, messages); }
+    
+    ContextBudget apply(const std::vector<Message>& conversation) const;
+    
+    // Token estimate for one message, exact for text when a tokenizer is loaded
+    int estimateTokens(const Message& message) const;
+    
+    // Index of the newest user message, or of the last message if there is none
+    static int newestUserTurn(const std::vector<Message>& conversation);
+    
+    static constexpr int MESSAGE_OVERHEAD_TOKENS = 4;   // Role and separators
+    static constexpr int IMAGE_TOKENS = 1000;           // Typical high-detail image
+    static constexpr int RECENT_IMAGE_TURNS = 2;        // User turns whose images are never elided
+
+private:
+    int m_contextWindow = 0;
+    int m_outputReserve = 2048;
+    std::shared_ptr<const Tokenizer> m_tokenizer;
+    int m_trimQuantum = 1;
+    
+    static int imageCount(const Message& message);
+    static Message elideImages(const Message& message);
+};
@@ -1,4 +1,6 @@
 #include "FileManager.h"
+#include "AttachmentEncoder.h"
+#include "NetworkService.h"
 #include <QFileDialog>
 #include <QImageReader>
 #include <QImageWriter>
@@ -8,16 +10,48 @@
 #include <QStandardPaths>
 #include <QDir>
 #include <QCryptographicHash>
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
 #include <QDebug>
-#include <QApplication>
-#include <QMessageBox>
 
-FileManager::FileManager(QObject* parent)
+namespace {
+
+constexpr int CONVERSATION_FILE_VERSION = 1;
+
+QString roleName(MessageRole role)
+{
+    switch (role) {
+        case MessageRole::User: return "user";
+        case MessageRole::Assistant: return "assistant";
+        case MessageRole::System: return "system";
+    }
+    return "user";
+}
+
+MessageRole roleFromName(const QString& name)
+{
+    if (name == "assistant") return MessageRole::Assistant;
+    if (name == "system") return MessageRole::System;
+    return MessageRole::User;
+}
+
+} // namespace
+
+FileManager::FileManager(NetworkService* network, QObject* parent)
     : QObject(parent)
+    , m_network(network)
     , m_maxFileSize(10 * 1024 * 1024)  // 10MB default
     , m_imageQuality(85)
     , m_maxImageDimension(2048)
 {
+    // Downloads share the application's connection pool when one is provided
+    if (!m_network) {
+        m_network = new NetworkService(this);
+    }
+    
     // Initialize supported file types
     initializeSupportedTypes();
     
@@ -349,4 +383,216 @@ QStringList FileManager::supportedDocumentTypes() const
 QStringList FileManager::supportedCodeTypes() const
 {
     return m_supportedCodeTypes;
-} 
\ No newline at end of file
+}
+
+// Attachments, conversation files and their JSON helpers use QtCore only,
+// so the headless command line can call them without a GUI application
+
+std::shared_ptr<Attachment> FileManager::createAttachment(const QString& filePath)
+{
+    const QFileInfo info(filePath);
+    if (!info.isFile() || !info.isReadable()) {
+        qWarning() << "Cannot read attachment:" << filePath;
+        return nullptr;
+    }
+    if (info.size() > m_maxFileSize) {
+        qWarning() << "Attachment exceeds the size limit:" << filePath << formatFileSize(info.size());
+        return nullptr;
+    }
+    
+    QFile file(info.absoluteFilePath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot open attachment:" << filePath << file.errorString();
+        return nullptr;
+    }
+    const QByteArray data = file.readAll();
+    
+    const QMimeType mimeType = m_mimeDatabase.mimeTypeForFileNameAndData(info.fileName(), data);
+    auto attachment = std::make_shared<Attachment>(info.fileName(), info.absoluteFilePath(), mimeType.name(),
+                                                   mimeType.name().startsWith("image/"));
+    attachment->data = std::make_shared<const QByteArray>(data);
+    attachment->size = data.size();
+    
+    emit attachmentCreated(attachment);
+    return attachment;
+}
+
+bool FileManager::saveConversation(const QString& filePath, const std::vector<Message>& messages)
+{
+    QJsonArray messageArray;
+    for (const Message& message : messages) {
+        messageArray.append(messageToJson(message));
+    }
+    
+    QJsonObject root;
+    root["version"] = CONVERSATION_FILE_VERSION;
+    root["saved"] = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+    root["messages"] = messageArray;
+    
+    // Written to a temporary file and renamed, so a failed save keeps the old one
+    QSaveFile file(filePath);
+    const QByteArray json = QJsonDocument(root).toJson(QJsonDocument::Indented);
+    if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() || !file.commit()) {
+        qWarning() << "Cannot save conversation:" << filePath << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool FileManager::loadConversation(const QString& filePath, std::vector<Message>& messages)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Cannot open conversation:" << filePath << file.errorString();
+        return false;
+    }
+    
+    QJsonParseError error;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject()) {
+        qWarning() << "Invalid conversation file:" << filePath << error.errorString();
+        return false;
+    }
+    
+    const QJsonArray messageArray = document.object().value("messages").toArray();
+    messages.clear();
+    messages.reserve(messageArray.size());
+    for (const QJsonValue& value : messageArray) {
+        messages.push_back(messageFromJson(value.toObject()));
+    }
+    return true;
+}
+
+QJsonObject FileManager::messageToJson(const Message& message) const
+{
+    QJsonObject obj;
+    obj["id"] = message.id;
+    obj["role"] = roleName(message.role);
+    obj["content"] = message.content;
+    obj["timestamp"] = message.timestamp.toString(Qt::ISODateWithMs);
+    if (message.totalTokens > 0) {
+        obj["tokens"] = message.totalTokens;
+    }
+    
+    if (!message.attachments.empty()) {
+        QJsonArray attachments;
+        for (const auto& attachment : message.attachments) {
+            attachments.append(attachmentToJson(attachment));
+        }
+        obj["attachments"] = attachments;
+    }
+    return obj;
+}
+
+Message FileManager::messageFromJson(const QJsonObject& json) const
+{
+    Message message(json.value("content").toString(), roleFromName(json.value("role").toString()));
+    if (json.contains("id")) {
+        message.id = json.value("id").toString();
+    }
+    const QDateTime timestamp = QDateTime::fromString(json.value("timestamp").toString(), Qt::ISODateWithMs);
+    if (timestamp.isValid()) {
+        message.timestamp = timestamp;
+    }
+    message.totalTokens = json.value("tokens").toInt();
+    
+    for (const QJsonValue& value : json.value("attachments").toArray()) {
+        if (auto attachment = attachmentFromJson(value.toObject())) {
+            message.addAttachment(attachment);
+        }
+    }
+    return message;
+}
+
+QJsonObject FileManager::attachmentToJson(const std::shared_ptr<Attachment>& attachment) const
+{
+    QJsonObject obj;
+    obj["filename"] = attachment->filename;
+    obj["path"] = attachment->filepath;
+    obj["mime_type"] = attachment->mimeType;
+    obj["image"] = attachment->isImage;
+    obj["size"] = attachment->size;
+    
+    // Images are written as the data URL they are sent as, which is usually
+    // encoded already and has released the raw bytes
+    if (attachment->isImage && attachment->size > 0) {
+        obj["data_url"] = QString::fromLatin1(AttachmentEncoder::dataUrl(attachment));
+    } else if (const auto data = std::atomic_load(&attachment->data)) {
+        obj["data"] = QString::fromLatin1(data->toBase64());
+    }
+    return obj;
+}
+
+std::shared_ptr<Attachment> FileManager::attachmentFromJson(const QJsonObject& json) const
+{
+    auto attachment = std::make_shared<Attachment>(json.value("filename").toString(),
+                                                   json.value("path").toString(),
+                                                   json.value("mime_type").toString(),
+                                                   json.value("image").toBool());
+    attachment->size = json.value("size").toVariant().toLongLong();
+    
+    if (json.contains("data_url")) {
+        const QByteArray url = json.value("data_url").toString().toLatin1();
+        AttachmentEncoder::adoptDataUrl(*attachment, url);
+        if (attachment->size <= 0) {
+            attachment->size = (url.size() - url.indexOf(',') - 1) / 4 * 3;
+        }
+    } else {
+        const QByteArray data = QByteArray::fromBase64(json.value("data").toString().toLatin1());
+        attachment->data = std::make_shared<const QByteArray>(data);
+        attachment->size = data.size();
+    }
+    return attachment;
+}
+
+void FileManager::downloadFile(const QUrl& url, const QString& destinationPath)
+{
+    QNetworkReply* reply = m_network->get(QNetworkRequest(url), NetworkService::Priority::Background);
+    reply->setProperty("destinationPath", destinationPath);
+    
+    connect(reply, &QNetworkReply::downloadProgress, this, &FileManager::onDownloadProgress);
+    connect(reply, &QNetworkReply::finished, this, &FileManager::onDownloadFinished);
+    
+    emit fileOperationStarted(QString("Downloading %1").arg(url.fileName()));
+}
+
+void FileManager::onDownloadProgress(qint64 bytesReceived, qint64 bytesTotal)
+{
+    if (bytesTotal > 0) {
+        emit fileOperationProgress(static_cast<int>((bytesReceived * 100) / bytesTotal));
+    }
+}
+
+void FileManager::onDownloadFinished()
+{
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply) return;
+    
+    const QString destinationPath = reply->property("destinationPath").toString();
+    
+    if (reply->error() != QNetworkReply::NoError) {
+        emit fileOperationCompleted(false, "Download failed: " + reply->errorString());
+        reply->deleteLater();
+        return;
+    }
+    
+    QFile file(destinationPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        emit fileOperationCompleted(false, "Failed to create file: " + destinationPath);
+        reply->deleteLater();
+        return;
+    }
+    
+    file.write(reply->readAll());
+    file.close();
+    
+    emit fileOperationCompleted(true, "Downloaded " + QFileInfo(destinationPath).fileName());
+    reply->deleteLater();
+}
+
+QString FileManager::getCachePath() const
+{
+    QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    QDir().mkpath(cacheDir);
+    return cacheDir;
+}
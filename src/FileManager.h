@@ -14,11 +14,13 @@
 #include <QStandardPaths>
 #include <QDir>
 #include <QTimer>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
+#include <QUrl>
+#include <QJsonObject>
 #include <memory>
 #include <vector>
 
+class NetworkService;
+
 QT_BEGIN_NAMESPACE
 class QProgressDialog;
 QT_END_NAMESPACE
@@ -28,7 +30,7 @@ class FileManager : public QObject
     Q_OBJECT
 
 public:
-    explicit FileManager(QObject *parent = nullptr);
+    explicit FileManager(NetworkService *network = nullptr, QObject *parent = nullptr);
     ~FileManager();
     
     // File operations
@@ -61,6 +63,9 @@ public:
     bool exportMarkdown(const QString& filePath, const std::vector<Message>& messages);
     bool exportHTML(const QString& filePath, const std::vector<Message>& messages);
     
+    // Downloads
+    void downloadFile(const QUrl& url, const QString& destinationPath);
+    
     // Configuration
     void setMaxFileSize(int bytes) { m_maxFileSize = bytes; }
     void setAllowedImageTypes(const QStringList& types) { m_allowedImageTypes = types; }
@@ -102,7 +107,7 @@ private:
     // JSON conversion helpers
     QJsonObject messageToJson(const Message& message) const;
     Message messageFromJson(const QJsonObject& json) const;
-    QJsonObject attachmentToJson(const Attachment& attachment) const;
+    QJsonObject attachmentToJson(const std::shared_ptr<Attachment>& attachment) const;
     std::shared_ptr<Attachment> attachmentFromJson(const QJsonObject& json) const;
     
     // HTML export helpers
@@ -115,7 +120,7 @@ private:
     QString escapeMarkdown(const QString& text) const;
     
     QMimeDatabase m_mimeDatabase;
-    QNetworkAccessManager* m_networkManager;
+    NetworkService* m_network;
     QProgressDialog* m_progressDialog = nullptr;
     
     // Configuration
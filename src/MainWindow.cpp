@@ -5,6 +5,9 @@
 #include "Settings.h"
 #include "SettingsDialog.h"
 #include "FileManager.h"
+#include "NetworkService.h"
+#include "BatchRunner.h"
+#include "AttachmentEncoder.h"
 
 #include <QApplication>
 #include <QVBoxLayout>
@@ -27,6 +30,7 @@
 #include <QUrl>
 #include <QDesktopServices>
 #include <QStandardPaths>
+#include <QLocale>
 #include <QDir>
 #include <QPixmap>
 
@@ -41,8 +45,13 @@ MainWindow::MainWindow(QWidget *parent)
     
     // Initialize core components
     m_settings = std::make_unique<Settings>(this);
-    m_api = std::make_unique<OpenRouterAPI>(this);
-    m_fileManager = std::make_unique<FileManager>(this);
+    m_networkService = std::make_unique<NetworkService>(this);
+    m_api = std::make_unique<OpenRouterAPI>(m_networkService.get(), this);
+    m_fileManager = std::make_unique<FileManager>(m_networkService.get(), this);
+    m_batchRunner = std::make_unique<BatchRunner>(m_api.get(), this);
+    
+    // Last known model catalogue is available before any network round trip
+    m_api->setCacheDirectory(m_fileManager->getCachePath());
     
     // Setup UI
     setupUI();
@@ -56,6 +65,12 @@ MainWindow::MainWindow(QWidget *parent)
     loadSettings();
     applyTheme();
     
+    // Bring back any reply that was still streaming when the app last exited
+    if (m_chatWidget->recoverInterruptedResponses() > 0 && m_mainSplitter->widget(1) != m_chatWidget.get()) {
+        m_mainSplitter->replaceWidget(1, m_chatWidget.get());
+        m_welcomeWidget->setParent(nullptr);
+    }
+    
     // Setup timers
     m_statusTimer = new QTimer(this);
     connect(m_statusTimer, &QTimer::timeout, this, &MainWindow::updateStatusBar);
@@ -265,6 +280,12 @@ void MainWindow::setupMenuBar()
     m_settingsAction->setShortcut(QKeySequence::Preferences);
     toolsMenu->addAction(m_settingsAction);
     
+    m_exportLatencyAction = new QAction("Export &Latency Log...", this);
+    toolsMenu->addAction(m_exportLatencyAction);
+    
+    m_runBatchAction = new QAction("Run &Batch...", this);
+    toolsMenu->addAction(m_runBatchAction);
+    
     // Help menu
     QMenu* helpMenu = menuBar()->addMenu("&Help");
     
@@ -290,6 +311,11 @@ void MainWindow::setupStatusBar()
     m_tokenStatsLabel->setStyleSheet("color: #4a5568; font-size: 12px;");
     statusBar()->addPermanentWidget(m_tokenStatsLabel);
     
+    m_latencyLabel = new QLabel;
+    m_latencyLabel->setStyleSheet("color: #4a5568; font-size: 12px;");
+    m_latencyLabel->setVisible(false);
+    statusBar()->addPermanentWidget(m_latencyLabel);
+    
     m_connectionProgress = new QProgressBar;
     m_connectionProgress->setVisible(false);
     m_connectionProgress->setFixedWidth(100);
@@ -305,6 +331,8 @@ void MainWindow::setupActions()
     connect(m_saveChatAsAction, &QAction::triggered, this, &MainWindow::saveChatAs);
     connect(m_exportMarkdownAction, &QAction::triggered, this, &MainWindow::exportMarkdown);
     connect(m_settingsAction, &QAction::triggered, this, &MainWindow::openSettings);
+    connect(m_exportLatencyAction, &QAction::triggered, this, &MainWindow::exportLatencyLog);
+    connect(m_runBatchAction, &QAction::triggered, this, &MainWindow::runBatch);
     connect(m_toggleThemeAction, &QAction::triggered, this, &MainWindow::toggleTheme);
     connect(m_aboutAction, &QAction::triggered, this, &MainWindow::showAbout);
     connect(m_exitAction, &QAction::triggered, this, &QWidget::close);
@@ -464,6 +492,76 @@ void MainWindow::exportMarkdown()
     }
 }
 
+void MainWindow::exportLatencyLog()
+{
+    QString filename = QFileDialog::getSaveFileName(
+        this,
+        "Export Latency Log",
+        m_fileManager->getExportsPath() + "/latency.jsonl",
+        "JSON Lines (*.jsonl);;All Files (*)"
+    );
+    
+    if (!filename.isEmpty()) {
+        if (m_api->exportLatencyLog(filename)) {
+            m_statusLabel->setText(QString("Exported %1 request timelines").arg(m_api->latency().recent().size()));
+        } else {
+            m_statusLabel->setText("Could not write latency log");
+        }
+    }
+}
+
+void MainWindow::runBatch()
+{
+    if (m_batchRunner->isRunning()) {
+        m_batchRunner->cancel();
+        return;
+    }
+    
+    QString inputPath = QFileDialog::getOpenFileName(
+        this,
+        "Run Batch",
+        m_fileManager->getExportsPath(),
+        "JSON Lines (*.jsonl);;All Files (*)"
+    );
+    if (inputPath.isEmpty()) return;
+    
+    // Choosing an earlier results file resumes that run
+    QFileInfo inputInfo(inputPath);
+    QString outputPath = QFileDialog::getSaveFileName(
+        this,
+        "Save Batch Results",
+        inputInfo.absolutePath() + "/" + inputInfo.completeBaseName() + ".results.jsonl",
+        "JSON Lines (*.jsonl);;All Files (*)",
+        nullptr,
+        QFileDialog::DontConfirmOverwrite
+    );
+    if (outputPath.isEmpty()) return;
+    
+    connect(m_batchRunner.get(), &BatchRunner::progress, this, [this](const BatchStats& stats) {
+        m_statusLabel->setText(QString("Batch: %1 done, %2 failed, %3 running (%4 items/min)")
+            .arg(stats.completed() + stats.skipped)
+            .arg(stats.failed)
+            .arg(stats.inFlight)
+            .arg(stats.itemsPerMinute(), 0, 'f', 1));
+    }, Qt::UniqueConnection);
+    connect(m_batchRunner.get(), &BatchRunner::finished, this, [this](const BatchStats& stats) {
+        m_runBatchAction->setText("Run &Batch...");
+        m_statusLabel->setText(QString("Batch finished: %1 succeeded, %2 failed, %3 skipped in %4 s (%5 tokens/s)")
+            .arg(stats.succeeded)
+            .arg(stats.failed)
+            .arg(stats.skipped)
+            .arg(stats.elapsedMs / 1000.0, 0, 'f', 1)
+            .arg(stats.tokensPerSecond(), 0, 'f', 1));
+    }, Qt::UniqueConnection);
+    
+    m_batchRunner->setMaxConcurrent(m_settings->GetSettings().batchConcurrency);
+    m_runBatchAction->setText("Stop &Batch");
+    if (!m_batchRunner->start(inputPath, outputPath)) {
+        m_runBatchAction->setText("Run &Batch...");
+        QMessageBox::warning(this, "Run Batch", m_batchRunner->errorString());
+    }
+}
+
 void MainWindow::openSettings()
 {
     if (!m_settingsDialog) {
@@ -523,6 +621,15 @@ void MainWindow::updateStatusBar()
         m_connectionProgress->setVisible(false);
     }
     
+    // Connection pool usage: chat streams on the network thread, everything else shared
+    auto poolLine = [](const QString& name, const NetworkStats& stats) {
+        return QString("%1: %2 requests (%3 active), %4 new connections, %5 reused, %6 over HTTP/2")
+            .arg(name).arg(stats.totalRequests).arg(stats.activeRequests).arg(stats.newConnections)
+            .arg(stats.reusedConnections).arg(stats.http2Responses);
+    };
+    m_statusLabel->setToolTip(poolLine("Chat", m_api->getChatNetworkStats()) + "\n"
+                              + poolLine("Models and downloads", m_api->getSharedNetworkStats()));
+    
     // Update token stats
     if (m_chatWidget) {
         int totalTokens = m_chatWidget->getTotalTokens();
@@ -536,6 +643,36 @@ void MainWindow::updateStatusBar()
             m_tokenStatsLabel->setText("Tokens: 0");
         }
     }
+    
+    // Image attachments are held as their encoded data URLs only
+    const qint64 encodedBytes = AttachmentEncoder::encodedBytes();
+    m_tokenStatsLabel->setToolTip(encodedBytes > 0
+        ? QString("Image attachments in memory: %1").arg(QLocale().formattedDataSize(encodedBytes))
+        : QString());
+    
+    // Rolling latency percentiles for the selected model
+    const LatencyTracker& latency = m_api->latency();
+    const QString model = m_api->model();
+    const LatencySummary ttft = latency.summary(model, LatencyTracker::Metric::TimeToFirstToken);
+    m_latencyLabel->setVisible(ttft.samples > 0);
+    if (ttft.samples > 0) {
+        m_latencyLabel->setText(QString("TTFT p50/p95/p99: %1/%2/%3 ms")
+            .arg(ttft.p50, 0, 'f', 0).arg(ttft.p95, 0, 'f', 0).arg(ttft.p99, 0, 'f', 0));
+        
+        auto line = [&](const QString& name, LatencyTracker::Metric metric) {
+            const LatencySummary s = latency.summary(model, metric);
+            return s.samples == 0 ? QString("%1: no samples").arg(name)
+                : QString("%1: p50 %2, p95 %3, p99 %4 ms (%5 samples)")
+                    .arg(name).arg(s.p50, 0, 'f', 0).arg(s.p95, 0, 'f', 0).arg(s.p99, 0, 'f', 0).arg(s.samples);
+        };
+        m_latencyLabel->setToolTip(QStringList{
+            line("New connection setup", LatencyTracker::Metric::Connect),
+            line("Time to first byte", LatencyTracker::Metric::TimeToFirstByte),
+            line("Time to first token", LatencyTracker::Metric::TimeToFirstToken),
+            line("Inter-token gap", LatencyTracker::Metric::InterTokenGap),
+            line("Total", LatencyTracker::Metric::Total)
+        }.join("\n"));
+    }
 }
 
 void MainWindow::checkAPIConnection()
@@ -630,9 +767,37 @@ void MainWindow::loadSettings()
     }
     
     // Apply API settings
+    m_api->setStreamFlushInterval(settings.streamFlushIntervalMs);
+    m_api->setOutputReserve(settings.responseTokenReserve);
+    m_api->setRequestTimeout(settings.requestTimeout);
+    m_api->setStallTimeout(settings.streamStallTimeout);
+    m_api->setMaxRetries(settings.maxRetries);
+    m_api->setRateLimits(settings.rateLimitPerMinute, settings.modelRateLimitPerMinute);
+    m_api->setPromptCachingEnabled(settings.enablePromptCaching);
+    m_api->setTemperature(settings.temperature);
+    m_api->setResponseCacheEnabled(settings.enableResponseCache, settings.cacheSampledResponses);
+    m_api->setResponseCacheSize(qint64(settings.responseCacheSizeMB) * 1024 * 1024);
+    m_chatWidget->setComparisonModels(settings.comparisonModels);
+    m_api->setLatencyLogPath(settings.latencyLogPath);
+    
+    // Exact token counts when a BPE vocabulary is installed
+    const QString tokenizerPath = settings.tokenizerPath.isEmpty()
+        ? QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/tokenizer"
+        : settings.tokenizerPath;
+    if (QFileInfo::exists(tokenizerPath + "/vocab.json")) {
+        m_api->loadTokenizer(tokenizerPath);
+    }
+    
+    m_api->setBackends(settings.backends);
     if (!settings.apiKey.isEmpty()) {
         m_api->setAPIKey(settings.apiKey);
+    }
+    if (!settings.apiKey.isEmpty() || !settings.backends.empty()) {
         m_api->setModel(settings.selectedModel);
+        
+        // Background refresh; a no-op while the cached catalogue is fresh
+        // (local backends are always asked)
+        m_api->refreshModels();
     }
     
     // Apply theme
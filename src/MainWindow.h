@@ -17,6 +17,8 @@ class OpenRouterAPI;
 class Settings;
 class SettingsDialog;
 class FileManager;
+class NetworkService;
+class BatchRunner;
 
 QT_BEGIN_NAMESPACE
 class QTextEdit;
@@ -46,6 +48,8 @@ private slots:
     void saveChat();
     void saveChatAs();
     void exportMarkdown();
+    void exportLatencyLog();
+    void runBatch();
     void openSettings();
     void toggleTheme();
     void showAbout();
@@ -74,11 +78,13 @@ private:
     void updateUserProfile();
     
     // Core components
+    std::unique_ptr<NetworkService> m_networkService;
     std::unique_ptr<ChatWidget> m_chatWidget;
     std::unique_ptr<OpenRouterAPI> m_api;
     std::unique_ptr<Settings> m_settings;
     std::unique_ptr<SettingsDialog> m_settingsDialog;
     std::unique_ptr<FileManager> m_fileManager;
+    std::unique_ptr<BatchRunner> m_batchRunner;
     
     // UI components
     QWidget *m_centralWidget;
@@ -109,6 +115,8 @@ private:
     QAction *m_saveChatAsAction;
     QAction *m_exportMarkdownAction;
     QAction *m_settingsAction;
+    QAction *m_exportLatencyAction;
+    QAction *m_runBatchAction;
     QAction *m_toggleThemeAction;
     QAction *m_aboutAction;
     QAction *m_exitAction;
@@ -117,6 +125,7 @@ private:
     QLabel *m_statusLabel;
     QLabel *m_modelLabel;
     QLabel *m_tokenStatsLabel;
+    QLabel *m_latencyLabel;
     QProgressBar *m_connectionProgress;
     QTimer *m_statusTimer;
     
@@ -6,6 +6,7 @@
 #include <QByteArray>
 #include <vector>
 #include <memory>
+#include <atomic>
 
 enum class MessageRole {
     User,
@@ -24,8 +25,16 @@ struct Attachment {
     QString filename;
     QString filepath;
     QString mimeType;
-    QByteArray data;
     bool isImage;
+    qint64 size = 0;            // Raw bytes; still valid once data is released
+    
+    // Raw file contents. An image's are released as soon as its data URL is
+    // encoded, so test size rather than data, and read both through
+    // AttachmentEncoder, which loads and stores them atomically.
+    std::shared_ptr<const QByteArray> data;
+    
+    // "data:<mime>;base64,..." as UTF-8, filled in once by AttachmentEncoder
+    std::shared_ptr<const QByteArray> encodedDataUrl;
     
     Attachment(const QString& file, const QString& path, const QString& mime, bool img = false)
         : filename(file), filepath(path), mimeType(mime), isImage(img) {}
@@ -39,11 +48,16 @@ struct Message {
     QDateTime timestamp;
     std::vector<std::shared_ptr<Attachment>> attachments;
     
+    // Bumped whenever content or attachments change; lets consumers cache
+    // derived data (e.g. serialized request fragments) per id and revision
+    quint64 revision = 0;
+    
     // Streaming metadata
     int totalTokens = 0;
     double tokensPerSecond = 0.0;
     QDateTime streamStartTime;
     QDateTime streamEndTime;
+    bool fromCache = false;     // Replayed from the local response cache
     
     // UI state
     bool isExpanded = true;
@@ -59,12 +73,32 @@ struct Message {
     }
     
     void generateId() {
+        // Messages created in the same millisecond still need distinct ids
+        static std::atomic<quint64> sequence{0};
         qint64 now = QDateTime::currentMSecsSinceEpoch();
-        id = QString("msg_%1").arg(now);
+        id = QString("msg_%1_%2").arg(now).arg(++sequence);
+    }
+    
+    // Call after editing content or attachments directly
+    void touch() {
+        ++revision;
+    }
+    
+    void setContent(const QString& text) {
+        content = text;
+        touch();
     }
     
     void addAttachment(std::shared_ptr<Attachment> attachment) {
         attachments.push_back(attachment);
+        touch();
+    }
+    
+    void removeAttachment(size_t index) {
+        if (index < attachments.size()) {
+            attachments.erase(attachments.begin() + index);
+            touch();
+        }
     }
     
     void startStreaming() {
@@ -74,9 +108,11 @@ struct Message {
         tokensPerSecond = 0.0;
     }
     
-    void updateStreaming(const QString& newContent) {
+    void updateStreaming(const QString& newContent, int tokenCount = -1) {
         content = newContent;
-        totalTokens = static_cast<int>(content.length() / 4); // Rough token estimate
+        touch();
+        totalTokens = tokenCount >= 0 ? tokenCount
+                                      : static_cast<int>(content.length() / 4); // Rough token estimate
         
         QDateTime now = QDateTime::currentDateTime();
         qint64 duration = streamStartTime.msecsTo(now);
@@ -128,7 +128,11 @@ void MessageWidget::updateContent()
     m_nameLabel->setText(displayName);
     
     // Update timestamp
-    m_timestampLabel->setText(m_message.timestamp().toString("hh:mm AP"));
+    QString timestamp = m_message.timestamp().toString("hh:mm AP");
+    if (m_message.fromCache) {
+        timestamp += " · cached reply";
+    }
+    m_timestampLabel->setText(timestamp);
     
     // Update content with markdown rendering
     if (!m_message.content().isEmpty()) {
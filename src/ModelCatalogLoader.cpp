@@ -0,0 +1,362 @@
+#include "ModelCatalogLoader.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QDebug>
+
+void ModelCatalogParser::reset()
+{
+    *this = ModelCatalogParser();
+}
+
+void ModelCatalogParser::feed(const QByteArray& data, std::vector<ModelInfo>& models)
+{
+    m_buffer.append(data);
+    const char* bytes = m_buffer.constData();
+    const int size = m_buffer.size();
+    
+    for (; m_pos < size; ++m_pos) {
+        const char c = bytes[m_pos];
+        
+        if (m_inString) {
+            if (m_escape) {
+                m_escape = false;
+            } else if (c == '\\') {
+                m_escape = true;
+            } else if (c == '"') {
+                m_inString = false;
+                // Keys of the top-level object; only "data" matters
+                if (m_depth == 1 && m_stringStart >= 0) {
+                    m_lastKey = m_buffer.mid(m_stringStart, m_pos - m_stringStart);
+                }
+                m_stringStart = -1;
+            }
+            continue;
+        }
+        
+        switch (c) {
+            case '"':
+                m_inString = true;
+                m_stringStart = m_pos + 1;
+                break;
+            case '{':
+            case '[':
+                ++m_depth;
+                if (c == '[' && m_depth == 2 && m_lastKey == "data") {
+                    m_inDataArray = true;
+                    m_sawDataArray = true;
+                } else if (c == '{' && m_inDataArray && m_depth == 3) {
+                    m_objectStart = m_pos;
+                }
+                break;
+            case '}':
+            case ']':
+                if (c == '}' && m_inDataArray && m_depth == 3 && m_objectStart >= 0) {
+                    QJsonParseError error;
+                    const QJsonDocument doc = QJsonDocument::fromJson(
+                        QByteArray::fromRawData(bytes + m_objectStart, m_pos - m_objectStart + 1), &error);
+                    if (error.error == QJsonParseError::NoError && doc.isObject()) {
+                        models.push_back(parseModel(doc.object()));
+                    } else {
+                        qWarning() << "Skipping unreadable model entry:" << error.errorString();
+                    }
+                    m_objectStart = -1;
+                } else if (c == ']' && m_inDataArray && m_depth == 2) {
+                    m_inDataArray = false;
+                }
+                --m_depth;
+                break;
+            default:
+                break;
+        }
+    }
+    
+    // Drop consumed bytes, keeping any object or key still in progress
+    int keepFrom = m_pos;
+    if (m_objectStart >= 0) keepFrom = qMin(keepFrom, m_objectStart);
+    if (m_inString && m_stringStart >= 0) keepFrom = qMin(keepFrom, m_stringStart);
+    
+    if (keepFrom > 0) {
+        m_buffer.remove(0, keepFrom);
+        m_pos -= keepFrom;
+        if (m_objectStart >= 0) m_objectStart -= keepFrom;
+        if (m_stringStart >= 0) m_stringStart -= keepFrom;
+    }
+}
+
+ModelInfo ModelCatalogParser::parseModel(const QJsonObject& modelObj)
+{
+    ModelInfo model(
+        modelObj["id"].toString(),
+        modelObj["name"].toString()
+    );
+    
+    model.description = modelObj["description"].toString();
+    model.provider = modelObj["owned_by"].toString();
+    
+    // Parse context length
+    if (modelObj.contains("context_length")) {
+        model.maxTokens = modelObj["context_length"].toInt();
+    }
+    
+    // Parse pricing if available
+    if (modelObj.contains("pricing")) {
+        QJsonObject pricing = modelObj["pricing"].toObject();
+        if (pricing.contains("prompt")) {
+            model.costPerToken = pricing["prompt"].toString().toDouble();
+        }
+        if (pricing.contains("completion")) {
+            model.completionCostPerToken = pricing["completion"].toString().toDouble();
+        }
+    }
+    
+    // Parse modalities
+    QJsonObject architecture = modelObj["architecture"].toObject();
+    for (const QJsonValue& modality : architecture["input_modalities"].toArray()) {
+        model.inputModalities.append(modality.toString());
+    }
+    for (const QJsonValue& modality : architecture["output_modalities"].toArray()) {
+        model.outputModalities.append(modality.toString());
+    }
+    
+    // Check capabilities
+    model.supportsImages = model.inputModalities.contains("image")
+        || modelObj["modalities"].toArray().contains("vision");
+    model.supportsFiles = true; // Most models support text files
+    
+    return model;
+}
+
+bool ModelCatalogCache::read(const QString& path, ModelCatalogCache& cache)
+{
+    QFile file(path);
+    if (path.isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        qWarning() << "Ignoring unreadable models cache:" << error.errorString();
+        return false;
+    }
+    
+    QJsonObject root = doc.object();
+    if (root["version"].toInt() != VERSION) {
+        return false;
+    }
+    
+    cache.models.clear();
+    for (const QJsonValue& value : root["models"].toArray()) {
+        QJsonObject modelObj = value.toObject();
+        
+        ModelInfo model(modelObj["id"].toString(), modelObj["name"].toString());
+        model.description = modelObj["description"].toString();
+        model.provider = modelObj["provider"].toString();
+        model.costPerToken = modelObj["promptCost"].toDouble();
+        model.completionCostPerToken = modelObj["completionCost"].toDouble();
+        model.maxTokens = modelObj["contextLength"].toInt(model.maxTokens);
+        model.supportsImages = modelObj["supportsImages"].toBool();
+        model.supportsFiles = modelObj["supportsFiles"].toBool(true);
+        for (const QJsonValue& modality : modelObj["inputModalities"].toArray()) {
+            model.inputModalities.append(modality.toString());
+        }
+        for (const QJsonValue& modality : modelObj["outputModalities"].toArray()) {
+            model.outputModalities.append(modality.toString());
+        }
+        
+        cache.models.push_back(model);
+    }
+    
+    cache.fetchedAt = QDateTime::fromString(root["fetchedAt"].toString(), Qt::ISODate);
+    cache.etag = root["etag"].toString().toUtf8();
+    cache.lastModified = root["lastModified"].toString().toUtf8();
+    
+    return !cache.models.empty();
+}
+
+bool ModelCatalogCache::write(const QString& path, const ModelCatalogCache& cache)
+{
+    if (path.isEmpty()) {
+        return false;
+    }
+    
+    QJsonArray models;
+    for (const auto& model : cache.models) {
+        QJsonObject modelObj;
+        modelObj["id"] = model.id;
+        modelObj["name"] = model.name;
+        modelObj["description"] = model.description;
+        modelObj["provider"] = model.provider;
+        modelObj["promptCost"] = model.costPerToken;
+        modelObj["completionCost"] = model.completionCostPerToken;
+        modelObj["contextLength"] = model.maxTokens;
+        modelObj["supportsImages"] = model.supportsImages;
+        modelObj["supportsFiles"] = model.supportsFiles;
+        modelObj["inputModalities"] = QJsonArray::fromStringList(model.inputModalities);
+        modelObj["outputModalities"] = QJsonArray::fromStringList(model.outputModalities);
+        models.append(modelObj);
+    }
+    
+    QJsonObject root;
+    root["version"] = VERSION;
+    root["fetchedAt"] = cache.fetchedAt.toString(Qt::ISODate);
+    root["etag"] = QString::fromUtf8(cache.etag);
+    root["lastModified"] = QString::fromUtf8(cache.lastModified);
+    root["models"] = models;
+    
+    // Write atomically so a crash never leaves a truncated catalogue behind
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning() << "Cannot write models cache:" << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit()) {
+        qWarning() << "Cannot write models cache:" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+ModelCatalogLoader::ModelCatalogLoader(QObject *parent)
+    : QObject(parent)
+{
+}
+
+LoadedModelCatalogue ModelCatalogLoader::loadCache(const QString& cachePath)
+{
+    LoadedModelCatalogue loaded;
+    
+    // A download in progress is newer than anything on disk
+    ModelCatalogCache cache;
+    if (m_active || !ModelCatalogCache::read(cachePath, cache)) {
+        return loaded;
+    }
+    
+    m_remote = std::make_shared<const ModelIndex>(std::move(cache.models));
+    loaded.remote = m_remote;
+    loaded.merged = merged();
+    loaded.fetchedAt = cache.fetchedAt;
+    loaded.etag = cache.etag;
+    loaded.lastModified = cache.lastModified;
+    return loaded;
+}
+
+void ModelCatalogLoader::setRemote(std::shared_ptr<const ModelIndex> remote)
+{
+    m_remote = std::move(remote);
+    if (!m_localModels.empty()) {
+        emit catalogueMerged(merged());
+    }
+}
+
+void ModelCatalogLoader::setLocalModels(std::vector<ModelInfo> models)
+{
+    if (models.empty() && m_localModels.empty()) return;
+    
+    m_localModels = std::move(models);
+    emit catalogueMerged(merged());
+}
+
+void ModelCatalogLoader::begin(std::shared_ptr<const ModelIndex> previous)
+{
+    m_parser.reset();
+    m_previous = std::move(previous);
+    m_models.clear();
+    m_publishedCount = 0;
+    m_active = true;
+}
+
+void ModelCatalogLoader::feed(const QByteArray& data)
+{
+    if (!m_active) return;
+    
+    m_parser.feed(data, m_models);
+    
+    if (static_cast<int>(m_models.size()) - m_publishedCount >= BATCH_SIZE) {
+        m_publishedCount = static_cast<int>(m_models.size());
+        publish(snapshot(), false);
+    }
+}
+
+void ModelCatalogLoader::finish(const QString& cachePath, const QDateTime& fetchedAt,
+                                const QByteArray& etag, const QByteArray& lastModified)
+{
+    if (!m_active) return;
+    m_active = false;
+    
+    if (!m_parser.sawCatalogue() || m_models.empty()) {
+        m_previous.reset();
+        emit failed("Models response contained no models");
+        return;
+    }
+    
+    // The finished catalogue replaces the previous one outright
+    auto catalogue = std::make_shared<const ModelIndex>(std::move(m_models));
+    m_models.clear();
+    m_previous.reset();
+    
+    publish(catalogue, true);
+    writeCache(cachePath, catalogue, fetchedAt, etag, lastModified);
+}
+
+void ModelCatalogLoader::abort()
+{
+    m_active = false;
+    m_parser.reset();
+    m_models.clear();
+    m_previous.reset();
+}
+
+void ModelCatalogLoader::writeCache(const QString& cachePath, std::shared_ptr<const ModelIndex> catalogue,
+                                    const QDateTime& fetchedAt, const QByteArray& etag, const QByteArray& lastModified)
+{
+    if (cachePath.isEmpty() || !catalogue) return;
+    
+    ModelCatalogCache cache;
+    cache.fetchedAt = fetchedAt;
+    cache.etag = etag;
+    cache.lastModified = lastModified;
+    cache.models = catalogue->models();
+    ModelCatalogCache::write(cachePath, cache);
+}
+
+std::shared_ptr<const ModelIndex> ModelCatalogLoader::snapshot() const
+{
+    // Models parsed so far, followed by previous entries not yet replaced
+    std::vector<ModelInfo> models = m_models;
+    if (m_previous) {
+        QSet<QString> seen;
+        for (const ModelInfo& model : m_models) {
+            seen.insert(model.id);
+        }
+        for (const ModelInfo& model : m_previous->models()) {
+            if (!seen.contains(model.id)) {
+                models.push_back(model);
+            }
+        }
+    }
+    return std::make_shared<const ModelIndex>(std::move(models));
+}
+
+std::shared_ptr<const ModelIndex> ModelCatalogLoader::merged() const
+{
+    if (m_localModels.empty()) {
+        return m_remote;
+    }
+    
+    // Local models first; they are few and the likely reason backends are configured
+    std::vector<ModelInfo> models = m_localModels;
+    if (m_remote) {
+        models.insert(models.end(), m_remote->models().begin(), m_remote->models().end());
+    }
+    return std::make_shared<const ModelIndex>(std::move(models));
+}
+
+void ModelCatalogLoader::publish(std::shared_ptr<const ModelIndex> remote, bool complete)
+{
+    m_remote = std::move(remote);
+    emit catalogueUpdated(m_remote, merged(), complete);
+}
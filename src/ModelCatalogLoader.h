@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ModelIndex.h"
+#include <QObject>
+#include <QByteArray>
+#include <QDateTime>
+#include <QJsonObject>
+#include <QMetaType>
+#include <QSet>
+#include <memory>
+#include <vector>
+
+Q_DECLARE_METATYPE(std::shared_ptr<const ModelIndex>)
+
+// Cuts the objects of the top-level "data" array out of a /models response
+// as bytes arrive, so each model can be decoded on its own without waiting
+// for, or building a DOM of, the whole catalogue
+class ModelCatalogParser {
+public:
+    void reset();
+    
+    // Appends every model completed by this chunk
+    void feed(const QByteArray& data, std::vector<ModelInfo>& models);
+    bool sawCatalogue() const { return m_sawDataArray; }
+    
+    static ModelInfo parseModel(const QJsonObject& modelObj);
+
+private:
+    QByteArray m_buffer;
+    int m_pos = 0;
+    int m_depth = 0;
+    bool m_inString = false;
+    bool m_escape = false;
+    int m_stringStart = -1;
+    QByteArray m_lastKey;
+    bool m_inDataArray = false;
+    bool m_sawDataArray = false;
+    int m_objectStart = -1;
+};
+
+// On-disk copy of the last downloaded catalogue
+struct ModelCatalogCache {
+    QDateTime fetchedAt;
+    QByteArray etag;
+    QByteArray lastModified;
+    std::vector<ModelInfo> models;
+    
+    static bool read(const QString& path, ModelCatalogCache& cache);
+    static bool write(const QString& path, const ModelCatalogCache& cache);
+    
+    static constexpr int VERSION = 1;
+};
+
+// The cached catalogue as read by ModelCatalogLoader::loadCache
+struct LoadedModelCatalogue {
+    std::shared_ptr<const ModelIndex> remote;   // Null when there is no usable cache
+    std::shared_ptr<const ModelIndex> merged;
+    QDateTime fetchedAt;
+    QByteArray etag;
+    QByteArray lastModified;
+};
+
+// Parses a streamed /models response on a worker thread. Partial snapshots
+// are published every BATCH_SIZE models; each snapshot is a complete,
+// immutable ModelIndex (new models plus not-yet-replaced previous ones), so
+// the receiver can swap it in atomically.
+//
+// The loader also owns the merge with models listed by local backends, so
+// every index the picker sees, partial or not, is built here rather than
+// on the receiver's thread.
+class ModelCatalogLoader : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ModelCatalogLoader(QObject *parent = nullptr);
+    
+    // Reads and indexes the cache file; call on the loader's thread
+    LoadedModelCatalogue loadCache(const QString& cachePath);
+    
+    static constexpr int BATCH_SIZE = 100;
+
+public slots:
+    // Remote catalogue not produced by the loader (built-in defaults)
+    void setRemote(std::shared_ptr<const ModelIndex> remote);
+    void setLocalModels(std::vector<ModelInfo> models);
+    
+    void begin(std::shared_ptr<const ModelIndex> previous);
+    void feed(const QByteArray& data);
+    void finish(const QString& cachePath, const QDateTime& fetchedAt, const QByteArray& etag, const QByteArray& lastModified);
+    void abort();
+    void writeCache(const QString& cachePath, std::shared_ptr<const ModelIndex> catalogue,
+                    const QDateTime& fetchedAt, const QByteArray& etag, const QByteArray& lastModified);
+
+signals:
+    // remote is OpenRouter's catalogue alone; merged adds the local models
+    void catalogueUpdated(std::shared_ptr<const ModelIndex> remote, std::shared_ptr<const ModelIndex> merged,
+                          bool complete);
+    void catalogueMerged(std::shared_ptr<const ModelIndex> merged);
+    void failed(const QString& error);
+
+private:
+    ModelCatalogParser m_parser;
+    std::shared_ptr<const ModelIndex> m_previous;
+    std::vector<ModelInfo> m_models;
+    int m_publishedCount = 0;
+    bool m_active = false;
+    
+    // Latest remote catalogue, and local models listed ahead of it
+    std::shared_ptr<const ModelIndex> m_remote;
+    std::vector<ModelInfo> m_localModels;
+    
+    std::shared_ptr<const ModelIndex> snapshot() const;
+    std::shared_ptr<const ModelIndex> merged() const;
+    void publish(std::shared_ptr<const ModelIndex> remote, bool complete);
+};
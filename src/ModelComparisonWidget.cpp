@@ -0,0 +1,185 @@
+#include "ModelComparisonWidget.h"
+#include "MessageWidget.h"
+#include "MarkdownRenderer.h"
+
+ModelComparisonWidget::ModelComparisonWidget(MarkdownRenderer *renderer, QWidget *parent)
+    : QFrame(parent)
+    , m_markdownRenderer(renderer)
+{
+    setObjectName("modelComparison");
+    setFrameStyle(QFrame::NoFrame);
+    
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setContentsMargins(16, 8, 16, 8);
+    layout->setSpacing(8);
+    
+    QHBoxLayout* headerLayout = new QHBoxLayout;
+    QLabel* title = new QLabel("Comparing models - keep the answer you want in the conversation");
+    title->setProperty("class", "card-subtitle");
+    QPushButton* dismissButton = new QPushButton("Dismiss");
+    dismissButton->setProperty("class", "secondary-button");
+    dismissButton->setToolTip("Discard all answers and continue without a reply");
+    connect(dismissButton, &QPushButton::clicked, this, &ModelComparisonWidget::dismissed);
+    headerLayout->addWidget(title, 1);
+    headerLayout->addWidget(dismissButton);
+    layout->addLayout(headerLayout);
+    
+    m_columnsLayout = new QHBoxLayout;
+    m_columnsLayout->setSpacing(12);
+    layout->addLayout(m_columnsLayout);
+}
+
+void ModelComparisonWidget::addCandidate(RequestId requestId, const QString& modelId)
+{
+    auto entry = std::make_unique<Candidate>();
+    entry->requestId = requestId;
+    entry->modelId = modelId;
+    entry->message = Message("", MessageRole::Assistant);
+    entry->message.startStreaming();
+    entry->timer.start();
+    
+    QFrame* column = new QFrame;
+    column->setProperty("class", "card");
+    QVBoxLayout* columnLayout = new QVBoxLayout(column);
+    columnLayout->setContentsMargins(8, 8, 8, 8);
+    columnLayout->setSpacing(6);
+    
+    QLabel* modelLabel = new QLabel(modelId);
+    modelLabel->setProperty("class", "card-title");
+    
+    entry->view = new MessageWidget(entry->message, m_markdownRenderer, column);
+    
+    entry->metricsLabel = new QLabel("Waiting for first token...");
+    entry->metricsLabel->setProperty("class", "card-subtitle");
+    
+    entry->keepButton = new QPushButton("Keep");
+    entry->keepButton->setProperty("class", "primary-button");
+    entry->keepButton->setEnabled(false);
+    
+    Candidate* raw = entry.get();
+    connect(entry->keepButton, &QPushButton::clicked, this, [this, raw]() {
+        Message kept = raw->message;
+        kept.completeStreaming();
+        emit candidateKept(kept);
+    });
+    
+    columnLayout->addWidget(modelLabel);
+    columnLayout->addWidget(entry->view, 1);
+    columnLayout->addWidget(entry->metricsLabel);
+    columnLayout->addWidget(entry->keepButton);
+    m_columnsLayout->addWidget(column, 1);
+    
+    m_candidates.push_back(std::move(entry));
+}
+
+bool ModelComparisonWidget::isFinished() const
+{
+    for (const auto& entry : m_candidates) {
+        if (!entry->finished) return false;
+    }
+    return true;
+}
+
+bool ModelComparisonWidget::hasKeepableCandidate() const
+{
+    for (const auto& entry : m_candidates) {
+        if (entry->keepButton->isEnabled()) return true;
+    }
+    return false;
+}
+
+QVector<RequestId> ModelComparisonWidget::pendingRequests() const
+{
+    QVector<RequestId> pending;
+    for (const auto& entry : m_candidates) {
+        if (!entry->finished) {
+            pending.append(entry->requestId);
+        }
+    }
+    return pending;
+}
+
+void ModelComparisonWidget::appendContent(RequestId requestId, const QString& content, int tokenCount)
+{
+    Candidate* entry = candidate(requestId);
+    if (!entry || entry->finished) return;
+    
+    entry->message.updateStreaming(entry->message.content + content, tokenCount);
+    entry->view->updateMessage(entry->message);
+    updateMetrics(*entry);
+}
+
+void ModelComparisonWidget::setFirstToken(RequestId requestId, qint64 elapsedMs)
+{
+    Candidate* entry = candidate(requestId);
+    if (!entry) return;
+    
+    entry->firstTokenMs = elapsedMs;
+    updateMetrics(*entry);
+}
+
+void ModelComparisonWidget::complete(RequestId requestId, bool success)
+{
+    Candidate* entry = candidate(requestId);
+    if (!entry || entry->finished) return;
+    
+    entry->finished = true;
+    entry->totalMs = entry->timer.elapsed();
+    if (success) {
+        entry->message.completeStreaming();
+    } else {
+        entry->message.setError();
+    }
+    entry->view->updateMessage(entry->message);
+    entry->keepButton->setEnabled(success && !entry->message.content.isEmpty());
+    updateMetrics(*entry);
+}
+
+void ModelComparisonWidget::setError(RequestId requestId, const QString& error)
+{
+    Candidate* entry = candidate(requestId);
+    if (!entry) return;
+    
+    entry->metricsLabel->setText(QString("Error: %1").arg(error));
+    entry->metricsLabel->setToolTip(error);
+}
+
+ModelComparisonWidget::Candidate* ModelComparisonWidget::candidate(RequestId requestId)
+{
+    for (const auto& entry : m_candidates) {
+        if (entry->requestId == requestId) return entry.get();
+    }
+    return nullptr;
+}
+
+const ModelComparisonWidget::Candidate* ModelComparisonWidget::candidate(RequestId requestId) const
+{
+    for (const auto& entry : m_candidates) {
+        if (entry->requestId == requestId) return entry.get();
+    }
+    return nullptr;
+}
+
+void ModelComparisonWidget::updateMetrics(Candidate& entry)
+{
+    if (entry.finished && entry.message.status == MessageStatus::Error) {
+        return; // Keeps the error text
+    }
+    
+    QStringList parts;
+    parts.append(entry.firstTokenMs >= 0 ? QString("TTFT %1 ms").arg(entry.firstTokenMs)
+                                         : QString("TTFT -"));
+    
+    const qint64 elapsedMs = entry.finished ? entry.totalMs : entry.timer.elapsed();
+    parts.append(QString("%1 %2 s").arg(entry.finished ? "Total" : "Elapsed")
+        .arg(elapsedMs / 1000.0, 0, 'f', 2));
+    
+    // Generation speed, measured from the first token so TTFT is not counted twice
+    const qint64 generationMs = entry.firstTokenMs >= 0 ? elapsedMs - entry.firstTokenMs : 0;
+    if (generationMs > 0) {
+        parts.append(QString("%1 tok/s").arg(entry.message.totalTokens * 1000.0 / generationMs, 0, 'f', 1));
+    }
+    parts.append(QString("%1 tokens").arg(entry.message.totalTokens));
+    
+    entry.metricsLabel->setText(parts.join(" | "));
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Message.h"
+#include "OpenRouterAPI.h"
+#include <QFrame>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QElapsedTimer>
+#include <vector>
+#include <memory>
+
+class MessageWidget;
+class MarkdownRenderer;
+
+// Side-by-side view of one prompt answered by several models at once. Each
+// column streams its own reply and shows time-to-first-token, total latency
+// and tokens/sec; the user keeps one answer as the conversation's reply, or
+// dismisses them all.
+class ModelComparisonWidget : public QFrame
+{
+    Q_OBJECT
+
+public:
+    explicit ModelComparisonWidget(MarkdownRenderer *renderer, QWidget *parent = nullptr);
+    
+    void addCandidate(RequestId requestId, const QString& modelId);
+    bool contains(RequestId requestId) const { return candidate(requestId) != nullptr; }
+    bool isFinished() const;
+    bool hasKeepableCandidate() const;
+    QVector<RequestId> pendingRequests() const;
+    
+    // Stream events for one candidate
+    void appendContent(RequestId requestId, const QString& content, int tokenCount);
+    void setFirstToken(RequestId requestId, qint64 elapsedMs);
+    void complete(RequestId requestId, bool success);
+    void setError(RequestId requestId, const QString& error);
+
+signals:
+    void candidateKept(const Message& message);
+    void dismissed();
+
+private:
+    struct Candidate {
+        RequestId requestId = 0;
+        QString modelId;
+        Message message;
+        QElapsedTimer timer;
+        qint64 firstTokenMs = -1;
+        qint64 totalMs = -1;
+        bool finished = false;
+    
+        MessageWidget *view = nullptr;
+        QLabel *metricsLabel = nullptr;
+        QPushButton *keepButton = nullptr;
+    };
+    
+    Candidate* candidate(RequestId requestId);
+    const Candidate* candidate(RequestId requestId) const;
+    void updateMetrics(Candidate& entry);
+    
+    MarkdownRenderer *m_markdownRenderer;
+    QHBoxLayout *m_columnsLayout;
+    std::vector<std::unique_ptr<Candidate>> m_candidates;
+};
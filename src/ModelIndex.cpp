@@ -0,0 +1,135 @@
+#include "ModelIndex.h"
+#include <QSet>
+#include <algorithm>
+
+bool ModelFilter::matches(const ModelInfo& model, const QString& modelProvider) const
+{
+    if (!provider.isEmpty() && modelProvider != provider) return false;
+    if (minContextLength > 0 && model.maxTokens < minContextLength) return false;
+    if (maxPromptCost >= 0.0 && model.costPerToken > maxPromptCost) return false;
+    
+    if (!inputModality.isEmpty()) {
+        // Catalogues without modality data only tell us about images
+        const bool hasModality = model.inputModalities.contains(inputModality)
+            || (inputModality == "image" && model.supportsImages);
+        if (!hasModality) return false;
+    }
+    
+    return true;
+}
+
+ModelIndex::ModelIndex(std::vector<ModelInfo> models)
+    : m_models(std::move(models))
+{
+    const int count = size();
+    m_byId.reserve(count);
+    m_searchKeys.reserve(count);
+    m_providers.reserve(count);
+    
+    QSet<QString> providerSet;
+    
+    for (int i = 0; i < count; ++i) {
+        const ModelInfo& model = m_models[i];
+        m_byId.insert(model.id, i);
+        
+        // OpenRouter ids are "<provider>/<model>"; owned_by is often missing
+        const QString provider = model.provider.isEmpty() ? model.id.section('/', 0, 0) : model.provider;
+        m_providers.append(provider);
+        providerSet.insert(provider);
+        
+        const QString key = (model.id + ' ' + model.name).toLower();
+        m_searchKeys.append(key);
+        
+        // Each trigram is posted once per model, in ascending model order
+        QSet<quint64> seen;
+        for (int c = 0; c + 2 < key.size(); ++c) {
+            const quint64 trigram = trigramKey(key.constData() + c);
+            if (!seen.contains(trigram)) {
+                seen.insert(trigram);
+                m_trigrams[trigram].append(i);
+            }
+        }
+    }
+    
+    m_providerNames = providerSet.values();
+    std::sort(m_providerNames.begin(), m_providerNames.end());
+}
+
+const ModelInfo* ModelIndex::find(const QString& id) const
+{
+    const auto it = m_byId.constFind(id);
+    return it != m_byId.constEnd() ? &m_models[it.value()] : nullptr;
+}
+
+int ModelIndex::score(int index, const QString& query) const
+{
+    const ModelInfo& model = m_models[index];
+    const QString& key = m_searchKeys[index];
+    
+    if (model.id.compare(query, Qt::CaseInsensitive) == 0) return 1000;
+    
+    int result = 0;
+    const QString shortId = model.id.section('/', 1).toLower();
+    if (shortId.startsWith(query) || model.name.startsWith(query, Qt::CaseInsensitive)) {
+        result = 500;
+    } else if (key.startsWith(query)) {
+        result = 400;
+    } else if (key.contains(query)) {
+        result = 300;
+    }
+    
+    // Prefer shorter names among equally good matches
+    return result - qMin(99, static_cast<int>(key.size()) / 4);
+}
+
+QVector<int> ModelIndex::search(const QString& query, const ModelFilter& filter, int limit) const
+{
+    const QString needle = query.trimmed().toLower();
+    QVector<int> results;
+    QVector<int> scores(size(), 0);
+    
+    if (needle.size() < 3) {
+        // Too short for trigrams; a linear scan over short keys is cheap
+        for (int i = 0; i < size(); ++i) {
+            if (!filter.matches(m_models[i], m_providers[i])) continue;
+            if (!needle.isEmpty() && !m_searchKeys[i].contains(needle)) continue;
+            
+            scores[i] = needle.isEmpty() ? 0 : score(i, needle);
+            results.append(i);
+        }
+    } else {
+        // Count shared trigrams; tolerating misses gives typo-tolerant matching
+        QVector<int> hits(size(), 0);
+        QSet<quint64> queryTrigrams;
+        for (int c = 0; c + 2 < needle.size(); ++c) {
+            queryTrigrams.insert(trigramKey(needle.constData() + c));
+        }
+        
+        for (quint64 trigram : queryTrigrams) {
+            const auto it = m_trigrams.constFind(trigram);
+            if (it == m_trigrams.constEnd()) continue;
+            for (int i : it.value()) {
+                ++hits[i];
+            }
+        }
+        
+        const int required = qMax(1, (static_cast<int>(queryTrigrams.size()) + 1) / 2);
+        for (int i = 0; i < size(); ++i) {
+            if (hits[i] < required || !filter.matches(m_models[i], m_providers[i])) continue;
+            
+            scores[i] = score(i, needle) + (hits[i] * 100) / static_cast<int>(queryTrigrams.size());
+            results.append(i);
+        }
+    }
+    
+    std::stable_sort(results.begin(), results.end(), [&](int a, int b) {
+        if (scores[a] != scores[b]) return scores[a] > scores[b];
+        return m_models[a].name.compare(m_models[b].name, Qt::CaseInsensitive) < 0;
+    });
+    
+    if (limit >= 0 && results.size() > limit) {
+        results.resize(limit);
+    }
+    
+    return results;
+}
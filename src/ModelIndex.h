@@ -0,0 +1,72 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <vector>
+
+struct ModelInfo {
+    QString id;
+    QString name;
+    QString description;
+    QString provider;
+    double costPerToken;            // Prompt price per token
+    double completionCostPerToken;
+    int maxTokens;
+    bool supportsImages;
+    bool supportsFiles;
+    QStringList inputModalities;
+    QStringList outputModalities;
+    
+    ModelInfo(const QString& modelId, const QString& modelName)
+        : id(modelId), name(modelName), costPerToken(0.0), completionCostPerToken(0.0), maxTokens(4096), 
+          supportsImages(false), supportsFiles(false) {}
+};
+
+// Restricts search results; default-constructed fields match everything
+struct ModelFilter {
+    QString provider;
+    QString inputModality;        // e.g. "image"
+    double maxPromptCost = -1.0;  // Per token; negative means no limit
+    int minContextLength = 0;
+    
+    bool matches(const ModelInfo& model, const QString& modelProvider) const;
+};
+
+// Immutable, searchable snapshot of the model catalogue. Lookups by id go
+// through a hash; free-text search uses a trigram index over id and name for
+// queries of three or more characters and a prefix/substring scan below that,
+// so typing into the picker stays cheap with thousands of models.
+class ModelIndex {
+public:
+    ModelIndex() = default;
+    explicit ModelIndex(std::vector<ModelInfo> models);
+    
+    const std::vector<ModelInfo>& models() const { return m_models; }
+    int size() const { return static_cast<int>(m_models.size()); }
+    const ModelInfo& at(int index) const { return m_models[index]; }
+    
+    const ModelInfo* find(const QString& id) const;
+    QString providerOf(int index) const { return m_providers[index]; }
+    QStringList providers() const { return m_providerNames; }
+    
+    // Indices of matching models, best match first
+    QVector<int> search(const QString& query, const ModelFilter& filter = ModelFilter(), int limit = -1) const;
+
+private:
+    std::vector<ModelInfo> m_models;
+    QHash<QString, int> m_byId;
+    QVector<QString> m_searchKeys;      // Lower-cased "id name"
+    QVector<QString> m_providers;
+    QStringList m_providerNames;
+    QHash<quint64, QVector<int>> m_trigrams;
+    
+    int score(int index, const QString& query) const;
+    
+    static quint64 trigramKey(const QChar* chars) {
+        return (static_cast<quint64>(chars[0].unicode()) << 32)
+            | (static_cast<quint64>(chars[1].unicode()) << 16)
+            | chars[2].unicode();
+    }
+};
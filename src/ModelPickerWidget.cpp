@@ -0,0 +1,193 @@
+#include "ModelPickerWidget.h"
+#include <QItemSelectionModel>
+
+ModelListModel::ModelListModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+void ModelListModel::setResults(std::shared_ptr<const ModelIndex> index, const QVector<int>& rows)
+{
+    beginResetModel();
+    m_index = std::move(index);
+    m_rows = rows;
+    endResetModel();
+}
+
+int ModelListModel::rowOf(const QString& modelId) const
+{
+    if (!m_index) return -1;
+    
+    for (int row = 0; row < m_rows.size(); ++row) {
+        if (m_index->at(m_rows[row]).id == modelId) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+int ModelListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+QVariant ModelListModel::data(const QModelIndex &index, int role) const
+{
+    if (!m_index || !index.isValid() || index.row() >= m_rows.size()) {
+        return QVariant();
+    }
+    
+    const ModelInfo& model = m_index->at(m_rows[index.row()]);
+    
+    switch (role) {
+        case Qt::DisplayRole:
+            return QString("%1  (%2)").arg(model.name.isEmpty() ? model.id : model.name, model.id);
+        case Qt::ToolTipRole:
+            return QString("%1\nContext: %2 tokens\nPrompt: $%3 / 1M tokens\nCompletion: $%4 / 1M tokens")
+                .arg(model.id)
+                .arg(model.maxTokens)
+                .arg(model.costPerToken * 1e6, 0, 'f', 2)
+                .arg(model.completionCostPerToken * 1e6, 0, 'f', 2);
+        case ModelIdRole:
+            return model.id;
+        default:
+            return QVariant();
+    }
+}
+
+ModelPickerWidget::ModelPickerWidget(QWidget *parent)
+    : QWidget(parent)
+    , m_listModel(new ModelListModel(this))
+{
+    setupUI();
+}
+
+void ModelPickerWidget::setupUI()
+{
+    m_layout = new QVBoxLayout(this);
+    m_layout->setContentsMargins(0, 0, 0, 0);
+    m_layout->setSpacing(6);
+    
+    m_searchEdit = new QLineEdit;
+    m_searchEdit->setPlaceholderText("Search models...");
+    m_searchEdit->setClearButtonEnabled(true);
+    m_layout->addWidget(m_searchEdit);
+    
+    // Filters
+    auto* filterLayout = new QHBoxLayout;
+    
+    m_providerComboBox = new QComboBox;
+    m_providerComboBox->addItem("All providers", QString());
+    filterLayout->addWidget(m_providerComboBox);
+    
+    m_contextComboBox = new QComboBox;
+    m_contextComboBox->addItem("Any context", 0);
+    m_contextComboBox->addItem("32K+", 32 * 1024);
+    m_contextComboBox->addItem("128K+", 128 * 1024);
+    m_contextComboBox->addItem("1M+", 1000 * 1000);
+    filterLayout->addWidget(m_contextComboBox);
+    
+    m_priceComboBox = new QComboBox;
+    m_priceComboBox->addItem("Any price", -1.0);
+    m_priceComboBox->addItem("Free", 0.0);
+    m_priceComboBox->addItem("< $1 / 1M", 1e-6);
+    m_priceComboBox->addItem("< $5 / 1M", 5e-6);
+    filterLayout->addWidget(m_priceComboBox);
+    
+    m_imagesCheckBox = new QCheckBox("Images");
+    filterLayout->addWidget(m_imagesCheckBox);
+    filterLayout->addStretch();
+    m_layout->addLayout(filterLayout);
+    
+    // Uniform item sizes let the view lay out only the visible rows
+    m_listView = new QListView;
+    m_listView->setObjectName("modelPickerList");
+    m_listView->setModel(m_listModel);
+    m_listView->setUniformItemSizes(true);
+    m_listView->setLayoutMode(QListView::Batched);
+    m_listView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_layout->addWidget(m_listView);
+    
+    m_countLabel = new QLabel;
+    m_countLabel->setProperty("class", "model-picker-count");
+    m_layout->addWidget(m_countLabel);
+    
+    connect(m_searchEdit, &QLineEdit::textChanged, this, &ModelPickerWidget::updateResults);
+    connect(m_providerComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ModelPickerWidget::updateResults);
+    connect(m_contextComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ModelPickerWidget::updateResults);
+    connect(m_priceComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &ModelPickerWidget::updateResults);
+    connect(m_imagesCheckBox, &QCheckBox::toggled, this, &ModelPickerWidget::updateResults);
+    connect(m_listView->selectionModel(), &QItemSelectionModel::currentChanged, this, &ModelPickerWidget::onCurrentChanged);
+}
+
+void ModelPickerWidget::setModelIndex(std::shared_ptr<const ModelIndex> index)
+{
+    m_index = std::move(index);
+    updateProviders();
+    updateResults();
+}
+
+void ModelPickerWidget::setCurrentModel(const QString& modelId)
+{
+    m_currentModelId = modelId;
+    
+    const int row = m_listModel->rowOf(modelId);
+    if (row >= 0) {
+        const QSignalBlocker blocker(m_listView->selectionModel());
+        m_listView->setCurrentIndex(m_listModel->index(row));
+        m_listView->scrollTo(m_listModel->index(row));
+    }
+}
+
+void ModelPickerWidget::updateProviders()
+{
+    const QString selected = m_providerComboBox->currentData().toString();
+    const QSignalBlocker blocker(m_providerComboBox);
+    
+    m_providerComboBox->clear();
+    m_providerComboBox->addItem("All providers", QString());
+    if (m_index) {
+        for (const QString& provider : m_index->providers()) {
+            m_providerComboBox->addItem(provider, provider);
+        }
+    }
+    
+    const int restored = m_providerComboBox->findData(selected);
+    m_providerComboBox->setCurrentIndex(restored >= 0 ? restored : 0);
+}
+
+ModelFilter ModelPickerWidget::currentFilter() const
+{
+    ModelFilter filter;
+    filter.provider = m_providerComboBox->currentData().toString();
+    filter.minContextLength = m_contextComboBox->currentData().toInt();
+    filter.maxPromptCost = m_priceComboBox->currentData().toDouble();
+    if (m_imagesCheckBox->isChecked()) {
+        filter.inputModality = "image";
+    }
+    return filter;
+}
+
+void ModelPickerWidget::updateResults()
+{
+    if (!m_index) {
+        m_listModel->setResults(nullptr, QVector<int>());
+        m_countLabel->clear();
+        return;
+    }
+    
+    const QVector<int> rows = m_index->search(m_searchEdit->text(), currentFilter());
+    m_listModel->setResults(m_index, rows);
+    m_countLabel->setText(QString("%1 of %2 models").arg(rows.size()).arg(m_index->size()));
+    
+    // Keep the current model highlighted when it survives the filter
+    setCurrentModel(m_currentModelId);
+}
+
+void ModelPickerWidget::onCurrentChanged(const QModelIndex &current)
+{
+    if (!current.isValid()) return;
+    
+    m_currentModelId = current.data(ModelListModel::ModelIdRole).toString();
+    emit modelSelected(m_currentModelId);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "ModelIndex.h"
+#include <QWidget>
+#include <QAbstractListModel>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLineEdit>
+#include <QListView>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QLabel>
+#include <memory>
+
+// List model over search results; rows are indices into a ModelIndex, so a
+// new query only replaces a vector of ints and the view asks for the rows it
+// actually paints
+class ModelListModel : public QAbstractListModel
+{
+public:
+    enum Roles {
+        ModelIdRole = Qt::UserRole + 1
+    };
+    
+    explicit ModelListModel(QObject *parent = nullptr);
+    
+    void setResults(std::shared_ptr<const ModelIndex> index, const QVector<int>& rows);
+    int rowOf(const QString& modelId) const;
+    
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+private:
+    std::shared_ptr<const ModelIndex> m_index;
+    QVector<int> m_rows;
+};
+
+// Type-to-filter model picker with provider, modality, price and context
+// length filters. Replaces a plain QComboBox, which has to create an item
+// for every model up front.
+class ModelPickerWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ModelPickerWidget(QWidget *parent = nullptr);
+    
+    void setModelIndex(std::shared_ptr<const ModelIndex> index);
+    void setCurrentModel(const QString& modelId);
+    QString currentModel() const { return m_currentModelId; }
+
+signals:
+    void modelSelected(const QString& modelId);
+
+private slots:
+    void updateResults();
+    void onCurrentChanged(const QModelIndex &current);
+
+private:
+    void setupUI();
+    void updateProviders();
+    ModelFilter currentFilter() const;
+    
+    std::shared_ptr<const ModelIndex> m_index;
+    QString m_currentModelId;
+    
+    QVBoxLayout *m_layout;
+    QLineEdit *m_searchEdit;
+    QComboBox *m_providerComboBox;
+    QComboBox *m_contextComboBox;
+    QComboBox *m_priceComboBox;
+    QCheckBox *m_imagesCheckBox;
+    QListView *m_listView;
+    ModelListModel *m_listModel;
+    QLabel *m_countLabel;
+};
@@ -0,0 +1,92 @@
+#include "NetworkService.h"
+#include <QSslConfiguration>
+
+NetworkService::NetworkService(QObject *parent)
+    : QObject(parent)
+{
+    m_manager = new QNetworkAccessManager(this);
+}
+
+NetworkService::~NetworkService() = default;
+
+QNetworkReply* NetworkService::get(QNetworkRequest request, Priority priority)
+{
+    prepareRequest(request, priority);
+    
+    QNetworkReply* reply = m_manager->get(request);
+    trackReply(reply);
+    return reply;
+}
+
+QNetworkReply* NetworkService::post(QNetworkRequest request, const QByteArray& body, Priority priority)
+{
+    prepareRequest(request, priority);
+    
+    QNetworkReply* reply = m_manager->post(request, body);
+    trackReply(reply);
+    return reply;
+}
+
+void NetworkService::prewarm(const QUrl& url)
+{
+    if (!url.isValid() || url.host().isEmpty()) return;
+    
+    if (url.scheme() == "https") {
+        // Offer h2 during the handshake, as requests do, so the warmed
+        // connection is the multiplexed one they go on to use
+        QSslConfiguration ssl = QSslConfiguration::defaultConfiguration();
+        ssl.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2, QSslConfiguration::NextProtocolHttp1_1});
+        m_manager->connectToHostEncrypted(url.host(), static_cast<quint16>(url.port(443)), ssl);
+    } else {
+        m_manager->connectToHost(url.host(), static_cast<quint16>(url.port(80)));
+    }
+    
+    m_stats.prewarmedConnections++;
+    emit statsChanged();
+}
+
+void NetworkService::prepareRequest(QNetworkRequest& request, Priority priority) const
+{
+    // Let concurrent streams share one multiplexed connection
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    
+    switch (priority) {
+        case Priority::Interactive:
+            request.setPriority(QNetworkRequest::HighPriority);
+            break;
+        case Priority::Normal:
+            request.setPriority(QNetworkRequest::NormalPriority);
+            break;
+        case Priority::Background:
+            request.setPriority(QNetworkRequest::LowPriority);
+            break;
+    }
+}
+
+void NetworkService::trackReply(QNetworkReply* reply)
+{
+    m_stats.totalRequests++;
+    m_stats.activeRequests++;
+    
+    connect(reply, &QNetworkReply::encrypted, this, [this, reply]() {
+        reply->setProperty("newConnection", true);
+    });
+    
+    connect(reply, &QNetworkReply::finished, this, [this, reply]() {
+        m_stats.activeRequests--;
+        
+        if (reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool()) {
+            m_stats.http2Responses++;
+        }
+        
+        if (reply->property("newConnection").toBool()) {
+            m_stats.newConnections++;
+        } else if (reply->error() == QNetworkReply::NoError) {
+            m_stats.reusedConnections++;
+        }
+        
+        emit statsChanged();
+    });
+    
+    emit statsChanged();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <QObject>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#include <QByteArray>
+#include <QUrl>
+#include <QSet>
+
+// Connection pool usage across every request made through the service
+struct NetworkStats {
+    int totalRequests = 0;
+    int activeRequests = 0;
+    int http2Responses = 0;
+    int newConnections = 0;      // Requests that performed their own TLS handshake
+    int reusedConnections = 0;   // Completed requests that rode an existing connection
+    int prewarmedConnections = 0;
+};
+
+// HTTP stack with HTTP/2 enabled, so concurrent streams to the same host can
+// be multiplexed over a single TLS connection.
+//
+// There are deliberately two instances rather than one for the whole app:
+// the GUI-thread instance shared by OpenRouterAPI and FileManager carries
+// the models list and file downloads, and ChatNetworkCore owns a second one
+// on the network thread for chat completions, since a QNetworkAccessManager
+// only serves the thread that created it. Chat streams therefore do not
+// share a pool with those requests, and each instance reports its own
+// stats (OpenRouterAPI::getChatNetworkStats / getSharedNetworkStats).
+class NetworkService : public QObject {
+    Q_OBJECT
+
+public:
+    enum class Priority {
+        Interactive,
+        Normal,
+        Background
+    };
+    
+    explicit NetworkService(QObject *parent = nullptr);
+    ~NetworkService();
+    
+    // Requests
+    QNetworkReply* get(QNetworkRequest request, Priority priority = Priority::Normal);
+    QNetworkReply* post(QNetworkRequest request, const QByteArray& body, Priority priority = Priority::Normal);
+    
+    // Connections
+    void prewarm(const QUrl& url);
+    
+    // Statistics
+    NetworkStats stats() const { return m_stats; }
+    
+    QNetworkAccessManager* manager() const { return m_manager; }
+
+signals:
+    void statsChanged();
+
+private:
+    void prepareRequest(QNetworkRequest& request, Priority priority) const;
+    void trackReply(QNetworkReply* reply);
+    
+    QNetworkAccessManager *m_manager;
+    NetworkStats m_stats;
+};
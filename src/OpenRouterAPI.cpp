@@ -1,4 +1,5 @@
 #include "OpenRouterAPI.h"
+#include "AttachmentEncoder.h"
 #include <QNetworkRequest>
 #include <QNetworkReply>
 #include <QJsonDocument>
@@ -10,12 +11,70 @@
 #include <QUrl>
 #include <QUrlQuery>
 
-OpenRouterAPI::OpenRouterAPI(QObject *parent)
+OpenRouterAPI::OpenRouterAPI(NetworkService *network, QObject *parent)
     : QObject(parent)
+    , m_network(network)
 {
-    m_networkManager = new QNetworkAccessManager(this);
-    m_streamTimer = new QTimer(this);
-    m_streamTimer->setSingleShot(false);
+    // Fall back to a private stack when no shared one is provided
+    if (!m_network) {
+        m_network = new NetworkService(this);
+    }
+    
+    // Chat requests stream on their own thread; its signals arrive queued
+    qRegisterMetaType<RequestTimeline>();
+    m_coreThread = new QThread(this);
+    m_coreThread->setObjectName("ChatNetworkCore");
+    m_core = new ChatNetworkCore;
+    m_core->moveToThread(m_coreThread);
+    connect(m_coreThread, &QThread::started, m_core, &ChatNetworkCore::initialize);
+    connect(m_coreThread, &QThread::finished, m_core, &QObject::deleteLater);
+    connect(m_core, &ChatNetworkCore::deltaReady, this, &OpenRouterAPI::onDeltaReady);
+    connect(m_core, &ChatNetworkCore::requestFinished, this, &OpenRouterAPI::onRequestFinished);
+    connect(m_core, &ChatNetworkCore::streamCompleted, this, &OpenRouterAPI::onStreamCompleted);
+    connect(m_core, &ChatNetworkCore::streamError, this, [this](RequestId requestId, const QString& error) {
+        // A reply that reported an error is never replayed
+        m_cacheWrites.remove(requestId);
+        emit streamError(requestId, error);
+    });
+    connect(m_core, &ChatNetworkCore::firstTokenReceived, this, &OpenRouterAPI::firstTokenReceived);
+    connect(m_core, &ChatNetworkCore::requestRetrying, this, &OpenRouterAPI::requestRetrying);
+    connect(m_core, &ChatNetworkCore::promptCacheUsage, this, &OpenRouterAPI::promptCacheUsage);
+    connect(m_core, &ChatNetworkCore::requestQueued, this, [this](RequestId requestId, int waitMs, const QString& reason) {
+        if (!m_activeRequests.contains(requestId)) return;
+        m_queuedRequests.insert(requestId);
+        emit requestQueued(requestId, waitMs, reason);
+    });
+    connect(m_core, &ChatNetworkCore::requestDispatched, this, [this](RequestId requestId) {
+        m_queuedRequests.remove(requestId);
+        emit requestDispatched(requestId);
+    });
+    m_coreThread->start();
+    
+    // The models list is parsed off the GUI thread as it downloads
+    qRegisterMetaType<std::shared_ptr<const ModelIndex>>();
+    m_catalogThread = new QThread(this);
+    m_catalogThread->setObjectName("ModelCatalogLoader");
+    m_catalogLoader = new ModelCatalogLoader;
+    m_catalogLoader->moveToThread(m_catalogThread);
+    connect(m_catalogThread, &QThread::finished, m_catalogLoader, &QObject::deleteLater);
+    connect(m_catalogLoader, &ModelCatalogLoader::catalogueUpdated, this, &OpenRouterAPI::onCatalogueUpdated);
+    connect(m_catalogLoader, &ModelCatalogLoader::catalogueMerged, this, &OpenRouterAPI::onCatalogueMerged);
+    connect(m_catalogLoader, &ModelCatalogLoader::failed, this, &OpenRouterAPI::onCatalogueFailed);
+    m_catalogThread->start();
+    
+    updateDefaultBackend();
+    
+    // Counts fall back to a length heuristic until a vocabulary is loaded
+    m_tokenizer = std::make_shared<Tokenizer>();
+    m_budgeter.setTokenizer(m_tokenizer);
+    
+    ChatNetworkCore* core = m_core;
+    const QString baseUrl = m_baseURL;
+    std::shared_ptr<const Tokenizer> tokenizer = m_tokenizer;
+    QMetaObject::invokeMethod(core, [core, baseUrl, tokenizer]() {
+        core->setEndpoint(baseUrl);
+        core->setTokenizer(tokenizer);
+    }, Qt::QueuedConnection);
     
     // Configure SSL
     QSslConfiguration sslConfig = QSslConfiguration::defaultConfiguration();
@@ -28,16 +87,27 @@ OpenRouterAPI::OpenRouterAPI(QObject *parent)
 
 OpenRouterAPI::~OpenRouterAPI()
 {
-    if (m_currentReply) {
-        m_currentReply->abort();
-        m_currentReply->deleteLater();
-    }
+    // The core aborts whatever is still streaming as it is destroyed
+    m_core->disconnect(this);
+    m_coreThread->quit();
+    m_coreThread->wait();
+    
+    m_catalogThread->quit();
+    m_catalogThread->wait();
 }
 
 void OpenRouterAPI::setAPIKey(const QString& apiKey)
 {
     m_apiKey = apiKey;
+    updateDefaultBackend();
     emit connectionStatusChanged(!apiKey.isEmpty());
+    
+    // Warm only once requests can be authorized
+    ChatNetworkCore* core = m_core;
+    const bool keepWarm = !m_apiKey.isEmpty();
+    QMetaObject::invokeMethod(core, [core, keepWarm]() {
+        core->setKeepWarm(keepWarm);
+    }, Qt::QueuedConnection);
 }
 
 void OpenRouterAPI::setModel(const QString& modelId)
@@ -47,344 +117,922 @@ void OpenRouterAPI::setModel(const QString& modelId)
 
 void OpenRouterAPI::setBaseURL(const QString& url)
 {
+    if (m_baseURL == url) return;
+    
     m_baseURL = url;
+    updateDefaultBackend();
+    ChatNetworkCore* core = m_core;
+    QMetaObject::invokeMethod(core, [core, url]() {
+        core->setEndpoint(url);
+    }, Qt::QueuedConnection);
 }
 
-void OpenRouterAPI::refreshModels()
+void OpenRouterAPI::setStreamFlushInterval(int milliseconds)
 {
-    if (m_apiKey.isEmpty()) {
-        qWarning() << "Cannot refresh models: API key not set";
-        emit modelsRefreshed(false);
-        return;
+    ChatNetworkCore* core = m_core;
+    QMetaObject::invokeMethod(core, [core, milliseconds]() {
+        core->setFlushInterval(milliseconds);
+    }, Qt::QueuedConnection);
+}
+
+void OpenRouterAPI::setOutputReserve(int tokens)
+{
+    m_budgeter.setOutputReserve(tokens);
+}
+
+bool OpenRouterAPI::loadTokenizer(const QString& directory)
+{
+    if (m_tokenizer->isLoaded() && directory == m_tokenizerDirectory) {
+        return true;
     }
     
-    QUrl url(m_baseURL + "/models");
-    QNetworkRequest request = createRequest(url.toString());
+    // Load into a fresh instance so a tokenizer that is already shared is never mutated
+    auto tokenizer = std::make_shared<Tokenizer>();
+    if (!tokenizer->load(directory)) {
+        return false;
+    }
     
-    QNetworkReply* reply = m_networkManager->get(request);
-    connect(reply, &QNetworkReply::finished, this, &OpenRouterAPI::onModelsReplyFinished);
-    connect(reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::errorOccurred),
-            this, &OpenRouterAPI::onNetworkError);
+    m_tokenizer = tokenizer;
+    m_tokenizerDirectory = directory;
+    m_budgeter.setTokenizer(tokenizer);
+    
+    // Counts are thread-safe; the core uses the same instance for replies
+    ChatNetworkCore* core = m_core;
+    std::shared_ptr<const Tokenizer> shared = tokenizer;
+    QMetaObject::invokeMethod(core, [core, shared]() {
+        core->setTokenizer(shared);
+    }, Qt::QueuedConnection);
+    return true;
 }
 
-const ModelInfo* OpenRouterAPI::getCurrentModel() const
+void OpenRouterAPI::setPromptCachingEnabled(bool enabled)
 {
-    for (const auto& model : m_models) {
-        if (model.id == m_modelId) {
-            return &model;
-        }
+    m_promptCaching = enabled;
+}
+
+void OpenRouterAPI::setTemperature(double temperature)
+{
+    m_temperature = qBound(0.0, temperature, 2.0);
+}
+
+void OpenRouterAPI::setResponseCacheEnabled(bool enabled, bool includeSampled)
+{
+    m_responseCacheEnabled = enabled;
+    m_cacheSampledResponses = includeSampled;
+}
+
+void OpenRouterAPI::setResponseCacheSize(qint64 maxBytes)
+{
+    m_responseCache.setMaxBytes(maxBytes);
+}
+
+void OpenRouterAPI::clearResponseCache()
+{
+    m_responseCache.clear();
+}
+
+void OpenRouterAPI::setRequestTimeout(int seconds)
+{
+    ChatNetworkCore* core = m_core;
+    QMetaObject::invokeMethod(core, [core, seconds]() {
+        core->setRequestTimeout(seconds);
+    }, Qt::QueuedConnection);
+}
+
+void OpenRouterAPI::setStallTimeout(int seconds)
+{
+    ChatNetworkCore* core = m_core;
+    QMetaObject::invokeMethod(core, [core, seconds]() {
+        core->setStallTimeout(seconds);
+    }, Qt::QueuedConnection);
+}
+
+void OpenRouterAPI::setMaxRetries(int retries)
+{
+    ChatNetworkCore* core = m_core;
+    QMetaObject::invokeMethod(core, [core, retries]() {
+        core->setMaxRetries(retries);
+    }, Qt::QueuedConnection);
+}
+
+void OpenRouterAPI::setRateLimits(int requestsPerMinute, int requestsPerMinutePerModel)
+{
+    ChatNetworkCore* core = m_core;
+    QMetaObject::invokeMethod(core, [core, requestsPerMinute, requestsPerMinutePerModel]() {
+        core->setRateLimits(requestsPerMinute, requestsPerMinutePerModel);
+    }, Qt::QueuedConnection);
+}
+
+int OpenRouterAPI::streamTokenCount(RequestId requestId) const
+{
+    return m_activeRequests.value(requestId, 0);
+}
+
+void OpenRouterAPI::prewarmConnection()
+{
+    ChatNetworkCore* core = m_core;
+    QMetaObject::invokeMethod(core, [core]() {
+        core->prewarm();
+    }, Qt::QueuedConnection);
+}
+
+bool OpenRouterAPI::isConnectionWarm() const
+{
+    return m_core->isConnectionWarm();
+}
+
+void OpenRouterAPI::setCacheDirectory(const QString& path, bool waitForModels)
+{
+    m_cacheDirectory = path;
+    m_responseCache.setDirectory(path + "/responses");
+    
+    // Cached catalogue replaces the built-in defaults until the next refresh;
+    // it is parsed and indexed on the loader's thread
+    ModelCatalogLoader* loader = m_catalogLoader;
+    const QString cachePath = modelsCachePath();
+    m_modelsCacheLoading = true;
+    if (waitForModels) {
+        LoadedModelCatalogue loaded;
+        QMetaObject::invokeMethod(loader, [&loaded, loader, cachePath]() {
+            loaded = loader->loadCache(cachePath);
+        }, Qt::BlockingQueuedConnection);
+        onModelsCacheLoaded(loaded);
+        return;
     }
-    return nullptr;
+    
+    // The destructor joins the loader thread before this object goes away
+    QMetaObject::invokeMethod(loader, [this, loader, cachePath]() {
+        const LoadedModelCatalogue loaded = loader->loadCache(cachePath);
+        QMetaObject::invokeMethod(this, [this, loaded]() {
+            onModelsCacheLoaded(loaded);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
 }
 
-void OpenRouterAPI::sendMessage(const std::vector<Message>& conversation)
+void OpenRouterAPI::refreshModels(bool force)
 {
+    // Wait for the cached catalogue; it may make the request unnecessary
+    // and carries the validators for a conditional one
+    if (m_modelsCacheLoading) {
+        m_modelsRefreshDeferred = true;
+        m_modelsRefreshForced = m_modelsRefreshForced || force;
+        return;
+    }
+    
+    // Local servers are cheap to ask, so their lists are always refreshed
+    refreshBackendModels();
+    
     if (m_apiKey.isEmpty()) {
-        emit streamError("API key not configured");
+        if (m_backends.isEmpty()) {
+            qWarning() << "Cannot refresh models: API key not set";
+            emit modelsRefreshed(false);
+        }
         return;
     }
     
-    if (m_requestActive) {
-        qWarning() << "Request already in progress";
+    if (m_modelsRefreshPending) {
         return;
     }
     
-    m_requestActive = true;
-    m_shouldStop = false;
-    m_streamStartTime = std::chrono::steady_clock::now();
-    m_tokenCount = 0;
+    // A recent catalogue is good enough; the model list changes slowly
+    if (!force && m_modelsFetchedAt.isValid()
+        && m_modelsFetchedAt.secsTo(QDateTime::currentDateTimeUtc()) < MODELS_CACHE_TTL_SECONDS) {
+        return;
+    }
     
-    QUrl url(m_baseURL + "/chat/completions");
-    QNetworkRequest request = createRequest(url.toString());
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    QNetworkRequest request = createRequest(m_defaultBackend->modelsUrl().toString());
     
-    QJsonObject payload = prepareRequestPayload(conversation);
-    QJsonDocument doc(payload);
+    // Conditional request: an unchanged catalogue costs a 304 and no parsing
+    if (m_modelsFetchedAt.isValid()) {
+        if (!m_modelsETag.isEmpty()) {
+            request.setRawHeader("If-None-Match", m_modelsETag);
+        }
+        if (!m_modelsLastModified.isEmpty()) {
+            request.setRawHeader("If-Modified-Since", m_modelsLastModified);
+        }
+    }
     
-    m_currentReply = m_networkManager->post(request, doc.toJson());
+    m_modelsRefreshPending = true;
     
-    connect(m_currentReply, &QNetworkReply::readyRead, this, &OpenRouterAPI::onChatReplyReadyRead);
-    connect(m_currentReply, &QNetworkReply::finished, this, &OpenRouterAPI::onChatReplyFinished);
-    connect(m_currentReply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::errorOccurred),
+    std::shared_ptr<const ModelIndex> previous = m_remoteCatalog;
+    ModelCatalogLoader* loader = m_catalogLoader;
+    QMetaObject::invokeMethod(loader, [loader, previous]() {
+        loader->begin(previous);
+    }, Qt::QueuedConnection);
+    
+    QNetworkReply* reply = m_network->get(request, NetworkService::Priority::Normal);
+    connect(reply, &QNetworkReply::readyRead, this, [reply, loader]() {
+        // Only a full 200 response carries a catalogue; errors and 304s are handled on finish
+        if (reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() != 200) return;
+        const QByteArray data = reply->readAll();
+        QMetaObject::invokeMethod(loader, [loader, data]() {
+            loader->feed(data);
+        }, Qt::QueuedConnection);
+    });
+    connect(reply, &QNetworkReply::finished, this, &OpenRouterAPI::onModelsReplyFinished);
+    connect(reply, QOverload<QNetworkReply::NetworkError>::of(&QNetworkReply::errorOccurred),
             this, &OpenRouterAPI::onNetworkError);
 }
 
-void OpenRouterAPI::stopCurrentRequest()
+const ModelInfo* OpenRouterAPI::getCurrentModel() const
 {
-    m_shouldStop = true;
-    if (m_currentReply) {
-        m_currentReply->abort();
-    }
+    // Valid until the next catalogue swap, which only happens on this thread
+    return modelIndex()->find(m_modelId);
 }
 
-QNetworkRequest OpenRouterAPI::createRequest(const QString& endpoint)
+void OpenRouterAPI::setModels(std::vector<ModelInfo> models)
 {
-    QNetworkRequest request;
-    request.setUrl(QUrl(endpoint));
-    request.setRawHeader("Authorization", QString("Bearer %1").arg(m_apiKey).toUtf8());
-    request.setRawHeader("User-Agent", "Chatty/1.0.0");
-    request.setRawHeader("Accept", "application/json");
+    // Only the few built-in defaults come through here, before any backend
+    // is configured, so there is nothing to merge yet
+    m_remoteCatalog = std::make_shared<const ModelIndex>(std::move(models));
+    std::atomic_store(&m_catalog, m_remoteCatalog);
     
-    return request;
+    ModelCatalogLoader* loader = m_catalogLoader;
+    std::shared_ptr<const ModelIndex> remote = m_remoteCatalog;
+    QMetaObject::invokeMethod(loader, [loader, remote]() {
+        loader->setRemote(remote);
+    }, Qt::QueuedConnection);
 }
 
-QJsonObject OpenRouterAPI::prepareRequestPayload(const std::vector<Message>& conversation)
+void OpenRouterAPI::publishCatalogue()
 {
-    QJsonObject payload;
-    payload["model"] = m_modelId;
-    payload["stream"] = true;
-    payload["temperature"] = 0.7;
-    payload["max_tokens"] = 2048;
+    // The loader merges these with the remote catalogue and reports back
+    // through onCatalogueMerged
+    std::vector<ModelInfo> models;
+    for (auto it = m_backendModels.cbegin(); it != m_backendModels.cend(); ++it) {
+        models.insert(models.end(), it->begin(), it->end());
+    }
     
-    QJsonArray messages;
-    for (const auto& msg : conversation) {
-        QJsonObject messageObj;
-        
-        // Convert role
-        switch (msg.role) {
-            case MessageRole::User:
-                messageObj["role"] = "user";
-                break;
-            case MessageRole::Assistant:
-                messageObj["role"] = "assistant";
-                break;
-            case MessageRole::System:
-                messageObj["role"] = "system";
-                break;
+    ModelCatalogLoader* loader = m_catalogLoader;
+    QMetaObject::invokeMethod(loader, [loader, models = std::move(models)]() mutable {
+        loader->setLocalModels(std::move(models));
+    }, Qt::QueuedConnection);
+}
+
+void OpenRouterAPI::updateDefaultBackend()
+{
+    BackendConfig config;
+    config.id = "openrouter";
+    config.name = "OpenRouter";
+    config.kind = BackendKind::OpenRouter;
+    config.baseUrl = m_baseURL;
+    config.apiKey = m_apiKey;
+    m_defaultBackend = ChatBackend::create(config);
+}
+
+void OpenRouterAPI::setBackends(const std::vector<BackendConfig>& backends)
+{
+    m_backends.clear();
+    for (const BackendConfig& config : backends) {
+        if (!config.enabled || config.baseUrl.isEmpty()) continue;
+        if (!BackendConfig::isValidId(config.id)) {
+            qWarning() << "Ignoring backend with invalid or reserved id:" << config.id;
+            continue;
         }
-        
-        // Add content
-        if (msg.attachments.empty()) {
-            messageObj["content"] = msg.content;
+        if (m_backends.contains(config.id)) {
+            qWarning() << "Ignoring backend with duplicate id:" << config.id;
+            continue;
+        }
+        m_backends.insert(config.id, ChatBackend::create(config));
+    }
+    
+    // Forget models of backends that are gone
+    for (auto it = m_backendModels.begin(); it != m_backendModels.end();) {
+        if (m_backends.contains(it.key())) {
+            ++it;
         } else {
-            // Handle multimodal content (text + images)
-            QJsonArray contentArray;
+            it = m_backendModels.erase(it);
+        }
+    }
+    publishCatalogue();
+}
+
+std::shared_ptr<const ChatBackend> OpenRouterAPI::backendForModel(const QString& modelId) const
+{
+    // "local:<backend id>/<model>" for configured backends; anything else is OpenRouter's
+    const QString backendId = ChatBackend::backendIdOf(modelId);
+    return backendId.isEmpty() ? m_defaultBackend : m_backends.value(backendId, m_defaultBackend);
+}
+
+void OpenRouterAPI::refreshBackendModels()
+{
+    for (const std::shared_ptr<const ChatBackend>& backend : std::as_const(m_backends)) {
+        QNetworkRequest request(backend->modelsUrl());
+        backend->prepareRequest(request);
+        
+        QNetworkReply* reply = m_network->get(request, NetworkService::Priority::Normal);
+        connect(reply, &QNetworkReply::finished, this, [this, reply, backend]() {
+            reply->deleteLater();
+            const QString backendId = backend->config().id;
+            if (m_backends.value(backendId) != backend) return; // Reconfigured meanwhile
             
-            // Add text content
-            if (!msg.content.isEmpty()) {
-                QJsonObject textContent;
-                textContent["type"] = "text";
-                textContent["text"] = msg.content;
-                contentArray.append(textContent);
+            std::vector<ModelInfo> models;
+            if (reply->error() != QNetworkReply::NoError || !backend->parseModels(reply->readAll(), models)) {
+                qWarning() << "Cannot list models on" << backend->config().name << ":" << reply->errorString();
+                return;
             }
             
-            // Add image attachments
-            for (const auto& attachment : msg.attachments) {
-                if (attachment->isImage && !attachment->data.isEmpty()) {
-                    QJsonObject imageContent;
-                    imageContent["type"] = "image_url";
-                    
-                    QJsonObject imageUrl;
-                    QString base64Data = QString("data:%1;base64,%2")
-                        .arg(attachment->mimeType)
-                        .arg(QString::fromLatin1(attachment->data.toBase64()));
-                    imageUrl["url"] = base64Data;
-                    
-                    imageContent["image_url"] = imageUrl;
-                    contentArray.append(imageContent);
+            // Listed as "local:<backend id>/<model>" under the backend's name
+            for (ModelInfo& model : models) {
+                model.id = backend->qualifiedModelId(model.id);
+                model.provider = backendId;
+                if (!backend->config().name.isEmpty()) {
+                    model.description = model.description.isEmpty()
+                        ? backend->config().name
+                        : backend->config().name + " - " + model.description;
                 }
             }
-            
-            messageObj["content"] = contentArray;
+            m_backendModels.insert(backendId, std::move(models));
+            publishCatalogue();
+        });
+    }
+}
+
+RequestId OpenRouterAPI::sendMessage(const std::vector<Message>& conversation, const QString& modelId,
+                                     NetworkService::Priority priority)
+{
+    const RequestId requestId = m_nextRequestId++;
+    const QString targetModel = modelId.isEmpty() ? m_modelId : modelId;
+    std::shared_ptr<const ChatBackend> backend = backendForModel(targetModel);
+    const BackendCapabilities capabilities = backend->capabilities();
+    
+    if (capabilities.requiresApiKey && backend->config().apiKey.isEmpty()) {
+        // Report asynchronously so the caller can store the handle first;
+        // completes like any failed request
+        QMetaObject::invokeMethod(this, [this, requestId]() {
+            emit streamError(requestId, "API key not configured");
+            emit streamCompleted(requestId, false);
+        }, Qt::QueuedConnection);
+        return requestId;
+    }
+    
+    ChatRequest chat;
+    chat.id = requestId;
+    chat.modelId = targetModel;
+    chat.priority = priority;
+    chat.backend = backend;
+    chat.requestTimeoutSeconds = backend->config().requestTimeout;
+    chat.startTime = std::chrono::steady_clock::now();
+    chat.queuedAt = QDateTime::currentDateTime();
+    
+    QNetworkRequest request(backend->chatUrl());
+    backend->prepareRequest(request);
+    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    
+    // Fit the history into the model's window, leaving room for the reply.
+    // With prompt caching, trim in whole quanta so the prefix stays stable.
+    std::shared_ptr<const ModelIndex> catalogue = modelIndex();
+    const ModelInfo* model = catalogue->find(chat.modelId);
+    const bool promptCaching = m_promptCaching && capabilities.promptCaching && supportsPromptCaching(chat.modelId);
+    m_budgeter.setContextWindow(model ? model->maxTokens : 0);
+    m_budgeter.setTrimQuantum(promptCaching ? CACHE_HISTORY_QUANTUM : 1);
+    ContextBudget budget = m_budgeter.apply(withoutReplyPlaceholders(conversation));
+    chat.promptTokens = budget.estimatedPromptTokens;
+    chat.costPerToken = model ? model->costPerToken : 0.0;
+    chat.completionCostPerToken = model ? model->completionCostPerToken : 0.0;
+    
+    if (budget.trimmed()) {
+        // Queued so the caller has stored the handle before it arrives
+        const int dropped = budget.droppedMessages;
+        const int images = budget.elidedImages;
+        const int tokens = budget.estimatedPromptTokens;
+        QMetaObject::invokeMethod(this, [this, requestId, dropped, images, tokens]() {
+            emit contextTrimmed(requestId, dropped, images, tokens);
+        }, Qt::QueuedConnection);
+    }
+    
+    // Kept so the request can be replayed if it fails before any content
+    chat.request = request;
+    chat.payload = prepareRequestPayload(*backend, backend->wireModelId(chat.modelId), budget.messages,
+                                         budget.maxOutputTokens,
+                                         promptCaching ? cacheBreakpoints(budget.messages) : QSet<int>());
+    
+    // The payload is canonical (sorted keys, cached fragments), so the same
+    // model, messages and parameters always hash to the same entry
+    if (m_responseCacheEnabled && (m_temperature <= 0.0 || m_cacheSampledResponses)) {
+        const QByteArray key = ResponseCache::key(backend->chatUrl().toEncoded(), chat.payload);
+        CachedResponse cached;
+        if (m_responseCache.lookup(key, cached)) {
+            replayCachedResponse(requestId, cached);
+            return requestId;
         }
         
-        messages.append(messageObj);
+        PendingCacheWrite pending;
+        pending.key = key;
+        pending.response.modelId = chat.modelId;
+        pending.response.promptTokens = chat.promptTokens;
+        m_cacheWrites.insert(requestId, pending);
     }
     
-    payload["messages"] = messages;
+    m_activeRequests.insert(requestId, 0);
     
-    return payload;
+    ChatNetworkCore* core = m_core;
+    QMetaObject::invokeMethod(core, [core, chat]() {
+        core->start(chat);
+    }, Qt::QueuedConnection);
+    
+    return requestId;
 }
 
-void OpenRouterAPI::onModelsReplyFinished()
+std::vector<Message> OpenRouterAPI::withoutReplyPlaceholders(const std::vector<Message>& conversation)
 {
-    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
-    if (!reply) return;
-    
-    bool success = false;
+    // The chat view appends an empty assistant message to stream into before
+    // sending; it is not part of the prompt
+    size_t end = conversation.size();
+    while (end > 0 && conversation[end - 1].isFromAssistant() &&
+           conversation[end - 1].content.isEmpty() && conversation[end - 1].attachments.empty()) {
+        --end;
+    }
+    return std::vector<Message>(conversation.begin(), conversation.begin() + end);
+}
+
+QVector<RequestId> OpenRouterAPI::sendFanOut(const std::vector<Message>& conversation, const QStringList& modelIds)
+{
+    // Every request shares the cached message fragments, so the history is
+    // serialized once; only the small per-model header differs. All requests
+    // go out before any reply is processed and run concurrently.
+    QVector<RequestId> requestIds;
+    requestIds.reserve(modelIds.size());
+    for (const QString& modelId : modelIds) {
+        requestIds.append(sendMessage(conversation, modelId));
+    }
+    return requestIds;
+}
+
+void OpenRouterAPI::stopRequest(RequestId requestId)
+{
+    if (!m_activeRequests.contains(requestId)) return;
     
-    if (reply->error() == QNetworkReply::NoError) {
-        QByteArray data = reply->readAll();
-        success = parseModelsResponse(data);
-    } else {
-        qWarning() << "Models request failed:" << reply->errorString();
+    // A cache replay never reached the core; it is cancelled here, completing
+    // as unsuccessful like a stopped live request (and just as asynchronously)
+    if (m_replays.remove(requestId)) {
+        QMetaObject::invokeMethod(this, [this, requestId]() {
+            emit streamCompleted(requestId, false);
+            m_activeRequests.remove(requestId);
+        }, Qt::QueuedConnection);
+        return;
     }
     
-    emit modelsRefreshed(success);
-    reply->deleteLater();
+    // Completion (with success = false) comes back from the core
+    ChatNetworkCore* core = m_core;
+    QMetaObject::invokeMethod(core, [core, requestId]() {
+        core->stop(requestId);
+    }, Qt::QueuedConnection);
 }
 
-void OpenRouterAPI::onChatReplyFinished()
+void OpenRouterAPI::stopAllRequests()
 {
-    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
-    if (!reply) return;
+    const QSet<RequestId> replays = m_replays;
+    for (RequestId requestId : replays) {
+        stopRequest(requestId);
+    }
     
-    m_requestActive = false;
+    ChatNetworkCore* core = m_core;
+    QMetaObject::invokeMethod(core, [core]() {
+        core->stopAll();
+    }, Qt::QueuedConnection);
+}
+
+void OpenRouterAPI::onDeltaReady(RequestId requestId, const QString& content, int tokenCount)
+{
+    // Stopped on this side while the delta was in flight
+    if (!m_activeRequests.contains(requestId)) return;
     
-    bool success = (reply->error() == QNetworkReply::NoError && !m_shouldStop);
+    m_activeRequests[requestId] = tokenCount;
+    auto pending = m_cacheWrites.find(requestId);
+    if (pending != m_cacheWrites.end()) {
+        pending->response.content += content;
+    }
+    emit streamReceived(requestId, content);
+}
+
+void OpenRouterAPI::onRequestFinished(const RequestTimeline& timeline)
+{
+    // Final count, including any server-reported usage after the last delta
+    if (m_activeRequests.contains(timeline.requestId)) {
+        m_activeRequests[timeline.requestId] = timeline.tokenCount;
+    }
+    auto pending = m_cacheWrites.find(timeline.requestId);
+    if (pending != m_cacheWrites.end()) {
+        pending->response.completionTokens = timeline.tokenCount;
+        pending->complete = timeline.success && timeline.finishReason == QLatin1String("stop");
+    }
+    m_latency.record(timeline);
+    emit requestFinished(timeline);
+}
+
+void OpenRouterAPI::onStreamCompleted(RequestId requestId, bool success)
+{
+    m_queuedRequests.remove(requestId);
     
-    if (!success && reply->error() != QNetworkReply::OperationCanceledError) {
-        QString errorMsg = QString("Request failed: %1").arg(reply->errorString());
-        emit streamError(errorMsg);
+    // Only complete replies are kept; stopped, failed or truncated ones are dropped
+    PendingCacheWrite pending = m_cacheWrites.take(requestId);
+    if (success && pending.complete && !pending.key.isEmpty() && !pending.response.content.isEmpty()) {
+        pending.response.createdAt = QDateTime::currentDateTime();
+        m_responseCache.store(pending.key, pending.response);
     }
     
-    emit streamCompleted(success);
-    updateTokenStats();
+    // Listeners may still ask for the token count while handling the signal
+    emit streamCompleted(requestId, success);
+    m_activeRequests.remove(requestId);
+}
+
+void OpenRouterAPI::replayCachedResponse(RequestId requestId, const CachedResponse& response)
+{
+    m_activeRequests.insert(requestId, response.completionTokens);
+    m_replays.insert(requestId);
+    
+    // Through the same signals as a live reply, queued so the caller has
+    // stored the handle first. Marked before any content arrives.
+    QMetaObject::invokeMethod(this, [this, requestId, response]() {
+        if (!m_replays.remove(requestId)) return; // Stopped meanwhile
+        emit responseReplayed(requestId, response.createdAt);
+        emit firstTokenReceived(requestId, 0, true);
+        emit streamReceived(requestId, response.content);
+        emit streamCompleted(requestId, true);
+        m_activeRequests.remove(requestId);
+    }, Qt::QueuedConnection);
+}
+
+QNetworkRequest OpenRouterAPI::createRequest(const QString& endpoint)
+{
+    QNetworkRequest request;
+    request.setUrl(QUrl(endpoint));
+    m_defaultBackend->prepareRequest(request);
     
-    m_currentReply = nullptr;
-    reply->deleteLater();
+    return request;
 }
 
-void OpenRouterAPI::onChatReplyReadyRead()
+QByteArray OpenRouterAPI::prepareRequestPayload(const ChatBackend& backend, const QString& modelId,
+                                                const std::vector<Message>& conversation, int maxTokens,
+                                                const QSet<int>& cacheBreakpoints)
 {
-    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
-    if (!reply || m_shouldStop) return;
+    ++m_payloadGeneration;
+    
+    // Usage is requested with cache breakpoints, to read back cached-token counts
+    const QJsonObject payload = backend.payloadHeader(modelId, maxTokens, m_temperature, !cacheBreakpoints.isEmpty());
+    const PayloadDialect dialect = backend.capabilities().dialect;
     
-    QByteArray newData = reply->readAll();
-    m_streamBuffer.append(QString::fromUtf8(newData));
+    // Serialize the small header object and splice the cached message
+    // fragments in as the "messages" array, so unchanged history is copied
+    // rather than rebuilt and re-serialized on every turn
+    QByteArray body = QJsonDocument(payload).toJson(QJsonDocument::Compact);
+    body.chop(1); // Closing brace
     
-    // Process complete chunks
-    QStringList lines = m_streamBuffer.split('\n');
-    m_streamBuffer = lines.takeLast(); // Keep the incomplete line in buffer
+    // Bring every fragment up to date first; inserting may rehash the cache
+    qsizetype totalSize = body.size() + 16;
+    for (int i = 0; i < static_cast<int>(conversation.size()); ++i) {
+        totalSize += messageFragment(conversation[i], cacheBreakpoints.contains(i), dialect).size + 1;
+    }
     
-    for (const QString& line : lines) {
-        if (!line.isEmpty()) {
-            processStreamChunk(line.trimmed());
+    body.reserve(totalSize);
+    body.append(",\"messages\":[");
+    for (size_t i = 0; i < conversation.size(); ++i) {
+        if (i > 0) body.append(',');
+        for (const QByteArray& piece : m_fragmentCache.value(conversation[i].id).pieces) {
+            body.append(piece);
         }
     }
+    body.append("]}");
+    
+    pruneFragmentCache(conversation.size());
+    
+    return body;
 }
 
-void OpenRouterAPI::onNetworkError(QNetworkReply::NetworkError error)
+bool OpenRouterAPI::supportsPromptCaching(const QString& modelId)
 {
-    Q_UNUSED(error)
-    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
-    if (!reply) return;
+    // Providers that honour cache_control breakpoints through OpenRouter
+    return modelId.startsWith("anthropic/") || modelId.startsWith("google/gemini");
+}
+
+QSet<int> OpenRouterAPI::cacheBreakpoints(const std::vector<Message>& conversation) const
+{
+    QSet<int> breakpoints;
+    const int count = static_cast<int>(conversation.size());
+    if (count < 2) return breakpoints;
+    
+    auto cacheable = [&](int index) {
+        const Message& msg = conversation[index];
+        return !msg.content.isEmpty() || !msg.attachments.empty();
+    };
+    
+    // The system prompt, which never changes within a conversation
+    int lastSystem = -1;
+    for (int i = 0; i < count - 1 && conversation[i].isSystemMessage(); ++i) {
+        lastSystem = i;
+    }
+    if (lastSystem >= 0 && cacheable(lastSystem)) {
+        breakpoints.insert(lastSystem);
+    }
+    
+    // Nothing from the newest user turn on is marked; it changes every send
+    const int newestUser = ContextBudgeter::newestUserTurn(conversation);
     
-    QString errorMsg = QString("Network error: %1").arg(reply->errorString());
-    qWarning() << errorMsg;
+    // The most recent earlier message carrying a large attachment
+    for (int i = newestUser - 1; i > lastSystem; --i) {
+        qsizetype attachmentBytes = 0;
+        for (const auto& attachment : conversation[i].attachments) {
+            attachmentBytes += attachment->size;
+        }
+        if (attachmentBytes >= CACHE_LARGE_ATTACHMENT_BYTES && cacheable(i)) {
+            breakpoints.insert(i);
+            break;
+        }
+    }
     
-    if (reply == m_currentReply) {
-        m_requestActive = false;
-        emit streamError(errorMsg);
+    // Older history at fixed positions, so a marked message stays marked
+    // (and byte-identical) for CACHE_HISTORY_QUANTUM turns
+    for (int i = newestUser - 1; i > lastSystem && breakpoints.size() < MAX_CACHE_BREAKPOINTS; --i) {
+        if ((i + 1) % CACHE_HISTORY_QUANTUM == 0 && cacheable(i)) {
+            breakpoints.insert(i);
+        }
     }
+    
+    return breakpoints;
 }
 
-void OpenRouterAPI::processStreamChunk(const QString& chunk)
+void OpenRouterAPI::serializeMessage(const Message& msg, bool cacheBreakpoint, PayloadDialect dialect,
+                                     MessageFragment& fragment) const
 {
-    // Handle Server-Sent Events format
-    if (chunk.startsWith("data: ")) {
-        QString data = chunk.mid(6); // Remove "data: " prefix
-        
-        if (data == "[DONE]") {
-            // Stream finished
-            return;
-        }
-        
-        QJsonParseError error;
-        QJsonDocument doc = QJsonDocument::fromJson(data.toUtf8(), &error);
-        
-        if (error.error != QJsonParseError::NoError) {
-            qWarning() << "Failed to parse stream chunk:" << error.errorString();
-            return;
-        }
-        
-        QJsonObject obj = doc.object();
+    fragment.pieces.clear();
+    fragment.buffers.clear();
+    fragment.size = 0;
+    
+    // Convert role
+    QByteArray role;
+    switch (msg.role) {
+        case MessageRole::User:
+            role = "user";
+            break;
+        case MessageRole::Assistant:
+            role = "assistant";
+            break;
+        case MessageRole::System:
+            role = "system";
+            break;
+    }
+    
+    if (dialect == PayloadDialect::Ollama) {
+        // Plain content, with images as bare base64 in a separate array
+        QJsonObject messageObj;
+        messageObj["role"] = QString::fromLatin1(role);
+        messageObj["content"] = msg.content;
+        QByteArray json = QJsonDocument(messageObj).toJson(QJsonDocument::Compact);
         
-        if (obj.contains("choices")) {
-            QJsonArray choices = obj["choices"].toArray();
-            if (!choices.isEmpty()) {
-                QJsonObject choice = choices[0].toObject();
-                QJsonObject delta = choice["delta"].toObject();
-                
-                if (delta.contains("content")) {
-                    QString content = delta["content"].toString();
-                    if (!content.isEmpty()) {
-                        emit streamReceived(content);
-                        m_tokenCount++;
-                        updateTokenStats();
-                    }
-                }
+        bool first = true;
+        for (const auto& attachment : msg.attachments) {
+            if (!attachment->isImage || attachment->size == 0) continue;
+            
+            const QByteArray dataUrl = AttachmentEncoder::dataUrl(attachment);
+            if (first) {
+                json.chop(1); // Closing brace
+                fragment.append(json);
+                fragment.append(QByteArray(",\"images\":[\""));
+                first = false;
+            } else {
+                fragment.append(QByteArray(",\""));
             }
+            // Bare base64: the shared data URL past its "data:...," header
+            fragment.appendView(dataUrl, dataUrl.indexOf(',') + 1);
+            fragment.append(QByteArray("\""));
         }
-        
-        // Update usage statistics if available
-        if (obj.contains("usage")) {
-            QJsonObject usage = obj["usage"].toObject();
-            if (usage.contains("total_tokens")) {
-                m_totalTokensUsed = usage["total_tokens"].toInt();
-            }
+        fragment.append(first ? json : QByteArray("]}"));
+        return;
+    }
+    
+    if (msg.attachments.empty() && !cacheBreakpoint) {
+        QJsonObject messageObj;
+        messageObj["role"] = QString::fromLatin1(role);
+        messageObj["content"] = msg.content;
+        fragment.append(QJsonDocument(messageObj).toJson(QJsonDocument::Compact));
+        return;
+    }
+    
+    // Handle multimodal content (text + images), and cache breakpoints,
+    // which need the content-part form. The text part goes through
+    // QJsonDocument for escaping; image parts are spliced in around the
+    // pre-encoded data URL, which is plain ASCII and needs no escaping.
+    // A breakpoint is a cache_control marker on the last part.
+    std::vector<std::shared_ptr<Attachment>> images;
+    for (const auto& attachment : msg.attachments) {
+        if (attachment->isImage && attachment->size > 0) {
+            images.push_back(attachment);
         }
     }
+    
+    fragment.append("{\"role\":\"" + role + "\",\"content\":[");
+    
+    bool needsSeparator = false;
+    if (!msg.content.isEmpty() || images.empty()) {
+        QJsonObject textContent;
+        textContent["type"] = "text";
+        textContent["text"] = msg.content;
+        if (cacheBreakpoint && images.empty()) {
+            textContent["cache_control"] = QJsonObject{{"type", "ephemeral"}};
+        }
+        fragment.append(QJsonDocument(textContent).toJson(QJsonDocument::Compact));
+        needsSeparator = true;
+    }
+    
+    for (size_t i = 0; i < images.size(); ++i) {
+        fragment.append(needsSeparator ? QByteArray(",{\"type\":\"image_url\",\"image_url\":{\"url\":\"")
+                                       : QByteArray("{\"type\":\"image_url\",\"image_url\":{\"url\":\""));
+        fragment.append(AttachmentEncoder::dataUrl(images[i]));
+        const bool last = (i + 1 == images.size());
+        fragment.append(cacheBreakpoint && last ? QByteArray("\"},\"cache_control\":{\"type\":\"ephemeral\"}}")
+                                                : QByteArray("\"}}"));
+        needsSeparator = true;
+    }
+    
+    fragment.append(QByteArray("]}"));
 }
 
-void OpenRouterAPI::updateTokenStats()
+const MessageFragment& OpenRouterAPI::messageFragment(const Message& msg, bool cacheBreakpoint, PayloadDialect dialect)
 {
-    auto now = std::chrono::steady_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - m_streamStartTime);
+    MessageFragment& fragment = m_fragmentCache[msg.id];
+    fragment.lastUsed = m_payloadGeneration;
     
-    if (duration.count() > 0 && m_tokenCount > 0) {
-        m_tokensPerSecond = (m_tokenCount * 1000.0) / duration.count();
+    // Content length and attachment count catch edits made without touch()
+    const bool stale = fragment.pieces.isEmpty()
+        || fragment.revision != msg.revision
+        || fragment.contentLength != msg.content.size()
+        || fragment.attachmentCount != msg.attachments.size()
+        || fragment.cacheBreakpoint != cacheBreakpoint
+        || fragment.dialect != dialect
+        || msg.status == MessageStatus::Streaming
+        || msg.status == MessageStatus::Sending;
+    
+    if (stale) {
+        serializeMessage(msg, cacheBreakpoint, dialect, fragment);
+        fragment.cacheBreakpoint = cacheBreakpoint;
+        fragment.dialect = dialect;
+        fragment.revision = msg.revision;
+        fragment.contentLength = msg.content.size();
+        fragment.attachmentCount = msg.attachments.size();
     }
+    
+    return fragment;
 }
 
-bool OpenRouterAPI::parseModelsResponse(const QByteArray& response)
+void OpenRouterAPI::pruneFragmentCache(size_t conversationSize)
 {
-    QJsonParseError error;
-    QJsonDocument doc = QJsonDocument::fromJson(response, &error);
-    
-    if (error.error != QJsonParseError::NoError) {
-        qWarning() << "Failed to parse models response:" << error.errorString();
-        return false;
+    // Drop fragments of deleted messages or other conversations once the
+    // cache has grown well past what the current conversation needs
+    if (static_cast<size_t>(m_fragmentCache.size()) <= conversationSize * 2 + FRAGMENT_CACHE_SLACK) {
+        return;
     }
     
-    QJsonObject obj = doc.object();
-    if (!obj.contains("data")) {
-        qWarning() << "Models response missing 'data' field";
-        return false;
+    for (auto it = m_fragmentCache.begin(); it != m_fragmentCache.end();) {
+        if (it->lastUsed != m_payloadGeneration) {
+            it = m_fragmentCache.erase(it);
+        } else {
+            ++it;
+        }
     }
+}
+
+void OpenRouterAPI::invalidateMessage(const QString& messageId)
+{
+    m_fragmentCache.remove(messageId);
+}
+
+void OpenRouterAPI::clearPayloadCache()
+{
+    m_fragmentCache.clear();
+}
+
+void OpenRouterAPI::onModelsReplyFinished()
+{
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply) return;
     
-    QJsonArray data = obj["data"].toArray();
-    m_models.clear();
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    ModelCatalogLoader* loader = m_catalogLoader;
     
-    for (const QJsonValue& value : data) {
-        QJsonObject modelObj = value.toObject();
+    if (reply->error() == QNetworkReply::NoError && status == 304) {
+        // Catalogue unchanged; just restart the TTL
+        m_modelsRefreshPending = false;
+        m_modelsFetchedAt = QDateTime::currentDateTimeUtc();
         
-        ModelInfo model(
-            modelObj["id"].toString(),
-            modelObj["name"].toString()
-        );
+        const QString path = modelsCachePath();
+        std::shared_ptr<const ModelIndex> catalogue = m_remoteCatalog;
+        const QDateTime fetchedAt = m_modelsFetchedAt;
+        const QByteArray etag = m_modelsETag;
+        const QByteArray lastModified = m_modelsLastModified;
+        QMetaObject::invokeMethod(loader, [=]() {
+            loader->abort();
+            loader->writeCache(path, catalogue, fetchedAt, etag, lastModified);
+        }, Qt::QueuedConnection);
         
-        model.description = modelObj["description"].toString();
-        model.provider = modelObj["owned_by"].toString();
+        emit modelsRefreshed(true);
+    } else if (reply->error() == QNetworkReply::NoError) {
+        // The loader reports back through onCatalogueUpdated / onCatalogueFailed
+        const QByteArray remaining = reply->readAll();
+        m_pendingModelsETag = reply->rawHeader("ETag");
+        m_pendingModelsLastModified = reply->rawHeader("Last-Modified");
         
-        // Parse context length
-        if (modelObj.contains("context_length")) {
-            model.maxTokens = modelObj["context_length"].toInt();
-        }
-        
-        // Parse pricing if available
-        if (modelObj.contains("pricing")) {
-            QJsonObject pricing = modelObj["pricing"].toObject();
-            if (pricing.contains("prompt")) {
-                model.costPerToken = pricing["prompt"].toString().toDouble();
-            }
-        }
+        const QString path = modelsCachePath();
+        const QDateTime fetchedAt = QDateTime::currentDateTimeUtc();
+        const QByteArray etag = m_pendingModelsETag;
+        const QByteArray lastModified = m_pendingModelsLastModified;
+        QMetaObject::invokeMethod(loader, [=]() {
+            loader->feed(remaining);
+            loader->finish(path, fetchedAt, etag, lastModified);
+        }, Qt::QueuedConnection);
+    } else {
+        // Keep whatever catalogue is already loaded; the cache still serves the picker
+        qWarning() << "Models request failed:" << reply->errorString();
+        m_modelsRefreshPending = false;
+        QMetaObject::invokeMethod(loader, [loader]() {
+            loader->abort();
+        }, Qt::QueuedConnection);
         
-        // Check capabilities
-        model.supportsImages = modelObj["modalities"].toArray().contains("vision");
-        model.supportsFiles = true; // Most models support text files
+        emit modelsRefreshed(false);
+    }
+    
+    reply->deleteLater();
+}
+
+void OpenRouterAPI::onCatalogueUpdated(std::shared_ptr<const ModelIndex> remote,
+                                       std::shared_ptr<const ModelIndex> merged, bool complete)
+{
+    // Readers holding the previous snapshot keep it alive until they let go
+    m_remoteCatalog = remote;
+    std::atomic_store(&m_catalog, merged);
+    
+    if (!complete) {
+        emit modelsPartiallyLoaded(merged->size());
+        return;
+    }
+    
+    m_modelsRefreshPending = false;
+    m_modelsFetchedAt = QDateTime::currentDateTimeUtc();
+    m_modelsETag = m_pendingModelsETag;
+    m_modelsLastModified = m_pendingModelsLastModified;
+    
+    qDebug() << "Loaded" << remote->size() << "models";
+    emit modelsRefreshed(true);
+}
+
+void OpenRouterAPI::onCatalogueMerged(std::shared_ptr<const ModelIndex> merged)
+{
+    if (!merged) return;
+    
+    // Local backends' lists changed
+    std::atomic_store(&m_catalog, merged);
+    emit modelsRefreshed(true);
+}
+
+void OpenRouterAPI::onCatalogueFailed(const QString& error)
+{
+    qWarning() << "Failed to parse models response:" << error;
+    m_modelsRefreshPending = false;
+    emit modelsRefreshed(false);
+}
+
+void OpenRouterAPI::onNetworkError(QNetworkReply::NetworkError error)
+{
+    Q_UNUSED(error)
+    QNetworkReply* reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply) return;
+    
+    // Models request failures are reported from onModelsReplyFinished
+    qWarning() << "Network error:" << reply->errorString();
+}
+
+QString OpenRouterAPI::modelsCachePath() const
+{
+    return m_cacheDirectory.isEmpty() ? QString() : m_cacheDirectory + "/models.json";
+}
+
+void OpenRouterAPI::onModelsCacheLoaded(const LoadedModelCatalogue& loaded)
+{
+    m_modelsCacheLoading = false;
+    
+    if (loaded.remote) {
+        m_remoteCatalog = loaded.remote;
+        std::atomic_store(&m_catalog, loaded.merged);
+        m_modelsFetchedAt = loaded.fetchedAt;
+        m_modelsETag = loaded.etag;
+        m_modelsLastModified = loaded.lastModified;
         
-        m_models.push_back(model);
+        qDebug() << "Loaded" << m_remoteCatalog->size() << "models from cache";
+        emit modelsRefreshed(true);
     }
     
-    qDebug() << "Loaded" << m_models.size() << "models";
-    return true;
+    if (m_modelsRefreshDeferred) {
+        const bool force = m_modelsRefreshForced;
+        m_modelsRefreshDeferred = false;
+        m_modelsRefreshForced = false;
+        refreshModels(force);
+    }
 }
 
 void OpenRouterAPI::initializeDefaultModels()
 {
     // Add some popular models as defaults
-    m_models = {
+    std::vector<ModelInfo> models = {
         ModelInfo("openai/gpt-4", "GPT-4"),
         ModelInfo("openai/gpt-3.5-turbo", "GPT-3.5 Turbo"),
         ModelInfo("anthropic/claude-2", "Claude 2"),
@@ -395,7 +1043,7 @@ void OpenRouterAPI::initializeDefaultModels()
     };
     
     // Set default properties
-    for (auto& model : m_models) {
+    for (auto& model : models) {
         model.maxTokens = 4096;
         model.supportsFiles = true;
         
@@ -410,4 +1058,6 @@ void OpenRouterAPI::initializeDefaultModels()
             model.costPerToken = 0.000008;
         }
     }
+    
+    setModels(std::move(models));
 } 
\ No newline at end of file
@@ -1,6 +1,15 @@
 #pragma once
 
 #include "Message.h"
+#include "ChatNetworkCore.h"
+#include "ChatBackend.h"
+#include "NetworkService.h"
+#include "ContextBudgeter.h"
+#include "Tokenizer.h"
+#include "ModelIndex.h"
+#include "ModelCatalogLoader.h"
+#include "RequestTimeline.h"
+#include "ResponseCache.h"
 #include <QObject>
 #include <QNetworkAccessManager>
 #include <QNetworkRequest>
@@ -10,94 +19,246 @@
 #include <QJsonDocument>
 #include <QString>
 #include <QStringList>
+#include <QDateTime>
+#include <QThread>
+#include <QHash>
+#include <QSet>
+#include <QVector>
 #include <vector>
 #include <memory>
 #include <atomic>
+#include <chrono>
 
-struct ModelInfo {
-    QString id;
-    QString name;
-    QString description;
-    QString provider;
-    double costPerToken;
-    int maxTokens;
-    bool supportsImages;
-    bool supportsFiles;
-    
-    ModelInfo(const QString& modelId, const QString& modelName)
-        : id(modelId), name(modelName), costPerToken(0.0), maxTokens(4096), 
-          supportsImages(false), supportsFiles(false) {}
+// Serialized JSON of one conversation message, reused while it is unchanged.
+// Image data URLs are kept as separate pieces that share the attachment's
+// encoded buffer rather than being copied into the fragment.
+struct MessageFragment {
+    quint64 revision = 0;
+    qsizetype contentLength = 0;
+    size_t attachmentCount = 0;
+    quint64 lastUsed = 0;
+    QVector<QByteArray> pieces;
+    QVector<QByteArray> buffers;    // Keep alive the data that raw pieces point into
+    qsizetype size = 0;
+    bool cacheBreakpoint = false;
+    PayloadDialect dialect = PayloadDialect::OpenAI;
+    
+    void append(const QByteArray& piece) {
+        pieces.append(piece);
+        size += piece.size();
+    }
+    
+    // Appends part of buffer without copying it
+    void appendView(const QByteArray& buffer, qsizetype offset) {
+        buffers.append(buffer);
+        append(QByteArray::fromRawData(buffer.constData() + offset, buffer.size() - offset));
+    }
 };
 
+// Chat configuration and payload building run on the caller's thread;
+// sockets, stream parsing and statistics live in a ChatNetworkCore on a
+// worker thread. Results come back as queued signals carrying coalesced
+// text, so the signal API is the same as when everything ran in one place.
 class OpenRouterAPI : public QObject {
     Q_OBJECT
 
 public:
     
-    explicit OpenRouterAPI(QObject *parent = nullptr);
+    explicit OpenRouterAPI(NetworkService *network = nullptr, QObject *parent = nullptr);
     ~OpenRouterAPI();
     
     // Configuration
     void setAPIKey(const QString& apiKey);
     void setModel(const QString& modelId);
+    QString model() const { return m_modelId; }
     void setBaseURL(const QString& url = "https://openrouter.ai/api/v1");
+    void setStreamFlushInterval(int milliseconds);
+    void setOutputReserve(int tokens);
+    bool loadTokenizer(const QString& directory);
+    void setRequestTimeout(int seconds);
+    void setStallTimeout(int seconds);
+    void setMaxRetries(int retries);
+    void setPromptCachingEnabled(bool enabled);
+    void setTemperature(double temperature);
+    void setRateLimits(int requestsPerMinute, int requestsPerMinutePerModel);
+    static bool supportsPromptCaching(const QString& modelId);
+    
+    // Backends besides OpenRouter (which setAPIKey / setBaseURL configure)
+    void setBackends(const std::vector<BackendConfig>& backends);
+    std::shared_ptr<const ChatBackend> backendForModel(const QString& modelId) const;
+    
+    // Connection management
+    void prewarmConnection();
+    bool isConnectionWarm() const;
     
     // Model management
-    void refreshModels();
-    const std::vector<ModelInfo>& getModels() const { return m_models; }
+    // Loads the cached catalogue in the background; headless callers that
+    // send straight away can wait for it instead
+    void setCacheDirectory(const QString& path, bool waitForModels = false);
+    void refreshModels(bool force = false);
+    bool hasCachedModels() const { return m_modelsFetchedAt.isValid(); }
+    QDateTime modelsFetchedAt() const { return m_modelsFetchedAt; }
+    std::vector<ModelInfo> getModels() const { return modelIndex()->models(); }
+    std::shared_ptr<const ModelIndex> modelIndex() const { return std::atomic_load(&m_catalog); }
     const ModelInfo* getCurrentModel() const;
     
     // Chat functionality
-    void sendMessage(const std::vector<Message>& conversation);
-    void stopCurrentRequest();
-    bool isRequestActive() const { return m_requestActive; }
+    RequestId sendMessage(const std::vector<Message>& conversation, const QString& modelId = QString(),
+                          NetworkService::Priority priority = NetworkService::Priority::Interactive);
+    QVector<RequestId> sendFanOut(const std::vector<Message>& conversation, const QStringList& modelIds);
+    void stopRequest(RequestId requestId);
+    void stopAllRequests();
+    bool isRequestActive() const { return !m_activeRequests.isEmpty(); }
+    bool isRequestActive(RequestId requestId) const { return m_activeRequests.contains(requestId); }
+    bool isRequestQueued(RequestId requestId) const { return m_queuedRequests.contains(requestId); }
+    int activeRequestCount() const { return m_activeRequests.size(); }
+    
+    // Request payload cache
+    void invalidateMessage(const QString& messageId);
+    void clearPayloadCache();
+    
+    // Replies replayed from disk for repeated requests. Only deterministic
+    // requests (temperature 0) are cached unless includeSampled is set.
+    void setResponseCacheEnabled(bool enabled, bool includeSampled = false);
+    void setResponseCacheSize(qint64 maxBytes);
+    void clearResponseCache();
     
     // Statistics
-    double getTokensPerSecond() const { return m_tokensPerSecond; }
-    int getTotalTokensUsed() const { return m_totalTokensUsed; }
-    double getEstimatedCost() const { return m_estimatedCost; }
+    double getTokensPerSecond() const { return m_core->tokensPerSecond(); }
+    int getTotalTokensUsed() const { return m_core->totalTokensUsed(); }
+    double getEstimatedCost() const { return m_core->estimatedCost(); }
+    ConnectionStats getConnectionStats() const { return m_core->connectionStats(); }
+    ReliabilityStats getReliabilityStats() const { return m_core->reliabilityStats(); }
+    NetworkStats getChatNetworkStats() const { return m_core->networkStats(); }       // Network thread's pool
+    NetworkStats getSharedNetworkStats() const { return m_network->stats(); }         // Models list and downloads
+    int streamTokenCount(RequestId requestId) const;
+    std::shared_ptr<const Tokenizer> tokenizer() const { return m_tokenizer; }
+    const LatencyTracker& latency() const { return m_latency; }
+    void setLatencyLogPath(const QString& path) { m_latency.setLogPath(path); }
+    bool exportLatencyLog(const QString& path) const { return m_latency.exportJsonLines(path); }
 
 signals:
     void modelsRefreshed(bool success);
-    void streamReceived(const QString& content);
-    void streamCompleted(bool success);
-    void streamError(const QString& error);
+    void modelsPartiallyLoaded(int modelCount);
+    void streamReceived(RequestId requestId, const QString& content);
+    void streamCompleted(RequestId requestId, bool success);
+    void streamError(RequestId requestId, const QString& error);
+    void firstTokenReceived(RequestId requestId, qint64 elapsedMs, bool reusedConnection);
+    void contextTrimmed(RequestId requestId, int droppedMessages, int elidedImages, int estimatedTokens);
+    void requestRetrying(RequestId requestId, int attempt, int delayMs, const QString& reason);
+    void promptCacheUsage(RequestId requestId, int promptTokens, int cachedTokens);
+    void requestQueued(RequestId requestId, int waitMs, const QString& reason);
+    void requestDispatched(RequestId requestId);
+    void responseReplayed(RequestId requestId, const QDateTime& cachedAt);
+    void requestFinished(const RequestTimeline& timeline);
     void connectionStatusChanged(bool connected);
 
 private slots:
     void onModelsReplyFinished();
-    void onChatReplyFinished();
-    void onChatReplyReadyRead();
+    void onCatalogueUpdated(std::shared_ptr<const ModelIndex> remote, std::shared_ptr<const ModelIndex> merged,
+                            bool complete);
+    void onCatalogueMerged(std::shared_ptr<const ModelIndex> merged);
+    void onCatalogueFailed(const QString& error);
     void onNetworkError(QNetworkReply::NetworkError error);
+    void onDeltaReady(RequestId requestId, const QString& content, int tokenCount);
+    void onRequestFinished(const RequestTimeline& timeline);
+    void onStreamCompleted(RequestId requestId, bool success);
     
 private:
     QString m_apiKey;
     QString m_modelId = "openai/gpt-3.5-turbo";
     QString m_baseURL = "https://openrouter.ai/api/v1";
     
-    std::vector<ModelInfo> m_models;
-    std::atomic<bool> m_requestActive{false};
-    std::atomic<bool> m_shouldStop{false};
+    // Swapped whole with std::atomic_store; readers take a snapshot with modelIndex()
+    std::shared_ptr<const ModelIndex> m_catalog;
     
-    // Statistics
-    std::atomic<double> m_tokensPerSecond{0.0};
-    std::atomic<int> m_totalTokensUsed{0};
-    std::atomic<double> m_estimatedCost{0.0};
+    // OpenRouter's own catalogue (what the cache file holds), and models
+    // discovered on the other backends, merged into m_catalog
+    std::shared_ptr<const ModelIndex> m_remoteCatalog;
+    QHash<QString, std::vector<ModelInfo>> m_backendModels;
+    
+    // Chat backends: OpenRouter plus any configured local servers, by id
+    std::shared_ptr<const ChatBackend> m_defaultBackend;
+    QHash<QString, std::shared_ptr<const ChatBackend>> m_backends;
+    
+    // Streams /models responses through a parser on its own thread
+    QThread *m_catalogThread;
+    ModelCatalogLoader *m_catalogLoader;
+    QByteArray m_pendingModelsETag;
+    QByteArray m_pendingModelsLastModified;
+    
+    // Persistent models catalogue
+    QString m_cacheDirectory;
+    QDateTime m_modelsFetchedAt;
+    QByteArray m_modelsETag;
+    QByteArray m_modelsLastModified;
+    bool m_modelsRefreshPending = false;
+    bool m_modelsCacheLoading = false;
+    bool m_modelsRefreshDeferred = false;   // Asked for while the cache was loading
+    bool m_modelsRefreshForced = false;
+    
+    static constexpr int MODELS_CACHE_TTL_SECONDS = 24 * 60 * 60;
+    
+    // Models list and other GUI-side requests
+    NetworkService *m_network;
+    
+    // Chat streaming, on its own thread
+    QThread *m_coreThread;
+    ChatNetworkCore *m_core;
+    
+    // GUI-side view of the core's requests: token count so far, keyed by handle
+    QHash<RequestId, int> m_activeRequests;
+    QSet<RequestId> m_queuedRequests;
+    RequestId m_nextRequestId = 1;
+    LatencyTracker m_latency;
+    
+    // Fits history into the selected model's context window
+    std::shared_ptr<Tokenizer> m_tokenizer;
+    QString m_tokenizerDirectory;
+    ContextBudgeter m_budgeter;
+    
+    // Serialized message fragments, keyed by message id
+    QHash<QString, MessageFragment> m_fragmentCache;
+    quint64 m_payloadGeneration = 0;
+    
+    static constexpr int FRAGMENT_CACHE_SLACK = 64;
+    
+    // Prompt caching
+    bool m_promptCaching = false;
+    double m_temperature = 0.7;
     
-    // Qt Network components
-    QNetworkAccessManager *m_networkManager;
-    QNetworkReply *m_currentReply = nullptr;
-    QTimer *m_streamTimer;
+    // Response cache, and the replies being recorded for it
+    struct PendingCacheWrite {
+        QByteArray key;
+        CachedResponse response;
+        bool complete = false;      // Finished without error and not cut off
+    };
+    ResponseCache m_responseCache;
+    QHash<RequestId, PendingCacheWrite> m_cacheWrites;
+    QSet<RequestId> m_replays;      // Replies still to be replayed from the cache
+    bool m_responseCacheEnabled = false;
+    bool m_cacheSampledResponses = false;
     
-    // Streaming state
-    QString m_streamBuffer;
-    std::chrono::steady_clock::time_point m_streamStartTime;
-    int m_tokenCount = 0;
+    static constexpr int MAX_CACHE_BREAKPOINTS = 4;            // Anthropic's limit per request
+    static constexpr int CACHE_HISTORY_QUANTUM = 8;            // Messages between history breakpoints
+    static constexpr int CACHE_LARGE_ATTACHMENT_BYTES = 64 * 1024;
     
     // Internal methods
-    bool parseModelsResponse(const QByteArray& response);
-    QJsonObject prepareRequestPayload(const std::vector<Message>& conversation);
-    void processStreamChunk(const QString& chunk);
+    void setModels(std::vector<ModelInfo> models);
+    void publishCatalogue();
+    void updateDefaultBackend();
+    void refreshBackendModels();
+    QString modelsCachePath() const;
+    void onModelsCacheLoaded(const LoadedModelCatalogue& loaded);
+    QByteArray prepareRequestPayload(const ChatBackend& backend, const QString& modelId,
+                                     const std::vector<Message>& conversation, int maxTokens,
+                                     const QSet<int>& cacheBreakpoints = QSet<int>());
+    QSet<int> cacheBreakpoints(const std::vector<Message>& conversation) const;
+    static std::vector<Message> withoutReplyPlaceholders(const std::vector<Message>& conversation);
+    void serializeMessage(const Message& msg, bool cacheBreakpoint, PayloadDialect dialect,
+                          MessageFragment& fragment) const;
+    const MessageFragment& messageFragment(const Message& msg, bool cacheBreakpoint, PayloadDialect dialect);
+    void pruneFragmentCache(size_t conversationSize);
+    void replayCachedResponse(RequestId requestId, const CachedResponse& response);
     QNetworkRequest createRequest(const QString& endpoint);
-    void updateTokenStats();
 }; 
\ No newline at end of file
@@ -0,0 +1,311 @@
+#include "RequestScheduler.h"
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QDateTime>
+#include <QLocale>
+#include <algorithm>
+#include <cmath>
+
+void TokenBucket::configure(double capacity, double refillPerSecond)
+{
+    m_capacity = capacity;
+    m_refillPerSecond = refillPerSecond;
+    m_tokens = capacity;
+    m_lastRefill = Clock::now();
+}
+
+bool TokenBucket::tryTake(Clock::time_point now)
+{
+    if (!isLimited()) return true;
+    
+    refill(now);
+    if (m_tokens < 1.0) return false;
+    m_tokens -= 1.0;
+    return true;
+}
+
+qint64 TokenBucket::msUntilAvailable(Clock::time_point now)
+{
+    if (!isLimited()) return 0;
+    
+    refill(now);
+    if (m_tokens >= 1.0) return 0;
+    return static_cast<qint64>(std::ceil((1.0 - m_tokens) / m_refillPerSecond * 1000.0));
+}
+
+void TokenBucket::clampTokens(double maximum, Clock::time_point now)
+{
+    if (!isLimited()) return;
+    
+    refill(now);
+    m_tokens = std::min(m_tokens, maximum);
+}
+
+void TokenBucket::refill(Clock::time_point now)
+{
+    const double elapsed = std::chrono::duration<double>(now - m_lastRefill).count();
+    m_tokens = std::min(m_capacity, m_tokens + elapsed * m_refillPerSecond);
+    m_lastRefill = now;
+}
+
+RequestScheduler::RequestScheduler(QObject *parent)
+    : QObject(parent)
+{
+    m_dispatchTimer = new QTimer(this);
+    m_dispatchTimer->setSingleShot(true);
+    connect(m_dispatchTimer, &QTimer::timeout, this, &RequestScheduler::dispatchReady);
+}
+
+void RequestScheduler::setKeyRateLimit(int requestsPerMinute)
+{
+    // Burst of a sixth of the minute's budget, refilled evenly
+    m_keyRateLimit = qMax(0, requestsPerMinute);
+    for (Limits& limits : m_keyLimits) {
+        limits.bucket.configure(qMax(1, m_keyRateLimit / 6), m_keyRateLimit / 60.0);
+    }
+}
+
+void RequestScheduler::setModelRateLimit(int requestsPerMinute)
+{
+    m_modelRateLimit = qMax(0, requestsPerMinute);
+    for (Limits& limits : m_modelLimits) {
+        limits.bucket.configure(qMax(1, m_modelRateLimit / 6), m_modelRateLimit / 60.0);
+    }
+}
+
+bool RequestScheduler::submit(quint64 requestId, const QString& backendId, const QString& modelId,
+                              Priority priority)
+{
+    const auto now = Clock::now();
+    
+    // Anything already waiting at the same or a higher priority goes first
+    const bool queueAhead = std::any_of(m_queue.begin(), m_queue.end(), [priority](const Pending& pending) {
+        return pending.priority <= priority;
+    });
+    
+    QString reason;
+    const qint64 waitMs = queueAhead ? -1 : waitFor(backendId, modelId, now, &reason);
+    if (waitMs == 0) {
+        take(backendId, modelId, now);
+        emit dispatched(requestId);
+        return true;
+    }
+    
+    Pending pending;
+    pending.requestId = requestId;
+    pending.backendId = backendId;
+    pending.modelId = modelId;
+    pending.priority = priority;
+    pending.sequence = m_nextSequence++;
+    
+    // Ordered by priority, then by age
+    auto position = std::find_if(m_queue.begin(), m_queue.end(), [priority](const Pending& queued) {
+        return queued.priority > priority;
+    });
+    m_queue.insert(position, pending);
+    
+    if (waitMs < 0) {
+        reason = "Waiting for earlier requests";
+    }
+    emit queued(requestId, static_cast<int>(qMax<qint64>(0, waitMs)), reason);
+    
+    dispatchReady();
+    return false;
+}
+
+void RequestScheduler::cancel(quint64 requestId)
+{
+    m_queue.erase(std::remove_if(m_queue.begin(), m_queue.end(), [requestId](const Pending& pending) {
+        return pending.requestId == requestId;
+    }), m_queue.end());
+}
+
+bool RequestScheduler::isQueued(quint64 requestId) const
+{
+    return std::any_of(m_queue.begin(), m_queue.end(), [requestId](const Pending& pending) {
+        return pending.requestId == requestId;
+    });
+}
+
+void RequestScheduler::dispatchReady()
+{
+    const auto now = Clock::now();
+    qint64 nextWaitMs = -1;
+    
+    for (auto it = m_queue.begin(); it != m_queue.end();) {
+        QString reason;
+        const qint64 keyWaitMs = keyWait(it->backendId, now, &reason);
+        if (keyWaitMs > 0) {
+            // Key-wide limit: nothing behind this entry on the same backend
+            // can go either, but other backends are unaffected
+            nextWaitMs = nextWaitMs < 0 ? keyWaitMs : qMin(nextWaitMs, keyWaitMs);
+            ++it;
+            continue;
+        }
+    
+        const qint64 waitMs = waitFor(it->backendId, it->modelId, now, &reason);
+        if (waitMs == 0) {
+            const quint64 requestId = it->requestId;
+            take(it->backendId, it->modelId, now);
+            it = m_queue.erase(it);
+            emit dispatched(requestId);
+            continue;
+        }
+    
+        // Only this model is limited; later requests for other models may go
+        nextWaitMs = nextWaitMs < 0 ? waitMs : qMin(nextWaitMs, waitMs);
+        ++it;
+    }
+    
+    if (nextWaitMs >= 0) {
+        scheduleDispatch(nextWaitMs);
+    }
+}
+
+qint64 RequestScheduler::keyWait(const QString& backendId, Clock::time_point now, QString* reason)
+{
+    Limits& limits = keyLimits(backendId);
+    if (limits.blockedUntil > now) {
+        *reason = limits.blockReason;
+        return std::chrono::duration_cast<std::chrono::milliseconds>(limits.blockedUntil - now).count();
+    }
+    if (const qint64 bucketMs = limits.bucket.msUntilAvailable(now)) {
+        *reason = "Request rate limit";
+        return bucketMs;
+    }
+    return 0;
+}
+
+qint64 RequestScheduler::waitFor(const QString& backendId, const QString& modelId, Clock::time_point now,
+                                 QString* reason)
+{
+    auto remaining = [now](Clock::time_point until) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(until - now).count();
+    };
+    
+    qint64 waitMs = keyWait(backendId, now, reason);
+    
+    Limits& limits = modelLimits(modelId);
+    if (limits.blockedUntil > now && remaining(limits.blockedUntil) > waitMs) {
+        waitMs = remaining(limits.blockedUntil);
+        *reason = limits.blockReason;
+    } else if (const qint64 bucketMs = limits.bucket.msUntilAvailable(now); bucketMs > waitMs) {
+        waitMs = bucketMs;
+        *reason = "Model rate limit";
+    }
+    
+    return waitMs;
+}
+
+RequestScheduler::Limits& RequestScheduler::keyLimits(const QString& backendId)
+{
+    auto it = m_keyLimits.find(backendId);
+    if (it == m_keyLimits.end()) {
+        it = m_keyLimits.insert(backendId, Limits());
+        it->bucket.configure(qMax(1, m_keyRateLimit / 6), m_keyRateLimit / 60.0);
+    }
+    return it.value();
+}
+
+RequestScheduler::Limits& RequestScheduler::modelLimits(const QString& modelId)
+{
+    auto it = m_modelLimits.find(modelId);
+    if (it == m_modelLimits.end()) {
+        it = m_modelLimits.insert(modelId, Limits());
+        it->bucket.configure(qMax(1, m_modelRateLimit / 6), m_modelRateLimit / 60.0);
+    }
+    return it.value();
+}
+
+void RequestScheduler::take(const QString& backendId, const QString& modelId, Clock::time_point now)
+{
+    keyLimits(backendId).bucket.tryTake(now);
+    modelLimits(modelId).bucket.tryTake(now);
+}
+
+void RequestScheduler::scheduleDispatch(qint64 delayMs)
+{
+    const int delay = static_cast<int>(qBound<qint64>(1, delayMs, MAX_RETRY_AFTER_MS));
+    if (!m_dispatchTimer->isActive() || m_dispatchTimer->remainingTime() > delay) {
+        m_dispatchTimer->start(delay);
+    }
+}
+
+void RequestScheduler::recordResponse(const QString& backendId, const QString& modelId, QNetworkReply* reply,
+                                      bool readRateLimitHeaders)
+{
+    const auto now = Clock::now();
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    
+    // X-RateLimit-Reset is epoch milliseconds on OpenRouter; other
+    // OpenAI-style servers send epoch seconds or seconds from now
+    bool haveRemaining = false;
+    int remaining = 0;
+    qint64 resetMs = -1;
+    bool haveReset = false;
+    double reset = 0.0;
+    if (readRateLimitHeaders) {
+        remaining = reply->rawHeader("X-RateLimit-Remaining").toInt(&haveRemaining);
+        reset = reply->rawHeader("X-RateLimit-Reset").toDouble(&haveReset);
+    }
+    if (haveReset) {
+        const qint64 nowEpochMs = QDateTime::currentMSecsSinceEpoch();
+        if (reset > 1e12) {
+            resetMs = static_cast<qint64>(reset) - nowEpochMs;
+        } else if (reset > 1e9) {
+            resetMs = static_cast<qint64>(reset * 1000.0) - nowEpochMs;
+        } else {
+            resetMs = static_cast<qint64>(reset * 1000.0);
+        }
+        resetMs = qBound<qint64>(0, resetMs, MAX_RETRY_AFTER_MS);
+    }
+    
+    Limits& key = keyLimits(backendId);
+    if (haveRemaining && remaining <= 0 && resetMs > 0) {
+        key.blockedUntil = std::max(key.blockedUntil, now + std::chrono::milliseconds(resetMs));
+        key.blockReason = "Rate limit reached for this API key";
+    } else if (haveRemaining) {
+        key.bucket.clampTokens(remaining, now);
+    }
+    
+    if (status == 429 || status == 503) {
+        qint64 delayMs = retryAfterMs(reply);
+        if (delayMs < 0 && status == 429) {
+            delayMs = resetMs > 0 ? resetMs : DEFAULT_429_BACKOFF_MS;
+        }
+        if (delayMs > 0) {
+            // A 429 without exhausted key headers is the model's (or its provider's) limit
+            Limits& limits = modelLimits(modelId);
+            limits.blockedUntil = std::max(limits.blockedUntil, now + std::chrono::milliseconds(delayMs));
+            limits.blockReason = status == 429 ? QString("Rate limited by %1").arg(modelId)
+                                               : QString("%1 is temporarily unavailable").arg(modelId);
+        }
+    }
+    
+    if (!m_queue.empty()) {
+        dispatchReady();
+    }
+}
+
+qint64 RequestScheduler::retryAfterMs(QNetworkReply* reply)
+{
+    const QByteArray value = reply->rawHeader("Retry-After").trimmed();
+    if (value.isEmpty()) return -1;
+    
+    // Either delta-seconds or an HTTP-date
+    bool isNumber = false;
+    const double seconds = value.toDouble(&isNumber);
+    qint64 delayMs = -1;
+    if (isNumber) {
+        delayMs = static_cast<qint64>(seconds * 1000.0);
+    } else {
+        const QDateTime when = QLocale::c().toDateTime(QString::fromLatin1(value), "ddd, dd MMM yyyy HH:mm:ss 'GMT'");
+        if (when.isValid()) {
+            QDateTime utc = when;
+            utc.setTimeSpec(Qt::UTC);
+            delayMs = QDateTime::currentDateTimeUtc().msecsTo(utc);
+        }
+    }
+    
+    return delayMs < 0 ? -1 : qMin<qint64>(delayMs, MAX_RETRY_AFTER_MS);
+}
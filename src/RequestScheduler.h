@@ -0,0 +1,111 @@
+#pragma once
+
+#include "NetworkService.h"
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+#include <deque>
+#include <chrono>
+
+class QNetworkReply;
+
+// Classic token bucket: holds up to capacity tokens, refilled continuously
+class TokenBucket {
+public:
+    using Clock = std::chrono::steady_clock;
+    
+    void configure(double capacity, double refillPerSecond);
+    bool isLimited() const { return m_refillPerSecond > 0.0; }
+    
+    bool tryTake(Clock::time_point now);
+    qint64 msUntilAvailable(Clock::time_point now);
+    void clampTokens(double maximum, Clock::time_point now);
+
+private:
+    void refill(Clock::time_point now);
+    
+    double m_capacity = 0.0;
+    double m_refillPerSecond = 0.0;   // 0 = unlimited
+    double m_tokens = 0.0;
+    Clock::time_point m_lastRefill;
+};
+
+// Sits between OpenRouterAPI and the network. Requests are admitted through a
+// per-backend (API key) and a per-model token bucket, honour Retry-After and
+// exhausted X-RateLimit-* windows, and wait in a queue ordered by priority
+// (then age), so background work never delays a chat turn and a 429 pauses
+// that backend instead of triggering a storm of retries. Backends never
+// share limits: a local server does not draw down OpenRouter's budget.
+class RequestScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Clock = std::chrono::steady_clock;
+    using Priority = NetworkService::Priority;
+    
+    explicit RequestScheduler(QObject *parent = nullptr);
+    
+    // Requests per minute; 0 = no local limit (server headers still apply)
+    void setKeyRateLimit(int requestsPerMinute);
+    void setModelRateLimit(int requestsPerMinute);
+    
+    // Emits dispatched(requestId) now or once allowed; returns false if queued
+    bool submit(quint64 requestId, const QString& backendId, const QString& modelId, Priority priority);
+    void cancel(quint64 requestId);
+    bool isQueued(quint64 requestId) const;
+    int queuedCount() const { return static_cast<int>(m_queue.size()); }
+    
+    // Feed every response (including failures) so limits track the server.
+    // X-RateLimit-* headers are only read when the backend is known to send them.
+    void recordResponse(const QString& backendId, const QString& modelId, QNetworkReply* reply,
+                        bool readRateLimitHeaders);
+    
+    // Server-requested delay for a failed reply, or -1 if it gave none
+    static qint64 retryAfterMs(QNetworkReply* reply);
+
+signals:
+    void dispatched(quint64 requestId);
+    void queued(quint64 requestId, int waitMs, const QString& reason);
+
+private slots:
+    void dispatchReady();
+
+private:
+    struct Pending {
+        quint64 requestId = 0;
+        QString backendId;
+        QString modelId;
+        Priority priority = Priority::Normal;
+        quint64 sequence = 0;
+    };
+    
+    struct Limits {
+        TokenBucket bucket;
+        Clock::time_point blockedUntil;
+        QString blockReason;
+    };
+    
+    // Milliseconds until a request may go; 0 = now
+    qint64 keyWait(const QString& backendId, Clock::time_point now, QString* reason);
+    qint64 waitFor(const QString& backendId, const QString& modelId, Clock::time_point now, QString* reason);
+    Limits& keyLimits(const QString& backendId);
+    Limits& modelLimits(const QString& modelId);
+    void take(const QString& backendId, const QString& modelId, Clock::time_point now);
+    void scheduleDispatch(qint64 delayMs);
+    
+    std::deque<Pending> m_queue;
+    quint64 m_nextSequence = 0;
+    
+    QHash<QString, Limits> m_keyLimits;     // By backend id
+    QHash<QString, Limits> m_modelLimits;
+    int m_keyRateLimit = 0;
+    int m_modelRateLimit = 0;
+    
+    QTimer *m_dispatchTimer;
+    
+    static constexpr int DEFAULT_429_BACKOFF_MS = 5000;
+    static constexpr int MAX_RETRY_AFTER_MS = 5 * 60 * 1000;
+};
@@ -0,0 +1,149 @@
+#include "RequestTimeline.h"
+#include <QFile>
+#include <QJsonDocument>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+QJsonObject RequestTimeline::toJson() const
+{
+    QJsonObject obj;
+    obj["request_id"] = static_cast<qint64>(requestId);
+    obj["model"] = modelId;
+    obj["queued_at"] = queuedAt.toString(Qt::ISODateWithMs);
+    obj["attempts"] = attempts;
+    obj["dispatched_ms"] = dispatchedMs;
+    obj["connection_reused"] = connectionReused;
+    obj["connect_start_ms"] = connectStartMs;
+    obj["tls_done_ms"] = tlsDoneMs;
+    obj["request_sent_ms"] = requestSentMs;
+    obj["headers_ms"] = headersMs;
+    obj["first_byte_ms"] = firstByteMs;
+    obj["first_token_ms"] = firstTokenMs;
+    obj["completed_ms"] = completedMs;
+    obj["tokens"] = tokenCount;
+    obj["prompt_tokens"] = promptTokens;
+    obj["success"] = success;
+    obj["http_status"] = httpStatus;
+    if (!finishReason.isEmpty()) {
+        obj["finish_reason"] = finishReason;
+    }
+    
+    // Gap summary rather than every sample, which keeps lines short
+    if (!interTokenGapsMs.isEmpty()) {
+        LatencyHistogram gaps(interTokenGapsMs.size());
+        qint64 sum = 0;
+        for (qint32 gap : interTokenGapsMs) {
+            gaps.add(gap);
+            sum += gap;
+        }
+        QJsonObject gapObj;
+        gapObj["count"] = interTokenGapsMs.size();
+        gapObj["mean_ms"] = static_cast<double>(sum) / interTokenGapsMs.size();
+        gapObj["p50_ms"] = gaps.percentile(50);
+        gapObj["p95_ms"] = gaps.percentile(95);
+        gapObj["max_ms"] = *std::max_element(interTokenGapsMs.begin(), interTokenGapsMs.end());
+        obj["inter_token_gaps"] = gapObj;
+    }
+    
+    return obj;
+}
+
+void LatencyHistogram::add(double value)
+{
+    if (static_cast<int>(m_samples.size()) < m_capacity) {
+        m_samples.push_back(value);
+    } else {
+        m_samples[m_next] = value;
+        m_next = (m_next + 1) % m_samples.size();
+    }
+}
+
+double LatencyHistogram::percentile(double p) const
+{
+    if (m_samples.empty()) return 0.0;
+    
+    // Nearest-rank on a copy; windows are small and queried about once a second
+    std::vector<double> sorted(m_samples);
+    const size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+    const size_t index = std::min(sorted.size() - 1, rank > 0 ? rank - 1 : 0);
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+void LatencyTracker::record(const RequestTimeline& timeline)
+{
+    ModelHistograms& entry = m_histograms[timeline.modelId];
+    
+    if (!timeline.connectionReused && timeline.connectStartMs >= 0 && timeline.tlsDoneMs >= 0) {
+        entry.connect.add(timeline.tlsDoneMs - timeline.connectStartMs);
+    }
+    if (timeline.firstByteMs >= 0) {
+        entry.timeToFirstByte.add(timeline.firstByteMs);
+    }
+    if (timeline.firstTokenMs >= 0) {
+        entry.timeToFirstToken.add(timeline.firstTokenMs);
+    }
+    for (qint32 gap : timeline.interTokenGapsMs) {
+        entry.interTokenGap.add(gap);
+    }
+    if (timeline.success && timeline.completedMs >= 0) {
+        entry.total.add(timeline.completedMs);
+    }
+    
+    m_recent.push_back(timeline);
+    while (m_recent.size() > MAX_RECENT_TIMELINES) {
+        m_recent.pop_front();
+    }
+    
+    if (!m_logPath.isEmpty()) {
+        QFile file(m_logPath);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            file.write(QJsonDocument(timeline.toJson()).toJson(QJsonDocument::Compact));
+            file.write("\n");
+        } else {
+            qWarning() << "Cannot append to latency log:" << m_logPath << file.errorString();
+        }
+    }
+}
+
+LatencySummary LatencyTracker::summary(const QString& modelId, Metric metric) const
+{
+    LatencySummary result;
+    auto it = m_histograms.constFind(modelId);
+    if (it == m_histograms.constEnd()) return result;
+    
+    const LatencyHistogram& samples = histogram(it.value(), metric);
+    result.samples = samples.count();
+    result.p50 = samples.percentile(50);
+    result.p95 = samples.percentile(95);
+    result.p99 = samples.percentile(99);
+    return result;
+}
+
+bool LatencyTracker::exportJsonLines(const QString& path) const
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qWarning() << "Cannot write latency log:" << path << file.errorString();
+        return false;
+    }
+    
+    for (const RequestTimeline& timeline : m_recent) {
+        file.write(QJsonDocument(timeline.toJson()).toJson(QJsonDocument::Compact));
+        file.write("\n");
+    }
+    return true;
+}
+
+const LatencyHistogram& LatencyTracker::histogram(const ModelHistograms& entry, Metric metric)
+{
+    switch (metric) {
+        case Metric::Connect: return entry.connect;
+        case Metric::TimeToFirstByte: return entry.timeToFirstByte;
+        case Metric::TimeToFirstToken: return entry.timeToFirstToken;
+        case Metric::InterTokenGap: return entry.interTokenGap;
+        case Metric::Total: return entry.total;
+    }
+    return entry.total;
+}
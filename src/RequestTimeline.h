@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QHash>
+#include <QVector>
+#include <QJsonObject>
+#include <QMetaType>
+#include <deque>
+#include <vector>
+
+// Phases of one chat request, in milliseconds since it was queued; -1 means
+// the phase did not happen (or, for connection setup, was not observable)
+struct RequestTimeline {
+    quint64 requestId = 0;
+    QString modelId;
+    QDateTime queuedAt;
+    int attempts = 1;
+    qint64 dispatchedMs = -1;    // Left the rate-limit queue (about 0 when not held back)
+    
+    // Connection setup. QNetworkAccessManager does not report DNS resolution
+    // separately, so connectStartMs covers lookup plus TCP; both connection
+    // fields need Qt 6.3 and stay -1 on older versions.
+    bool connectionReused = false;
+    qint64 connectStartMs = -1;
+    qint64 tlsDoneMs = -1;
+    qint64 requestSentMs = -1;
+    
+    // Response
+    qint64 headersMs = -1;       // Status line and headers received
+    qint64 firstByteMs = -1;     // First body bytes
+    qint64 firstTokenMs = -1;    // First content token
+    qint64 completedMs = -1;
+    int tokenCount = 0;
+    int promptTokens = 0;        // Server-reported when usage came back, else the budgeter's estimate
+    QVector<qint32> interTokenGapsMs;
+    QString finishReason;        // As reported by the server ("stop", "length", ...)
+    
+    bool success = false;
+    int httpStatus = 0;
+    
+    QJsonObject toJson() const;
+};
+
+Q_DECLARE_METATYPE(RequestTimeline)
+
+// Fixed-size window of the most recent samples with percentile queries
+class LatencyHistogram {
+public:
+    explicit LatencyHistogram(int capacity = 512) : m_capacity(capacity) {}
+    
+    void add(double value);
+    int count() const { return static_cast<int>(m_samples.size()); }
+    double percentile(double p) const;
+
+private:
+    std::vector<double> m_samples;
+    size_t m_next = 0;
+    int m_capacity;
+};
+
+struct LatencySummary {
+    int samples = 0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+};
+
+// Rolling per-model latency histograms plus a log of recent timelines that
+// can be exported as JSON Lines (one timeline object per line)
+class LatencyTracker {
+public:
+    enum class Metric {
+        Connect,          // Connect start to TLS done, new connections only
+        TimeToFirstByte,
+        TimeToFirstToken,
+        InterTokenGap,
+        Total
+    };
+    
+    void record(const RequestTimeline& timeline);
+    LatencySummary summary(const QString& modelId, Metric metric) const;
+    QStringList models() const { return m_histograms.keys(); }
+    
+    const std::deque<RequestTimeline>& recent() const { return m_recent; }
+    bool exportJsonLines(const QString& path) const;
+    
+    // Append each finished timeline to this file as well (empty = off)
+    void setLogPath(const QString& path) { m_logPath = path; }
+
+private:
+    struct ModelHistograms {
+        LatencyHistogram connect;
+        LatencyHistogram timeToFirstByte;
+        LatencyHistogram timeToFirstToken;
+        LatencyHistogram interTokenGap{4096};
+        LatencyHistogram total;
+    };
+    
+    static const LatencyHistogram& histogram(const ModelHistograms& entry, Metric metric);
+    
+    QHash<QString, ModelHistograms> m_histograms;
+    std::deque<RequestTimeline> m_recent;
+    QString m_logPath;
+    
+    static constexpr size_t MAX_RECENT_TIMELINES = 1000;
+};
@@ -0,0 +1,163 @@
+#include "ResponseCache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QDebug>
+#include <algorithm>
+#include <vector>
+
+ResponseCache::ResponseCache(const QString& directory, qint64 maxBytes)
+    : m_directory(directory)
+    , m_maxBytes(maxBytes)
+{
+}
+
+void ResponseCache::setDirectory(const QString& directory)
+{
+    if (m_directory == directory) return;
+    
+    m_directory = directory;
+    m_entries.clear();
+    m_totalBytes = 0;
+    m_indexLoaded = false;
+}
+
+void ResponseCache::setMaxBytes(qint64 maxBytes)
+{
+    m_maxBytes = qMax<qint64>(0, maxBytes);
+    if (m_indexLoaded) {
+        evict();
+    }
+}
+
+QByteArray ResponseCache::key(const QByteArray& endpoint, const QByteArray& body)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(endpoint);
+    hash.addData("\n", 1);
+    hash.addData(body);
+    return hash.result().toHex();
+}
+
+void ResponseCache::loadIndex()
+{
+    if (m_indexLoaded || m_directory.isEmpty()) return;
+    m_indexLoaded = true;
+    
+    // The directory listing is the index: size and mtime per entry
+    const QFileInfoList files = QDir(m_directory).entryInfoList({"*.json"}, QDir::Files);
+    for (const QFileInfo& info : files) {
+        Entry entry;
+        entry.size = info.size();
+        entry.lastUsed = info.lastModified().toMSecsSinceEpoch();
+        m_entries.insert(info.completeBaseName().toLatin1(), entry);
+        m_totalBytes += entry.size;
+    }
+}
+
+bool ResponseCache::lookup(const QByteArray& key, CachedResponse& response)
+{
+    loadIndex();
+    
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) return false;
+    
+    QFile file(entryPath(key));
+    if (!file.open(QIODevice::ReadWrite)) {
+        m_totalBytes -= it->size;
+        m_entries.erase(it);
+        return false;
+    }
+    
+    const QJsonObject obj = QJsonDocument::fromJson(file.readAll()).object();
+    if (!obj.contains("content")) {
+        qWarning() << "Dropping unreadable response cache entry:" << file.fileName();
+        file.remove();
+        m_totalBytes -= it->size;
+        m_entries.erase(it);
+        return false;
+    }
+    
+    response.modelId = obj.value("model").toString();
+    response.content = obj.value("content").toString();
+    response.createdAt = QDateTime::fromString(obj.value("created").toString(), Qt::ISODate);
+    response.promptTokens = obj.value("prompt_tokens").toInt();
+    response.completionTokens = obj.value("completion_tokens").toInt();
+    
+    // Recency survives restarts through the file's modification time
+    const QDateTime now = QDateTime::currentDateTime();
+    file.setFileTime(now, QFileDevice::FileModificationTime);
+    it->lastUsed = now.toMSecsSinceEpoch();
+    return true;
+}
+
+void ResponseCache::store(const QByteArray& key, const CachedResponse& response)
+{
+    if (m_directory.isEmpty() || m_maxBytes <= 0) return;
+    loadIndex();
+    
+    if (!QDir().mkpath(m_directory)) {
+        qWarning() << "Cannot create response cache directory:" << m_directory;
+        return;
+    }
+    
+    QJsonObject obj;
+    obj["model"] = response.modelId;
+    obj["content"] = response.content;
+    obj["created"] = response.createdAt.toString(Qt::ISODate);
+    obj["prompt_tokens"] = response.promptTokens;
+    obj["completion_tokens"] = response.completionTokens;
+    const QByteArray data = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+    
+    QSaveFile file(entryPath(key));
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qWarning() << "Cannot write response cache entry:" << file.fileName() << file.errorString();
+        return;
+    }
+    
+    Entry& entry = m_entries[key];
+    m_totalBytes += data.size() - entry.size;
+    entry.size = data.size();
+    entry.lastUsed = QDateTime::currentMSecsSinceEpoch();
+    
+    evict();
+}
+
+void ResponseCache::clear()
+{
+    loadIndex();
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        QFile::remove(entryPath(it.key()));
+    }
+    m_entries.clear();
+    m_totalBytes = 0;
+}
+
+void ResponseCache::evict()
+{
+    if (m_totalBytes <= m_maxBytes) return;
+    
+    std::vector<std::pair<qint64, QByteArray>> byAge;
+    byAge.reserve(m_entries.size());
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        byAge.emplace_back(it->lastUsed, it.key());
+    }
+    std::sort(byAge.begin(), byAge.end());
+    
+    // Oldest first, down to the budget
+    for (const auto& aged : byAge) {
+        if (m_totalBytes <= m_maxBytes) break;
+        QFile::remove(entryPath(aged.second));
+        m_totalBytes -= m_entries.value(aged.second).size;
+        m_entries.remove(aged.second);
+    }
+}
+
+QString ResponseCache::entryPath(const QByteArray& key) const
+{
+    return m_directory + "/" + QString::fromLatin1(key) + ".json";
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+
+// A finished reply stored for replay
+struct CachedResponse {
+    QString modelId;
+    QString content;
+    QDateTime createdAt;
+    int promptTokens = 0;
+    int completionTokens = 0;
+};
+
+// On-disk cache of complete replies, keyed by a SHA-256 of the endpoint and
+// the exact request body. Payload serialization is canonical (sorted keys,
+// cached message fragments), so resending the same model, messages and
+// parameters hits the same entry. One JSON file per entry; the least
+// recently used entries are removed once the total exceeds maxBytes.
+// Used from the GUI thread only.
+class ResponseCache {
+public:
+    explicit ResponseCache(const QString& directory = QString(), qint64 maxBytes = DEFAULT_MAX_BYTES);
+    
+    void setDirectory(const QString& directory);
+    void setMaxBytes(qint64 maxBytes);
+    QString directory() const { return m_directory; }
+    
+    static QByteArray key(const QByteArray& endpoint, const QByteArray& body);
+    
+    bool lookup(const QByteArray& key, CachedResponse& response);
+    void store(const QByteArray& key, const CachedResponse& response);
+    void clear();
+    
+    int entryCount() const { return m_entries.size(); }
+    qint64 totalBytes() const { return m_totalBytes; }
+    
+    static constexpr qint64 DEFAULT_MAX_BYTES = 64 * 1024 * 1024;
+
+private:
+    struct Entry {
+        qint64 size = 0;
+        qint64 lastUsed = 0;     // ms since epoch; file mtime on disk
+    };
+    
+    void loadIndex();
+    void evict();
+    QString entryPath(const QByteArray& key) const;
+    
+    QString m_directory;
+    qint64 m_maxBytes;
+    QHash<QByteArray, Entry> m_entries;
+    qint64 m_totalBytes = 0;
+    bool m_indexLoaded = false;
+};
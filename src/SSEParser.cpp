@@ -0,0 +1,205 @@
+#include "SSEParser.h"
+#include <QIODevice>
+#include <cstring>
+
+SSEParser::SSEParser()
+{
+    m_buffer.reserve(INITIAL_CAPACITY);
+}
+
+void SSEParser::reset()
+{
+    m_buffer.resize(0);
+    m_readPos = 0;
+    m_scanPos = 0;
+    m_skipLineFeed = false;
+
+    m_hasData = false;
+    m_dataBegin = 0;
+    m_dataLength = 0;
+    m_dataJoined = false;
+    m_joinedData.clear();
+    m_eventType.clear();
+}
+
+void SSEParser::feed(const QByteArray& bytes)
+{
+    compact();
+    m_buffer.append(bytes);
+}
+
+qint64 SSEParser::readFrom(QIODevice* device)
+{
+    if (!device) return 0;
+
+    compact();
+
+    const qint64 available = device->bytesAvailable();
+    if (available <= 0) return 0;
+
+    // Read straight into the tail of the buffer instead of going through readAll()
+    const qsizetype oldSize = m_buffer.size();
+    m_buffer.resize(oldSize + available);
+    const qint64 bytesRead = device->read(m_buffer.data() + oldSize, available);
+    m_buffer.resize(oldSize + qMax<qint64>(bytesRead, 0));
+
+    return bytesRead;
+}
+
+bool SSEParser::nextEvent(SSEEvent& event)
+{
+    qsizetype lineBegin = 0;
+    qsizetype lineLength = 0;
+
+    while (nextLine(lineBegin, lineLength)) {
+        if (lineLength == 0) {
+            // Blank line dispatches the event
+            if (m_hasData) {
+                takeEvent(event);
+                return true;
+            }
+            m_eventType.clear();
+            continue;
+        }
+
+        if (m_buffer.at(lineBegin) == ':') {
+            continue; // Comment or keep-alive
+        }
+
+        handleField(lineBegin, lineLength);
+    }
+
+    return false;
+}
+
+bool SSEParser::flush(SSEEvent& event)
+{
+    // Treat an unterminated trailing line as complete at end of stream
+    const qsizetype remaining = m_buffer.size() - m_readPos;
+    if (!m_skipLineFeed && remaining > 0) {
+        const qsizetype lineBegin = m_readPos;
+        m_readPos = m_buffer.size();
+        m_scanPos = m_readPos;
+        if (m_buffer.at(lineBegin) != ':') {
+            handleField(lineBegin, remaining);
+        }
+    }
+
+    if (!m_hasData) return false;
+
+    takeEvent(event);
+    return true;
+}
+
+bool SSEParser::nextLine(qsizetype& lineBegin, qsizetype& lineLength)
+{
+    const qsizetype end = m_buffer.size();
+    const char* base = m_buffer.constData();
+
+    // A CR at the very end of the previous read may be the first half of a CRLF
+    if (m_skipLineFeed) {
+        if (m_readPos >= end) return false;
+        if (base[m_readPos] == '\n') ++m_readPos;
+        m_skipLineFeed = false;
+    }
+
+    m_scanPos = qMax(m_scanPos, m_readPos);
+    if (m_scanPos >= end) return false;
+
+    const char* scanFrom = base + m_scanPos;
+    const qsizetype available = end - m_scanPos;
+
+    const char* lineFeed = static_cast<const char*>(std::memchr(scanFrom, '\n', available));
+    const qsizetype crSearchLength = lineFeed ? lineFeed - scanFrom : available;
+    const char* carriageReturn = static_cast<const char*>(std::memchr(scanFrom, '\r', crSearchLength));
+
+    const char* terminator = carriageReturn ? carriageReturn : lineFeed;
+    if (!terminator) {
+        // Incomplete line: remember how far we scanned so the next read resumes there
+        m_scanPos = end;
+        return false;
+    }
+
+    lineBegin = m_readPos;
+    lineLength = (terminator - base) - m_readPos;
+    m_readPos = (terminator - base) + 1;
+
+    if (carriageReturn) {
+        if (m_readPos < end) {
+            if (base[m_readPos] == '\n') ++m_readPos;
+        } else {
+            m_skipLineFeed = true;
+        }
+    }
+
+    m_scanPos = m_readPos;
+    return true;
+}
+
+void SSEParser::handleField(qsizetype lineBegin, qsizetype lineLength)
+{
+    const char* line = m_buffer.constData() + lineBegin;
+    const char* colon = static_cast<const char*>(std::memchr(line, ':', lineLength));
+
+    const qsizetype nameLength = colon ? colon - line : lineLength;
+    qsizetype valueBegin = colon ? nameLength + 1 : lineLength;
+    if (valueBegin < lineLength && line[valueBegin] == ' ') {
+        ++valueBegin;
+    }
+    const qsizetype valueLength = lineLength - valueBegin;
+
+    if (nameLength == 4 && std::memcmp(line, "data", 4) == 0) {
+        if (!m_hasData) {
+            m_hasData = true;
+            m_dataBegin = lineBegin + valueBegin;
+            m_dataLength = valueLength;
+        } else {
+            // Multi-line data is the only case that needs a copy
+            if (!m_dataJoined) {
+                m_joinedData = QByteArray(m_buffer.constData() + m_dataBegin, m_dataLength);
+                m_dataJoined = true;
+            }
+            m_joinedData.append('\n');
+            m_joinedData.append(line + valueBegin, valueLength);
+        }
+    } else if (nameLength == 5 && std::memcmp(line, "event", 5) == 0) {
+        m_eventType = QByteArray(line + valueBegin, valueLength);
+    }
+
+    // "id" and "retry" are not used by the chat completion endpoints
+}
+
+void SSEParser::takeEvent(SSEEvent& event)
+{
+    if (m_dataJoined) {
+        event.data = m_joinedData;
+    } else {
+        event.data = QByteArray::fromRawData(m_buffer.constData() + m_dataBegin, m_dataLength);
+    }
+    event.eventType = m_eventType;
+
+    m_hasData = false;
+    m_dataJoined = false;
+    m_eventType.clear();
+}
+
+void SSEParser::compact()
+{
+    // Bytes still referenced by an undispatched single-line event must survive
+    qsizetype consumed = m_readPos;
+    if (m_hasData && !m_dataJoined) {
+        consumed = qMin(consumed, m_dataBegin);
+    }
+
+    // Only move memory once the dead prefix dominates, keeping appends amortised O(1)
+    if (consumed == 0 || (consumed < m_buffer.size() && consumed < m_buffer.size() / 2)) {
+        return;
+    }
+
+    m_buffer.remove(0, consumed);
+    m_readPos -= consumed;
+    m_scanPos -= consumed;
+    if (m_hasData && !m_dataJoined) {
+        m_dataBegin -= consumed;
+    }
+}
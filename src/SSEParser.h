@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QByteArray>
+#include <QtGlobal>
+
+class QIODevice;
+
+// A single dispatched Server-Sent Event. Both fields may be raw views into
+// the parser's buffer and are only valid until the next call that feeds data.
+struct SSEEvent {
+    QByteArray data;
+    QByteArray eventType;
+
+    bool isDone() const { return data == "[DONE]"; }
+};
+
+// Incremental byte-level parser for text/event-stream responses.
+//
+// Bytes are appended to a single reusable buffer and scanned with memchr, so
+// complete lines are never copied or converted to QString. A single-line
+// `data:` field (the common case for chat completions) is handed out as a
+// view into the buffer; only events with several `data:` lines are joined.
+// Lines are split on LF, CRLF or a lone CR, and comment lines (": ...") used
+// as keep-alives are skipped. Because splitting only happens on ASCII line
+// terminators, a UTF-8 sequence split across two network reads is simply
+// reassembled in the buffer before it is ever decoded.
+class SSEParser {
+public:
+    SSEParser();
+
+    void reset();
+
+    // Input
+    void feed(const QByteArray& bytes);
+    qint64 readFrom(QIODevice* device);
+
+    // Output
+    bool nextEvent(SSEEvent& event);
+    bool flush(SSEEvent& event);
+
+    qsizetype bufferedBytes() const { return m_buffer.size() - m_readPos; }
+
+private:
+    bool nextLine(qsizetype& lineBegin, qsizetype& lineLength);
+    void handleField(qsizetype lineBegin, qsizetype lineLength);
+    void takeEvent(SSEEvent& event);
+    void compact();
+
+    QByteArray m_buffer;
+    qsizetype m_readPos = 0;
+    qsizetype m_scanPos = 0;
+    bool m_skipLineFeed = false;
+
+    // Event being assembled
+    bool m_hasData = false;
+    qsizetype m_dataBegin = 0;
+    qsizetype m_dataLength = 0;
+    bool m_dataJoined = false;
+    QByteArray m_joinedData;
+    QByteArray m_eventType;
+
+    static constexpr qsizetype INITIAL_CAPACITY = 16 * 1024;
+};
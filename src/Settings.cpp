@@ -250,6 +250,22 @@ void Settings::loadFromQSettings()
     m_settings.baseURL = m_qsettings->value("baseURL", m_settings.baseURL).toString();
     m_qsettings->endGroup();
     
+    m_settings.backends.clear();
+    const int backendCount = m_qsettings->beginReadArray("Backends");
+    for (int i = 0; i < backendCount; ++i) {
+        m_qsettings->setArrayIndex(i);
+        BackendConfig backend;
+        backend.id = m_qsettings->value("id").toString();
+        backend.name = m_qsettings->value("name", backend.id).toString();
+        backend.kind = BackendConfig::kindFromName(m_qsettings->value("kind").toString());
+        backend.baseUrl = m_qsettings->value("baseURL").toString();
+        backend.apiKey = decryptAPIKey(m_qsettings->value("apiKey", "").toString());
+        backend.requestTimeout = m_qsettings->value("requestTimeout", backend.requestTimeout).toInt();
+        backend.enabled = m_qsettings->value("enabled", backend.enabled).toBool();
+        m_settings.backends.push_back(backend);
+    }
+    m_qsettings->endArray();
+    
     m_qsettings->beginGroup("UI");
     m_settings.darkMode = m_qsettings->value("darkMode", m_settings.darkMode).toBool();
     m_settings.fontSize = m_qsettings->value("fontSize", m_settings.fontSize).toInt();
@@ -265,6 +281,11 @@ void Settings::loadFromQSettings()
     m_settings.enableSoundNotifications = m_qsettings->value("enableSoundNotifications", m_settings.enableSoundNotifications).toBool();
     m_settings.maxHistoryMessages = m_qsettings->value("maxHistoryMessages", m_settings.maxHistoryMessages).toInt();
     m_settings.saveHistory = m_qsettings->value("saveHistory", m_settings.saveHistory).toBool();
+    m_settings.streamFlushIntervalMs = m_qsettings->value("streamFlushIntervalMs", m_settings.streamFlushIntervalMs).toInt();
+    m_settings.responseTokenReserve = m_qsettings->value("responseTokenReserve", m_settings.responseTokenReserve).toInt();
+    m_settings.tokenizerPath = m_qsettings->value("tokenizerPath", m_settings.tokenizerPath).toString();
+    m_settings.comparisonModels = m_qsettings->value("comparisonModels", m_settings.comparisonModels).toStringList();
+    m_settings.temperature = m_qsettings->value("temperature", m_settings.temperature).toDouble();
     m_qsettings->endGroup();
     
     m_qsettings->beginGroup("Files");
@@ -275,7 +296,16 @@ void Settings::loadFromQSettings()
     
     m_qsettings->beginGroup("Advanced");
     m_settings.requestTimeout = m_qsettings->value("requestTimeout", m_settings.requestTimeout).toInt();
+    m_settings.streamStallTimeout = m_qsettings->value("streamStallTimeout", m_settings.streamStallTimeout).toInt();
     m_settings.maxRetries = m_qsettings->value("maxRetries", m_settings.maxRetries).toInt();
+    m_settings.rateLimitPerMinute = m_qsettings->value("rateLimitPerMinute", m_settings.rateLimitPerMinute).toInt();
+    m_settings.modelRateLimitPerMinute = m_qsettings->value("modelRateLimitPerMinute", m_settings.modelRateLimitPerMinute).toInt();
+    m_settings.batchConcurrency = m_qsettings->value("batchConcurrency", m_settings.batchConcurrency).toInt();
+    m_settings.enablePromptCaching = m_qsettings->value("enablePromptCaching", m_settings.enablePromptCaching).toBool();
+    m_settings.enableResponseCache = m_qsettings->value("enableResponseCache", m_settings.enableResponseCache).toBool();
+    m_settings.cacheSampledResponses = m_qsettings->value("cacheSampledResponses", m_settings.cacheSampledResponses).toBool();
+    m_settings.responseCacheSizeMB = m_qsettings->value("responseCacheSizeMB", m_settings.responseCacheSizeMB).toInt();
+    m_settings.latencyLogPath = m_qsettings->value("latencyLogPath", m_settings.latencyLogPath).toString();
     m_settings.enableLogging = m_qsettings->value("enableLogging", m_settings.enableLogging).toBool();
     m_settings.logLevel = m_qsettings->value("logLevel", m_settings.logLevel).toString();
     m_qsettings->endGroup();
@@ -300,6 +330,20 @@ void Settings::saveToQSettings()
     m_qsettings->setValue("baseURL", m_settings.baseURL);
     m_qsettings->endGroup();
     
+    m_qsettings->beginWriteArray("Backends", static_cast<int>(m_settings.backends.size()));
+    for (int i = 0; i < static_cast<int>(m_settings.backends.size()); ++i) {
+        const BackendConfig& backend = m_settings.backends[i];
+        m_qsettings->setArrayIndex(i);
+        m_qsettings->setValue("id", backend.id);
+        m_qsettings->setValue("name", backend.name);
+        m_qsettings->setValue("kind", BackendConfig::kindName(backend.kind));
+        m_qsettings->setValue("baseURL", backend.baseUrl);
+        m_qsettings->setValue("apiKey", encryptAPIKey(backend.apiKey));
+        m_qsettings->setValue("requestTimeout", backend.requestTimeout);
+        m_qsettings->setValue("enabled", backend.enabled);
+    }
+    m_qsettings->endArray();
+    
     m_qsettings->beginGroup("UI");
     m_qsettings->setValue("darkMode", m_settings.darkMode);
     m_qsettings->setValue("fontSize", m_settings.fontSize);
@@ -315,6 +359,11 @@ void Settings::saveToQSettings()
     m_qsettings->setValue("enableSoundNotifications", m_settings.enableSoundNotifications);
     m_qsettings->setValue("maxHistoryMessages", m_settings.maxHistoryMessages);
     m_qsettings->setValue("saveHistory", m_settings.saveHistory);
+    m_qsettings->setValue("streamFlushIntervalMs", m_settings.streamFlushIntervalMs);
+    m_qsettings->setValue("responseTokenReserve", m_settings.responseTokenReserve);
+    m_qsettings->setValue("tokenizerPath", m_settings.tokenizerPath);
+    m_qsettings->setValue("comparisonModels", m_settings.comparisonModels);
+    m_qsettings->setValue("temperature", m_settings.temperature);
     m_qsettings->endGroup();
     
     m_qsettings->beginGroup("Files");
@@ -325,7 +374,16 @@ void Settings::saveToQSettings()
     
     m_qsettings->beginGroup("Advanced");
     m_qsettings->setValue("requestTimeout", m_settings.requestTimeout);
+    m_qsettings->setValue("streamStallTimeout", m_settings.streamStallTimeout);
     m_qsettings->setValue("maxRetries", m_settings.maxRetries);
+    m_qsettings->setValue("rateLimitPerMinute", m_settings.rateLimitPerMinute);
+    m_qsettings->setValue("modelRateLimitPerMinute", m_settings.modelRateLimitPerMinute);
+    m_qsettings->setValue("batchConcurrency", m_settings.batchConcurrency);
+    m_qsettings->setValue("enablePromptCaching", m_settings.enablePromptCaching);
+    m_qsettings->setValue("enableResponseCache", m_settings.enableResponseCache);
+    m_qsettings->setValue("cacheSampledResponses", m_settings.cacheSampledResponses);
+    m_qsettings->setValue("responseCacheSizeMB", m_settings.responseCacheSizeMB);
+    m_qsettings->setValue("latencyLogPath", m_settings.latencyLogPath);
     m_qsettings->setValue("enableLogging", m_settings.enableLogging);
     m_qsettings->setValue("logLevel", m_settings.logLevel);
     m_qsettings->endGroup();
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "ChatBackend.h"
 #include <QObject>
 #include <QString>
 #include <QStringList>
@@ -14,6 +15,7 @@ struct AppSettings {
     QString apiKey;
     QString selectedModel = "openai/gpt-3.5-turbo";
     QString baseURL = "https://openrouter.ai/api/v1";
+    std::vector<BackendConfig> backends; // Local or self-hosted servers, alongside OpenRouter
     
     // UI Preferences
     bool darkMode = true;
@@ -29,6 +31,11 @@ struct AppSettings {
     bool enableSoundNotifications = false;
     int maxHistoryMessages = 1000;
     bool saveHistory = true;
+    int streamFlushIntervalMs = 16; // UI refresh cadence while streaming (0 = every delta)
+    int responseTokenReserve = 2048; // Context tokens kept free for the reply (sent as max_tokens)
+    QString tokenizerPath; // Directory with vocab.json and merges.txt (empty = app data "tokenizer")
+    QStringList comparisonModels; // Models asked side by side in compare mode (needs at least two)
+    double temperature = 0.7;     // Sampling temperature sent with every request (0 = deterministic)
     
     // File Upload Settings
     int maxFileSize = 10 * 1024 * 1024; // 10MB
@@ -36,8 +43,17 @@ struct AppSettings {
     QStringList allowedFileTypes = {".txt", ".md", ".cpp", ".h", ".py", ".js", ".json", ".xml", ".csv"};
     
     // Advanced Settings
-    int requestTimeout = 30;
+    int requestTimeout = 30;        // Seconds to wait for the first byte of a response
+    int streamStallTimeout = 30;    // Seconds a stream may go silent before it is retried or failed
     int maxRetries = 3;
+    int rateLimitPerMinute = 0;         // Local cap on chat requests per minute (0 = server limits only)
+    int modelRateLimitPerMinute = 0;    // Same, per model
+    int batchConcurrency = 4;       // Requests in flight at once when running a batch file
+    bool enablePromptCaching = false; // Mark cache breakpoints for providers that support them
+    bool enableResponseCache = false;   // Replay stored replies to repeated temperature-0 requests
+    bool cacheSampledResponses = false; // Also cache and replay requests with temperature above 0
+    int responseCacheSizeMB = 64;       // Disk budget; least recently used replies are removed first
+    QString latencyLogPath;         // Append each request's latency timeline here as JSON Lines (empty = off)
     bool enableLogging = false;
     QString logLevel = "INFO";
     
@@ -21,6 +21,7 @@
 
 class Settings;
 class OpenRouterAPI;
+class ModelPickerWidget;
 
 QT_BEGIN_NAMESPACE
 class QDialogButtonBox;
@@ -92,7 +93,7 @@ private:
     // API tab
     QWidget* m_apiTab;
     QLineEdit* m_apiKeyLineEdit;
-    QComboBox* m_modelComboBox;
+    ModelPickerWidget* m_modelPicker;
     QLineEdit* m_baseURLLineEdit;
     QPushButton* m_testConnectionButton;
     QPushButton* m_refreshModelsButton;
@@ -0,0 +1,73 @@
+#include "StreamCoalescer.h"
+
+StreamCoalescer::StreamCoalescer(QObject *parent)
+    : QObject(parent)
+{
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setTimerType(Qt::PreciseTimer);
+    connect(m_flushTimer, &QTimer::timeout, this, &StreamCoalescer::flushAll);
+}
+
+void StreamCoalescer::setFlushInterval(int milliseconds)
+{
+    m_flushInterval = qMax(0, milliseconds);
+    
+    if (m_flushInterval == 0) {
+        flushAll();
+    }
+}
+
+void StreamCoalescer::append(quint64 requestId, const QString& text)
+{
+    if (text.isEmpty()) return;
+    
+    if (m_flushInterval == 0) {
+        emit flushed(requestId, text);
+        return;
+    }
+    
+    m_pending[requestId].append(text);
+    
+    // The first delta after a flush opens the next frame window
+    if (!m_flushTimer->isActive()) {
+        m_flushTimer->start(m_flushInterval);
+    }
+}
+
+void StreamCoalescer::flush(quint64 requestId)
+{
+    auto it = m_pending.find(requestId);
+    if (it == m_pending.end()) return;
+    
+    const QString text = it.value();
+    m_pending.erase(it);
+    
+    if (m_pending.isEmpty()) {
+        m_flushTimer->stop();
+    }
+    
+    emit flushed(requestId, text);
+}
+
+void StreamCoalescer::flushAll()
+{
+    m_flushTimer->stop();
+    
+    // Swap out first: slots may append more text while we emit
+    QHash<quint64, QString> pending;
+    pending.swap(m_pending);
+    
+    for (auto it = pending.cbegin(); it != pending.cend(); ++it) {
+        emit flushed(it.key(), it.value());
+    }
+}
+
+void StreamCoalescer::discard(quint64 requestId)
+{
+    m_pending.remove(requestId);
+    
+    if (m_pending.isEmpty()) {
+        m_flushTimer->stop();
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <QTimer>
+
+// Accumulates streamed text per request and releases it at most once per
+// flush interval, so downstream UI work scales with the frame rate rather
+// than with the rate at which a model emits deltas.
+class StreamCoalescer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit StreamCoalescer(QObject *parent = nullptr);
+    
+    // An interval of 0 disables coalescing and forwards every delta immediately
+    void setFlushInterval(int milliseconds);
+    int flushInterval() const { return m_flushInterval; }
+    
+    void append(quint64 requestId, const QString& text);
+    void flush(quint64 requestId);
+    void flushAll();
+    void discard(quint64 requestId);
+    
+    bool hasPending(quint64 requestId) const { return m_pending.contains(requestId); }
+
+signals:
+    void flushed(quint64 requestId, const QString& text);
+
+private:
+    QTimer *m_flushTimer;
+    QHash<quint64, QString> m_pending;
+    int m_flushInterval = 16;
+};
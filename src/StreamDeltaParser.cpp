@@ -0,0 +1,474 @@
+#include "StreamDeltaParser.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr int MAX_NESTING_DEPTH = 64;
+
+struct JsonKey {
+    const char* data = nullptr;
+    qsizetype size = 0;
+
+    template <qsizetype N>
+    bool operator==(const char (&literal)[N]) const {
+        return size == N - 1 && std::memcmp(data, literal, N - 1) == 0;
+    }
+};
+
+void appendUtf8(QByteArray& out, uint codePoint)
+{
+    if (codePoint < 0x80) {
+        out.append(static_cast<char>(codePoint));
+    } else if (codePoint < 0x800) {
+        out.append(static_cast<char>(0xC0 | (codePoint >> 6)));
+        out.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else if (codePoint < 0x10000) {
+        out.append(static_cast<char>(0xE0 | (codePoint >> 12)));
+        out.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    } else {
+        out.append(static_cast<char>(0xF0 | (codePoint >> 18)));
+        out.append(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+        out.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+        out.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+    }
+}
+
+bool readHex4(const char* p, const char* end, uint& value)
+{
+    if (end - p < 4) return false;
+
+    value = 0;
+    for (int i = 0; i < 4; ++i) {
+        const char c = p[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= static_cast<uint>(c - '0');
+        else if (c >= 'a' && c <= 'f') value |= static_cast<uint>(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') value |= static_cast<uint>(c - 'A' + 10);
+        else return false;
+    }
+    return true;
+}
+
+// Decodes the body of a JSON string literal that is known to contain escapes
+bool decodeEscapedString(const char* begin, qsizetype length, QString& out)
+{
+    const char* p = begin;
+    const char* end = begin + length;
+
+    QByteArray utf8;
+    utf8.reserve(static_cast<int>(length));
+
+    while (p < end) {
+        const char* backslash = static_cast<const char*>(std::memchr(p, '\\', end - p));
+        if (!backslash) {
+            utf8.append(p, static_cast<int>(end - p));
+            break;
+        }
+
+        utf8.append(p, static_cast<int>(backslash - p));
+        p = backslash + 1;
+        if (p >= end) return false;
+
+        switch (*p++) {
+            case '"': utf8.append('"'); break;
+            case '\\': utf8.append('\\'); break;
+            case '/': utf8.append('/'); break;
+            case 'b': utf8.append('\b'); break;
+            case 'f': utf8.append('\f'); break;
+            case 'n': utf8.append('\n'); break;
+            case 'r': utf8.append('\r'); break;
+            case 't': utf8.append('\t'); break;
+            case 'u': {
+                uint codePoint = 0;
+                if (!readHex4(p, end, codePoint)) return false;
+                p += 4;
+
+                if (codePoint >= 0xD800 && codePoint <= 0xDBFF) {
+                    // High surrogate must be followed by an escaped low surrogate
+                    uint low = 0;
+                    if (end - p >= 6 && p[0] == '\\' && p[1] == 'u'
+                        && readHex4(p + 2, end, low) && low >= 0xDC00 && low <= 0xDFFF) {
+                        codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                        p += 6;
+                    } else {
+                        codePoint = 0xFFFD;
+                    }
+                } else if (codePoint >= 0xDC00 && codePoint <= 0xDFFF) {
+                    codePoint = 0xFFFD;
+                }
+
+                appendUtf8(utf8, codePoint);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+
+    out = QString::fromUtf8(utf8);
+    return true;
+}
+
+class JsonScanner {
+public:
+    JsonScanner(const char* begin, const char* end) : m_pos(begin), m_end(end) {}
+
+    void skipWhitespace() {
+        while (m_pos < m_end && (*m_pos == ' ' || *m_pos == '\n' || *m_pos == '\r' || *m_pos == '\t')) {
+            ++m_pos;
+        }
+    }
+
+    bool consume(char c) {
+        skipWhitespace();
+        if (m_pos < m_end && *m_pos == c) {
+            ++m_pos;
+            return true;
+        }
+        return false;
+    }
+
+    bool consumeNull() {
+        skipWhitespace();
+        if (m_end - m_pos >= 4 && std::memcmp(m_pos, "null", 4) == 0) {
+            m_pos += 4;
+            return true;
+        }
+        return false;
+    }
+
+    bool atEnd() {
+        skipWhitespace();
+        return m_pos == m_end;
+    }
+
+    // Locates a string token without decoding it
+    bool readRawString(const char*& begin, qsizetype& length, bool& hasEscapes) {
+        if (!consume('"')) return false;
+
+        begin = m_pos;
+        hasEscapes = false;
+
+        while (true) {
+            const char* quote = static_cast<const char*>(std::memchr(m_pos, '"', m_end - m_pos));
+            if (!quote) return false;
+
+            const char* backslash = static_cast<const char*>(std::memchr(m_pos, '\\', quote - m_pos));
+            if (!backslash) {
+                length = quote - begin;
+                m_pos = quote + 1;
+                return true;
+            }
+
+            hasEscapes = true;
+            m_pos = backslash + 2; // Skip the escaped character, which may be a quote
+            if (m_pos > m_end) return false;
+        }
+    }
+
+    bool readKey(JsonKey& key) {
+        bool hasEscapes = false;
+        if (!readRawString(key.data, key.size, hasEscapes)) return false;
+        if (hasEscapes) key.size = -1; // Never matches the plain keys we look for
+        return consume(':');
+    }
+
+    bool readString(QString& out) {
+        const char* begin = nullptr;
+        qsizetype length = 0;
+        bool hasEscapes = false;
+        if (!readRawString(begin, length, hasEscapes)) return false;
+
+        if (!hasEscapes) {
+            out = QString::fromUtf8(begin, static_cast<int>(length));
+            return true;
+        }
+        return decodeEscapedString(begin, length, out);
+    }
+
+    bool readNullableString(QString& out) {
+        if (consumeNull()) {
+            out.clear();
+            return true;
+        }
+        return readString(out);
+    }
+
+    bool readInt(int& out) {
+        if (consumeNull()) {
+            out = 0;
+            return true;
+        }
+
+        skipWhitespace();
+        bool negative = false;
+        if (m_pos < m_end && *m_pos == '-') {
+            negative = true;
+            ++m_pos;
+        }
+
+        const char* digits = m_pos;
+        qint64 value = 0;
+        while (m_pos < m_end && *m_pos >= '0' && *m_pos <= '9') {
+            value = value * 10 + (*m_pos - '0');
+            if (value > std::numeric_limits<int>::max()) return false;
+            ++m_pos;
+        }
+
+        // Token counts are integers; anything else goes to the generic parser
+        if (m_pos == digits || (m_pos < m_end && (*m_pos == '.' || *m_pos == 'e' || *m_pos == 'E'))) {
+            return false;
+        }
+
+        out = static_cast<int>(negative ? -value : value);
+        return true;
+    }
+
+    bool skipValue(int depth = 0) {
+        if (depth > MAX_NESTING_DEPTH) return false;
+
+        skipWhitespace();
+        if (m_pos >= m_end) return false;
+
+        switch (*m_pos) {
+            case '"': {
+                const char* begin = nullptr;
+                qsizetype length = 0;
+                bool hasEscapes = false;
+                return readRawString(begin, length, hasEscapes);
+            }
+            case '{': {
+                ++m_pos;
+                if (consume('}')) return true;
+                do {
+                    JsonKey key;
+                    if (!readKey(key) || !skipValue(depth + 1)) return false;
+                } while (consume(','));
+                return consume('}');
+            }
+            case '[': {
+                ++m_pos;
+                if (consume(']')) return true;
+                do {
+                    if (!skipValue(depth + 1)) return false;
+                } while (consume(','));
+                return consume(']');
+            }
+            default: {
+                // Number, true, false or null
+                const char* start = m_pos;
+                while (m_pos < m_end && *m_pos != ',' && *m_pos != '}' && *m_pos != ']'
+                       && *m_pos != ' ' && *m_pos != '\n' && *m_pos != '\r' && *m_pos != '\t') {
+                    ++m_pos;
+                }
+                return m_pos > start;
+            }
+        }
+    }
+
+private:
+    const char* m_pos;
+    const char* m_end;
+};
+
+bool parseDeltaObject(JsonScanner& scanner, StreamDelta& delta)
+{
+    if (scanner.consumeNull()) return true;
+    if (!scanner.consume('{')) return false;
+    if (scanner.consume('}')) return true;
+
+    do {
+        JsonKey key;
+        if (!scanner.readKey(key)) return false;
+
+        const bool ok = (key == "content") ? scanner.readNullableString(delta.content)
+                                           : scanner.skipValue();
+        if (!ok) return false;
+    } while (scanner.consume(','));
+
+    return scanner.consume('}');
+}
+
+bool parseFirstChoice(JsonScanner& scanner, StreamDelta& delta)
+{
+    if (!scanner.consume('{')) return false;
+    if (scanner.consume('}')) return true;
+
+    do {
+        JsonKey key;
+        if (!scanner.readKey(key)) return false;
+
+        bool ok = false;
+        if (key == "delta") {
+            ok = parseDeltaObject(scanner, delta);
+        } else if (key == "finish_reason") {
+            ok = scanner.readNullableString(delta.finishReason);
+        } else {
+            ok = scanner.skipValue();
+        }
+        if (!ok) return false;
+    } while (scanner.consume(','));
+
+    return scanner.consume('}');
+}
+
+bool parseChoices(JsonScanner& scanner, StreamDelta& delta)
+{
+    if (scanner.consumeNull()) return true;
+    if (!scanner.consume('[')) return false;
+    if (scanner.consume(']')) return true;
+
+    if (!parseFirstChoice(scanner, delta)) return false;
+    while (scanner.consume(',')) {
+        if (!scanner.skipValue()) return false;
+    }
+
+    return scanner.consume(']');
+}
+
+bool parseTokenDetails(JsonScanner& scanner, StreamDelta& delta)
+{
+    if (scanner.consumeNull()) return true;
+    if (!scanner.consume('{')) return false;
+    if (scanner.consume('}')) return true;
+
+    do {
+        JsonKey key;
+        if (!scanner.readKey(key)) return false;
+
+        bool ok = false;
+        if (key == "cached_tokens") {
+            ok = scanner.readInt(delta.cachedTokens);
+        } else {
+            ok = scanner.skipValue();
+        }
+        if (!ok) return false;
+    } while (scanner.consume(','));
+
+    return scanner.consume('}');
+}
+
+bool parseUsage(JsonScanner& scanner, StreamDelta& delta)
+{
+    if (scanner.consumeNull()) return true;
+    if (!scanner.consume('{')) return false;
+
+    delta.hasUsage = true;
+    if (scanner.consume('}')) return true;
+
+    do {
+        JsonKey key;
+        if (!scanner.readKey(key)) return false;
+
+        bool ok = false;
+        if (key == "prompt_tokens") {
+            ok = scanner.readInt(delta.promptTokens);
+        } else if (key == "completion_tokens") {
+            ok = scanner.readInt(delta.completionTokens);
+        } else if (key == "total_tokens") {
+            ok = scanner.readInt(delta.totalTokens);
+        } else if (key == "prompt_tokens_details") {
+            ok = parseTokenDetails(scanner, delta);
+        } else {
+            ok = scanner.skipValue();
+        }
+        if (!ok) return false;
+    } while (scanner.consume(','));
+
+    return scanner.consume('}');
+}
+
+} // namespace
+
+bool StreamDeltaParser::parse(const QByteArray& json, StreamDelta& delta)
+{
+    return parseFast(json, delta) || parseGeneric(json, delta);
+}
+
+bool StreamDeltaParser::parseFast(const QByteArray& json, StreamDelta& delta)
+{
+    delta.resetChunkFields();
+
+    JsonScanner scanner(json.constData(), json.constData() + json.size());
+    if (!scanner.consume('{')) return false;
+    if (scanner.consume('}')) return scanner.atEnd();
+
+    do {
+        JsonKey key;
+        if (!scanner.readKey(key)) return false;
+
+        bool ok = false;
+        if (key == "choices") {
+            ok = parseChoices(scanner, delta);
+        } else if (key == "usage") {
+            ok = parseUsage(scanner, delta);
+        } else if (key == "id" && delta.id.isEmpty()) {
+            ok = scanner.readNullableString(delta.id);
+        } else if (key == "model" && delta.model.isEmpty()) {
+            ok = scanner.readNullableString(delta.model);
+        } else if (key == "error") {
+            return false; // Let the generic parser build the error message
+        } else {
+            ok = scanner.skipValue();
+        }
+        if (!ok) return false;
+    } while (scanner.consume(','));
+
+    return scanner.consume('}') && scanner.atEnd();
+}
+
+bool StreamDeltaParser::parseGeneric(const QByteArray& json, StreamDelta& delta)
+{
+    delta.resetChunkFields();
+
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(json, &error);
+
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        return false;
+    }
+
+    QJsonObject obj = doc.object();
+
+    if (delta.id.isEmpty()) {
+        delta.id = obj["id"].toString();
+    }
+    if (delta.model.isEmpty()) {
+        delta.model = obj["model"].toString();
+    }
+
+    if (obj.contains("error")) {
+        QJsonObject errorObj = obj["error"].toObject();
+        delta.errorMessage = errorObj["message"].toString();
+        if (delta.errorMessage.isEmpty()) {
+            delta.errorMessage = QString::fromUtf8(QJsonDocument(errorObj).toJson(QJsonDocument::Compact));
+        }
+    }
+
+    if (obj.contains("choices")) {
+        QJsonArray choices = obj["choices"].toArray();
+        if (!choices.isEmpty()) {
+            QJsonObject choice = choices[0].toObject();
+            QJsonObject deltaObj = choice["delta"].toObject();
+
+            delta.content = deltaObj["content"].toString();
+            delta.finishReason = choice["finish_reason"].toString();
+        }
+    }
+
+    if (obj.contains("usage") && obj["usage"].isObject()) {
+        QJsonObject usage = obj["usage"].toObject();
+        delta.hasUsage = true;
+        delta.promptTokens = usage["prompt_tokens"].toInt();
+        delta.completionTokens = usage["completion_tokens"].toInt();
+        delta.totalTokens = usage["total_tokens"].toInt();
+        delta.cachedTokens = usage["prompt_tokens_details"].toObject()["cached_tokens"].toInt();
+    }
+
+    return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+// Fields of interest from one chat.completion.chunk. The id and model are
+// constant for a stream, so they are only decoded while still empty; the
+// remaining fields are reset on every parse.
+struct StreamDelta {
+    QString id;
+    QString model;
+    QString content;
+    QString finishReason;
+    QString errorMessage;
+
+    bool hasUsage = false;
+    int promptTokens = 0;
+    int completionTokens = 0;
+    int totalTokens = 0;
+    int cachedTokens = 0;     // usage.prompt_tokens_details.cached_tokens
+
+    void resetChunkFields() {
+        content.clear();
+        finishReason.clear();
+        errorMessage.clear();
+        hasUsage = false;
+        promptTokens = 0;
+        completionTokens = 0;
+        totalTokens = 0;
+        cachedTokens = 0;
+    }
+};
+
+// Extracts StreamDelta fields from streamed chat completion chunks.
+//
+// parseFast() is a forward-only scanner for the OpenAI/OpenRouter chunk shape
+// that decodes only the strings it needs and skips everything else without
+// building a DOM. It returns false for anything it does not recognise
+// (error objects, type mismatches, malformed input), in which case parse()
+// falls back to the QJsonDocument-based parseGeneric().
+class StreamDeltaParser {
+public:
+    static bool parse(const QByteArray& json, StreamDelta& delta);
+    static bool parseFast(const QByteArray& json, StreamDelta& delta);
+    static bool parseGeneric(const QByteArray& json, StreamDelta& delta);
+};
@@ -0,0 +1,307 @@
+#include "StreamJournal.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QStringList>
+#include <QtEndian>
+#include <QDebug>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr int RECORD_HEADER_SIZE = 1 + 4 + 2;
+constexpr int JOURNAL_VERSION = 2;
+constexpr quint32 MAX_RECORD_SIZE = 256 * 1024 * 1024;
+
+QString roleName(MessageRole role)
+{
+    switch (role) {
+        case MessageRole::User: return "user";
+        case MessageRole::Assistant: return "assistant";
+        case MessageRole::System: return "system";
+    }
+    return "user";
+}
+
+MessageRole roleFromName(const QString& name)
+{
+    if (name == "assistant") return MessageRole::Assistant;
+    if (name == "system") return MessageRole::System;
+    return MessageRole::User;
+}
+
+quint16 checksum(const QByteArray& payload)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    return qChecksum(QByteArrayView(payload));
+#else
+    return qChecksum(payload.constData(), static_cast<uint>(payload.size()));
+#endif
+}
+
+} // namespace
+
+StreamJournal::StreamJournal(const QString& directory, QObject *parent)
+    : QObject(parent)
+    , m_directory(directory)
+{
+    m_syncTimer = new QTimer(this);
+    m_syncTimer->setInterval(SYNC_INTERVAL_MS);
+    connect(m_syncTimer, &QTimer::timeout, this, &StreamJournal::syncAll);
+}
+
+StreamJournal::~StreamJournal()
+{
+    // Interrupted replies stay on disk for the next start
+    for (OpenJournal* journal : m_journals) {
+        syncFile(journal->file);
+        delete journal;
+    }
+}
+
+QByteArray StreamJournal::encodeHeader(const std::vector<Message>& conversation, const QString& modelId)
+{
+    QJsonArray messages;
+    for (const Message& msg : conversation) {
+        QJsonObject obj;
+        obj["id"] = msg.id;
+        obj["role"] = roleName(msg.role);
+        obj["content"] = msg.content;
+        obj["timestamp"] = msg.timestamp.toString(Qt::ISODateWithMs);
+    
+        // Attachment data is not journalled; the path is enough to reload it
+        if (!msg.attachments.empty()) {
+            QJsonArray attachments;
+            for (const auto& attachment : msg.attachments) {
+                QJsonObject attachmentObj;
+                attachmentObj["filename"] = attachment->filename;
+                attachmentObj["path"] = attachment->filepath;
+                attachmentObj["mime_type"] = attachment->mimeType;
+                attachmentObj["image"] = attachment->isImage;
+                attachments.append(attachmentObj);
+            }
+            obj["attachments"] = attachments;
+        }
+        messages.append(obj);
+    }
+    
+    QJsonObject header;
+    header["version"] = JOURNAL_VERSION;
+    header["model"] = modelId;
+    header["started"] = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+    header["messages"] = messages;
+    return QJsonDocument(header).toJson(QJsonDocument::Compact);
+}
+
+std::shared_ptr<Attachment> StreamJournal::restoreAttachment(const QJsonObject& obj)
+{
+    QFile file(obj.value("path").toString());
+    if (file.fileName().isEmpty() || !file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+    const QByteArray data = file.readAll();
+    
+    auto attachment = std::make_shared<Attachment>(obj.value("filename").toString(), file.fileName(),
+                                                   obj.value("mime_type").toString(), obj.value("image").toBool());
+    attachment->data = std::make_shared<const QByteArray>(data);
+    attachment->size = data.size();
+    return attachment;
+}
+
+void StreamJournal::begin(const QString& replyId, std::shared_ptr<const std::vector<Message>> conversation,
+                          const QString& modelId)
+{
+    if (m_journals.contains(replyId) || !conversation) return;
+    
+    if (!QDir().mkpath(m_directory)) {
+        qWarning() << "Cannot create journal directory:" << m_directory;
+        return;
+    }
+    
+    auto* journal = new OpenJournal;
+    journal->file.setFileName(journalPath(replyId));
+    if (!journal->file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        qWarning() << "Cannot open stream journal:" << journal->file.fileName() << journal->file.errorString();
+        delete journal;
+        return;
+    }
+    
+    m_journals.insert(replyId, journal);
+    writeRecord(*journal, HeaderRecord, encodeHeader(*conversation, modelId));
+    
+    // The header is what makes a journal recoverable, so it is synced at once
+    syncFile(journal->file);
+    journal->unsyncedBytes = 0;
+    
+    if (!m_syncTimer->isActive()) {
+        m_syncTimer->start();
+    }
+}
+
+void StreamJournal::append(const QString& replyId, const QString& delta)
+{
+    OpenJournal* journal = m_journals.value(replyId, nullptr);
+    if (!journal || delta.isEmpty()) return;
+    
+    writeRecord(*journal, DeltaRecord, delta.toUtf8());
+    if (journal->unsyncedBytes >= SYNC_BYTES) {
+        syncFile(journal->file);
+        journal->unsyncedBytes = 0;
+    }
+}
+
+void StreamJournal::finish(const QString& replyId)
+{
+    OpenJournal* journal = m_journals.take(replyId);
+    if (!journal) return;
+    
+    // The reply now lives in the conversation; nothing left to recover
+    journal->file.close();
+    journal->file.remove();
+    delete journal;
+    
+    if (m_journals.isEmpty()) {
+        m_syncTimer->stop();
+    }
+}
+
+void StreamJournal::syncAll()
+{
+    for (OpenJournal* journal : m_journals) {
+        if (journal->unsyncedBytes > 0) {
+            syncFile(journal->file);
+            journal->unsyncedBytes = 0;
+        }
+    }
+}
+
+bool StreamJournal::writeRecord(OpenJournal& journal, RecordType type, const QByteArray& payload)
+{
+    char header[RECORD_HEADER_SIZE];
+    header[0] = static_cast<char>(type);
+    qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), header + 1);
+    qToLittleEndian<quint16>(checksum(payload), header + 5);
+    
+    // One write per record so a kill leaves at most one torn record at the end
+    QByteArray record;
+    record.reserve(RECORD_HEADER_SIZE + payload.size());
+    record.append(header, RECORD_HEADER_SIZE);
+    record.append(payload);
+    
+    if (journal.file.write(record) != record.size()) {
+        qWarning() << "Stream journal write failed:" << journal.file.errorString();
+        return false;
+    }
+    journal.unsyncedBytes += record.size();
+    return true;
+}
+
+bool StreamJournal::syncFile(QFile& file)
+{
+    if (!file.isOpen()) return false;
+
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+QString StreamJournal::journalPath(const QString& replyId) const
+{
+    return m_directory + "/" + replyId + ".journal";
+}
+
+std::vector<RecoveredStream> StreamJournal::recover(const QString& directory)
+{
+    std::vector<RecoveredStream> recovered;
+    
+    const QFileInfoList files = QDir(directory).entryInfoList({"*.journal"}, QDir::Files, QDir::Time | QDir::Reversed);
+    for (const QFileInfo& info : files) {
+        QFile file(info.absoluteFilePath());
+        if (!file.open(QIODevice::ReadOnly)) continue;
+        const QByteArray data = file.readAll();
+    
+        RecoveredStream stream;
+        stream.journalPath = info.absoluteFilePath();
+        QString reply;
+        bool haveHeader = false;
+    
+        qsizetype pos = 0;
+        while (pos + RECORD_HEADER_SIZE <= data.size()) {
+            const quint8 type = static_cast<quint8>(data[pos]);
+            const quint32 length = qFromLittleEndian<quint32>(data.constData() + pos + 1);
+            const quint16 expected = qFromLittleEndian<quint16>(data.constData() + pos + 5);
+            if (length > MAX_RECORD_SIZE
+                || static_cast<quint64>(pos) + RECORD_HEADER_SIZE + length > static_cast<quint64>(data.size())) {
+                break; // Torn final record
+            }
+    
+            const QByteArray payload = data.mid(pos + RECORD_HEADER_SIZE, length);
+            if (checksum(payload) != expected) break;
+            pos += RECORD_HEADER_SIZE + length;
+    
+            if (type == HeaderRecord && !haveHeader) {
+                const QJsonObject header = QJsonDocument::fromJson(payload).object();
+                stream.modelId = header.value("model").toString();
+                stream.startedAt = QDateTime::fromString(header.value("started").toString(), Qt::ISODateWithMs);
+                for (const QJsonValue& value : header.value("messages").toArray()) {
+                    const QJsonObject obj = value.toObject();
+                    Message msg(obj.value("content").toString(), roleFromName(obj.value("role").toString()));
+                    msg.id = obj.value("id").toString(msg.id);
+                    msg.timestamp = QDateTime::fromString(obj.value("timestamp").toString(), Qt::ISODateWithMs);
+    
+                    QStringList missing;
+                    for (const QJsonValue& attachmentValue : obj.value("attachments").toArray()) {
+                        // Version 1 journals kept only the name
+                        if (attachmentValue.isString()) {
+                            missing.append(attachmentValue.toString());
+                            continue;
+                        }
+                        const QJsonObject attachmentObj = attachmentValue.toObject();
+                        if (auto attachment = restoreAttachment(attachmentObj)) {
+                            msg.addAttachment(attachment);
+                        } else {
+                            missing.append(attachmentObj.value("filename").toString());
+                        }
+                    }
+                    if (!missing.isEmpty()) {
+                        const QString note = QString("[Attachment missing: %1]").arg(missing.join(", "));
+                        msg.content = msg.content.isEmpty() ? note : msg.content + "\n" + note;
+                    }
+                    stream.messages.push_back(msg);
+                }
+                haveHeader = true;
+            } else if (type == DeltaRecord && haveHeader) {
+                reply += QString::fromUtf8(payload);
+            }
+        }
+    
+        if (!haveHeader) {
+            // Killed before the header reached the disk; nothing to restore
+            file.close();
+            removeJournal(stream.journalPath);
+            continue;
+        }
+    
+        Message partial(reply, MessageRole::Assistant);
+        partial.timestamp = stream.startedAt.isValid() ? stream.startedAt : info.lastModified();
+        partial.setError(); // Marks the reply as incomplete
+        stream.messages.push_back(partial);
+        recovered.push_back(std::move(stream));
+    }
+    
+    return recovered;
+}
+
+bool StreamJournal::removeJournal(const QString& path)
+{
+    return QFile::remove(path);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "Message.h"
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+#include <QHash>
+#include <QFile>
+#include <QJsonObject>
+#include <QTimer>
+#include <memory>
+#include <vector>
+
+// An assistant reply that was still streaming when the app went away
+struct RecoveredStream {
+    QString journalPath;
+    QString modelId;
+    QDateTime startedAt;
+    std::vector<Message> messages;   // Conversation up to and including the partial reply
+};
+
+// Append-only journal of streaming replies, one file per reply under the
+// app data directory. Each delta is written to the OS as it arrives, which
+// survives a crash or kill; fsync runs in batches (every SYNC_INTERVAL_MS or
+// SYNC_BYTES) to cover power loss without a sync per token. Lives on its own
+// thread; call the slots with QMetaObject::invokeMethod. A journal is removed
+// once its reply has finished, so only interrupted replies are left behind.
+//
+// File format: records of [type:u8][length:u32 LE][crc16:u16 LE][payload].
+// A torn final record fails its length or checksum and is ignored.
+//
+// Attachments are journalled by file path, not content; recovery reloads
+// the files that are still there and notes the missing ones in the message.
+class StreamJournal : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StreamJournal(const QString& directory, QObject *parent = nullptr);
+    ~StreamJournal();
+    
+    // Reads every journal left in directory; the caller removes the files
+    // (removeJournal) once the recovered messages are stored elsewhere
+    static std::vector<RecoveredStream> recover(const QString& directory);
+    static bool removeJournal(const QString& path);
+    
+    static constexpr int SYNC_INTERVAL_MS = 1000;
+    static constexpr qint64 SYNC_BYTES = 64 * 1024;
+
+public slots:
+    // conversation is the history the reply belongs to; it is encoded here,
+    // off the caller's thread, and must not be modified afterwards
+    void begin(const QString& replyId, std::shared_ptr<const std::vector<Message>> conversation,
+               const QString& modelId);
+    void append(const QString& replyId, const QString& delta);
+    void finish(const QString& replyId);
+
+private slots:
+    void syncAll();
+
+private:
+    enum RecordType : quint8 {
+        HeaderRecord = 1,
+        DeltaRecord = 2
+    };
+    
+    struct OpenJournal {
+        QFile file;
+        qint64 unsyncedBytes = 0;
+    };
+    
+    static QByteArray encodeHeader(const std::vector<Message>& conversation, const QString& modelId);
+    static std::shared_ptr<Attachment> restoreAttachment(const QJsonObject& obj);
+    
+    QString journalPath(const QString& replyId) const;
+    bool writeRecord(OpenJournal& journal, RecordType type, const QByteArray& payload);
+    static bool syncFile(QFile& file);
+    
+    QString m_directory;
+    QHash<QString, OpenJournal*> m_journals;
+    QTimer *m_syncTimer = nullptr;
+};
@@ -0,0 +1,328 @@
+#include "Tokenizer.h"
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QStringView>
+#include <QDebug>
+#include <algorithm>
+#include <climits>
+#include <iterator>
+
+namespace {
+
+// GPT-2 maps every byte to a printable code point so vocab entries are text
+QVector<ushort> byteToUnicode()
+{
+    QVector<ushort> table(256);
+    int next = 256;
+    for (int b = 0; b < 256; ++b) {
+        const bool printable = (b >= 33 && b <= 126) || (b >= 161 && b <= 172) || (b >= 174 && b <= 255);
+        table[b] = static_cast<ushort>(printable ? b : next++);
+    }
+    return table;
+}
+
+enum class CharClass {
+    Letter,
+    Number,
+    Space,
+    Other
+};
+
+CharClass classify(const QString& text, int index, int& length)
+{
+    const QChar c = text.at(index);
+    length = 1;
+    
+    uint codePoint = c.unicode();
+    if (c.isHighSurrogate() && index + 1 < text.size() && text.at(index + 1).isLowSurrogate()) {
+        codePoint = QChar::surrogateToUcs4(c, text.at(index + 1));
+        length = 2;
+    }
+    
+    if (QChar::isLetter(codePoint)) return CharClass::Letter;
+    if (QChar::isNumber(codePoint)) return CharClass::Number;
+    if (QChar::isSpace(codePoint)) return CharClass::Space;
+    return CharClass::Other;
+}
+
+// Length of a run of characters of one class starting at index
+int runLength(const QString& text, int index, CharClass cls)
+{
+    int end = index;
+    int length = 0;
+    while (end < text.size() && classify(text, end, length) == cls) {
+        end += length;
+    }
+    return end - index;
+}
+
+// Matches 's 't 're 've 'm 'll 'd at index, returning the length or 0
+int contractionLength(const QString& text, int index)
+{
+    if (text.at(index) != QLatin1Char('\'') || index + 1 >= text.size()) return 0;
+    
+    const QChar a = text.at(index + 1);
+    if (a == QLatin1Char('s') || a == QLatin1Char('t') || a == QLatin1Char('m') || a == QLatin1Char('d')) return 2;
+    
+    if (index + 2 < text.size()) {
+        const QChar b = text.at(index + 2);
+        if ((a == QLatin1Char('r') && b == QLatin1Char('e')) || (a == QLatin1Char('v') && b == QLatin1Char('e'))
+            || (a == QLatin1Char('l') && b == QLatin1Char('l'))) {
+            return 3;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+bool Tokenizer::load(const QString& directory)
+{
+    QDir dir(directory);
+    return load(dir.filePath("vocab.json"), dir.filePath("merges.txt"));
+}
+
+bool Tokenizer::load(const QString& vocabPath, const QString& mergesPath)
+{
+    QFile vocabFile(vocabPath);
+    QFile mergesFile(mergesPath);
+    if (!vocabFile.open(QIODevice::ReadOnly) || !mergesFile.open(QIODevice::ReadOnly)) {
+        qWarning() << "Tokenizer files not found:" << vocabPath << mergesPath;
+        return false;
+    }
+    
+    return loadFromData(vocabFile.readAll(), mergesFile.readAll());
+}
+
+bool Tokenizer::loadFromData(const QByteArray& vocabJson, const QByteArray& merges)
+{
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(vocabJson, &error);
+    if (error.error != QJsonParseError::NoError || !doc.isObject()) {
+        qWarning() << "Invalid tokenizer vocabulary:" << error.errorString();
+        return false;
+    }
+    
+    const QJsonObject vocabObj = doc.object();
+    QHash<QString, int> vocab;
+    vocab.reserve(vocabObj.size());
+    for (auto it = vocabObj.constBegin(); it != vocabObj.constEnd(); ++it) {
+        vocab.insert(it.key(), it.value().toInt());
+    }
+    
+    // Every byte must have a symbol for the encoding to be lossless
+    const QVector<ushort> byteChars = byteToUnicode();
+    int byteIds[256];
+    for (int b = 0; b < 256; ++b) {
+        const auto it = vocab.constFind(QString(QChar(byteChars[b])));
+        if (it == vocab.constEnd()) {
+            qWarning() << "Tokenizer vocabulary has no symbol for byte" << b;
+            return false;
+        }
+        byteIds[b] = it.value();
+    }
+    
+    QHash<quint64, Merge> mergeTable;
+    int rank = 0;
+    for (const QByteArray& rawLine : merges.split('\n')) {
+        const QByteArray line = rawLine.trimmed();
+        if (line.isEmpty() || line.startsWith("#version")) continue;
+        
+        const int space = line.indexOf(' ');
+        if (space <= 0) continue;
+        
+        const QString left = QString::fromUtf8(line.left(space));
+        const QString right = QString::fromUtf8(line.mid(space + 1));
+        const int leftId = vocab.value(left, -1);
+        const int rightId = vocab.value(right, -1);
+        const int mergedId = vocab.value(left + right, -1);
+        
+        if (leftId >= 0 && rightId >= 0 && mergedId >= 0) {
+            mergeTable.insert(pairKey(leftId, rightId), Merge{rank, mergedId});
+        }
+        ++rank;
+    }
+    
+    std::copy(std::begin(byteIds), std::end(byteIds), std::begin(m_byteIds));
+    m_merges = std::move(mergeTable);
+    m_vocabSize = vocab.size();
+    m_loaded = true;
+    clearCache();
+    
+    return true;
+}
+
+void Tokenizer::clearCache()
+{
+    QMutexLocker locker(&m_cacheMutex);
+    m_pieceCache.clear();
+    m_previousPieces.clear();
+    m_messageCache.clear();
+}
+
+QVector<int> Tokenizer::encode(const QString& text) const
+{
+    QVector<int> ids;
+    if (!m_loaded) return ids;
+    
+    tokenize(text, [&ids](const QVector<int>& piece) {
+        ids += piece;
+    });
+    return ids;
+}
+
+int Tokenizer::countTokens(const QString& text) const
+{
+    if (!m_loaded) return estimateTokens(text);
+    
+    int count = 0;
+    tokenize(text, [&count](const QVector<int>& piece) {
+        count += piece.size();
+    });
+    return count;
+}
+
+int Tokenizer::countTokens(const Message& message) const
+{
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        const auto it = m_messageCache.constFind(message.id);
+        if (it != m_messageCache.constEnd() && it->revision == message.revision
+            && it->contentLength == message.content.size()) {
+            return it->tokens;
+        }
+    }
+    
+    const int tokens = countTokens(message.content);
+    
+    QMutexLocker locker(&m_cacheMutex);
+    MessageCount& entry = m_messageCache[message.id];
+    entry.revision = message.revision;
+    entry.contentLength = message.content.size();
+    entry.tokens = tokens;
+    return tokens;
+}
+
+// Splits text like the GPT-2 pattern
+//   's|'t|'re|'ve|'m|'ll|'d| ?\p{L}+| ?\p{N}+| ?[^\s\p{L}\p{N}]+|\s+(?!\S)|\s+
+// and passes the token ids of each piece to sink.
+template <typename Sink>
+void Tokenizer::tokenize(const QString& text, Sink&& sink) const
+{
+    const int size = text.size();
+    int index = 0;
+    int length = 0;
+    
+    while (index < size) {
+        int start = index;
+        int end = index;
+        
+        if (const int contraction = contractionLength(text, index)) {
+            end = index + contraction;
+        } else {
+            CharClass cls = classify(text, index, length);
+            
+            if (cls == CharClass::Space) {
+                const int run = runLength(text, index, CharClass::Space);
+                end = index + run;
+                
+                if (end < size) {
+                    // Leave the last whitespace character to prefix the next word
+                    if (run > 1) {
+                        end -= 1;
+                    } else if (text.at(index) == QLatin1Char(' ')) {
+                        cls = classify(text, index + 1, length);
+                        end = index + 1 + runLength(text, index + 1, cls);
+                    }
+                }
+            } else {
+                end = index + runLength(text, index, cls);
+            }
+        }
+        
+        const QByteArray piece = QStringView(text).mid(start, end - start).toUtf8();
+        sink(encodePiece(piece));
+        index = end;
+    }
+}
+
+QVector<int> Tokenizer::encodePiece(const QByteArray& piece) const
+{
+    // A generation dropped by this call; freed once the lock is released
+    QHash<QByteArray, QVector<int>> retired;
+    {
+        QMutexLocker locker(&m_cacheMutex);
+        const auto it = m_pieceCache.constFind(piece);
+        if (it != m_pieceCache.constEnd()) {
+            return it.value();
+        }
+        
+        const auto previous = m_previousPieces.constFind(piece);
+        if (previous != m_previousPieces.constEnd()) {
+            const QVector<int> ids = previous.value();
+            cachePiece(piece, ids, retired);
+            return ids;
+        }
+    }
+    
+    // Other threads keep using the caches while this piece is merged
+    const QVector<int> ids = mergePiece(piece);
+    
+    QMutexLocker locker(&m_cacheMutex);
+    cachePiece(piece, ids, retired);
+    return ids;
+}
+
+void Tokenizer::cachePiece(const QByteArray& piece, const QVector<int>& ids,
+                           QHash<QByteArray, QVector<int>>& retired) const
+{
+    if (m_pieceCache.size() >= MAX_CACHED_PIECES / 2) {
+        retired.swap(m_previousPieces);
+        m_previousPieces.swap(m_pieceCache);
+    }
+    m_pieceCache.insert(piece, ids);
+}
+
+QVector<int> Tokenizer::mergePiece(const QByteArray& piece) const
+{
+    QVector<int> symbols;
+    symbols.reserve(piece.size());
+    for (char byte : piece) {
+        symbols.append(m_byteIds[static_cast<unsigned char>(byte)]);
+    }
+    
+    // Repeatedly apply the lowest-ranked merge present in the piece
+    while (symbols.size() > 1) {
+        Merge best{INT_MAX, -1};
+        int left = -1;
+        int right = -1;
+        
+        for (int i = 0; i + 1 < symbols.size(); ++i) {
+            const auto it = m_merges.constFind(pairKey(symbols[i], symbols[i + 1]));
+            if (it != m_merges.constEnd() && it->rank < best.rank) {
+                best = it.value();
+                left = symbols[i];
+                right = symbols[i + 1];
+            }
+        }
+        
+        if (best.id < 0) break;
+        
+        // Merge every occurrence of the pair, left to right
+        int out = 0;
+        for (int i = 0; i < symbols.size(); ++i) {
+            if (i + 1 < symbols.size() && symbols[i] == left && symbols[i + 1] == right) {
+                symbols[out++] = best.id;
+                ++i;
+            } else {
+                symbols[out++] = symbols[i];
+            }
+        }
+        symbols.resize(out);
+    }
+    
+    return symbols;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "Message.h"
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+
+// Byte-level byte-pair-encoding tokenizer compatible with the GPT-2 style
+// vocab.json / merges.txt pair published with most open models.
+//
+// Text is split by a hand-written equivalent of the GPT-2 pre-tokenizer
+// pattern, each piece is mapped to byte symbols and merged by rank using a
+// hash table keyed on the pair of symbol ids. Encoded pieces and per-message
+// counts are cached, so re-counting a conversation only tokenizes what
+// changed. Until files are loaded, counts fall back to a length heuristic.
+class Tokenizer {
+public:
+    Tokenizer() = default;
+    
+    // Loading
+    bool load(const QString& directory);
+    bool load(const QString& vocabPath, const QString& mergesPath);
+    bool loadFromData(const QByteArray& vocabJson, const QByteArray& merges);
+    bool isLoaded() const { return m_loaded; }
+    int vocabularySize() const { return m_vocabSize; }
+    
+    // Encoding
+    QVector<int> encode(const QString& text) const;
+    int countTokens(const QString& text) const;
+    int countTokens(const Message& message) const;
+    
+    void clearCache();
+    
+    static int estimateTokens(const QString& text) { return static_cast<int>((text.size() + 3) / 4); }
+    
+    // Across both generations of the piece cache
+    static constexpr int MAX_CACHED_PIECES = 200000;
+
+private:
+    struct Merge {
+        int rank;
+        int id;
+    };
+    
+    struct MessageCount {
+        quint64 revision = 0;
+        qsizetype contentLength = 0;
+        int tokens = 0;
+    };
+    
+    bool m_loaded = false;
+    int m_vocabSize = 0;
+    int m_byteIds[256] = {};
+    QHash<quint64, Merge> m_merges;
+    
+    // Caches; guarded so the tokenizer can be shared across threads once
+    // loaded. The lock covers lookups and inserts only, never a BPE merge.
+    // Pieces live in two generations: when the current one fills up, the
+    // previous one is dropped and the current one takes its place, and hits
+    // in the previous one are carried over, so frequent pieces survive.
+    mutable QMutex m_cacheMutex;
+    mutable QHash<QByteArray, QVector<int>> m_pieceCache;
+    mutable QHash<QByteArray, QVector<int>> m_previousPieces;
+    mutable QHash<QString, MessageCount> m_messageCache;
+    
+    template <typename Sink>
+    void tokenize(const QString& text, Sink&& sink) const;
+    QVector<int> encodePiece(const QByteArray& piece) const;
+    void cachePiece(const QByteArray& piece, const QVector<int>& ids,
+                    QHash<QByteArray, QVector<int>>& retired) const;
+    QVector<int> mergePiece(const QByteArray& piece) const;
+    
+    static quint64 pairKey(int left, int right) {
+        return (static_cast<quint64>(static_cast<quint32>(left)) << 32) | static_cast<quint32>(right);
+    }
+};
@@ -5,9 +5,15 @@
 #include <QLoggingCategory>
 #include "MainWindow.h"
 #include "Settings.h"
+#include "ChatCli.h"
 
 int main(int argc, char *argv[])
 {
+    // Headless mode is decided before any GUI object exists
+    if (ChatCli::requested(argc, argv)) {
+        return ChatCli::run(argc, argv);
+    }
+    
     QApplication app(argc, argv);
     
     // Set application properties
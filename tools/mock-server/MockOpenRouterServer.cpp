@@ -0,0 +1,380 @@
+#include "MockOpenRouterServer.h"
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTimer>
+#include <QDebug>
+
+namespace {
+
+const char* const WORDS[] = {
+    "The", " quick", " brown", " fox", " jumps", " over", " the", " lazy", " dog", ".",
+    " Streaming", " responses", " arrive", " one", " token", " at", " a", " time", ",",
+    " and", " each", " delta", " is", " parsed", " as", " it", " comes", " in", ".", "\n"
+};
+constexpr int WORD_COUNT = sizeof(WORDS) / sizeof(WORDS[0]);
+
+QByteArray statusText(int status)
+{
+    switch (status) {
+        case 200: return "OK";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        case 504: return "Gateway Timeout";
+        default: return "Status";
+    }
+}
+
+} // namespace
+
+struct MockOpenRouterServer::ChatStream {
+    QByteArray completionId;
+    QString model;
+    int tokensLeft = 0;
+    int tokensSent = 0;
+    int promptTokens = 0;
+    int chunksSent = 0;
+    int disconnectAtChunk = -1;   // -1 = run to completion
+    int chunkIntervalMs = 0;
+};
+
+MockOpenRouterServer::MockOpenRouterServer(QObject *parent)
+    : QObject(parent)
+    , m_random(m_config.seed)
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &MockOpenRouterServer::onNewConnection);
+}
+
+MockOpenRouterServer::~MockOpenRouterServer()
+{
+    close();
+}
+
+bool MockOpenRouterServer::listen(const QHostAddress& address, quint16 port)
+{
+    if (!m_server.listen(address, port)) {
+        qWarning() << "Mock server cannot listen:" << m_server.errorString();
+        return false;
+    }
+    return true;
+}
+
+void MockOpenRouterServer::close()
+{
+    m_server.close();
+    for (QTcpSocket* socket : m_connections.keys()) {
+        socket->abort();
+        socket->deleteLater();
+    }
+    m_connections.clear();
+}
+
+QString MockOpenRouterServer::baseUrl() const
+{
+    return QString("http://127.0.0.1:%1/api/v1").arg(port());
+}
+
+void MockOpenRouterServer::setConfig(const MockServerConfig& config)
+{
+    m_config = config;
+    m_random.seed(config.seed);
+}
+
+void MockOpenRouterServer::onNewConnection()
+{
+    while (QTcpSocket* socket = m_server.nextPendingConnection()) {
+        ++m_stats.connections;
+        m_connections.insert(socket, Connection());
+    
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            auto it = m_connections.find(socket);
+            if (it == m_connections.end()) return;
+            it->buffer.append(socket->readAll());
+            processBuffer(socket);
+        });
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+            m_connections.remove(socket);
+            socket->deleteLater();
+        });
+    }
+}
+
+void MockOpenRouterServer::processBuffer(QTcpSocket* socket)
+{
+    auto it = m_connections.find(socket);
+    if (it == m_connections.end() || it->busy) return;
+    
+    HttpRequest request;
+    if (!parseRequest(it->buffer, request)) return;
+    it->busy = true;
+    
+    if (request.method == "GET" && request.path.endsWith("/models")) {
+        handleModels(socket, request);
+    } else if (request.method == "POST" && request.path.endsWith("/chat/completions")) {
+        handleChat(socket, request);
+    } else {
+        sendResponse(socket, 404, "application/json", R"({"error":{"message":"Not found","code":404}})");
+        emit requestHandled(QString::fromLatin1(request.method), QString::fromLatin1(request.path), 404);
+    }
+}
+
+bool MockOpenRouterServer::parseRequest(QByteArray& buffer, HttpRequest& request)
+{
+    const int headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd < 0) return false;
+    
+    const QList<QByteArray> lines = buffer.left(headerEnd).split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    if (requestLine.size() < 2) {
+        buffer.clear();
+        return false;
+    }
+    
+    request.method = requestLine[0];
+    request.path = requestLine[1];
+    const int query = request.path.indexOf('?');
+    if (query >= 0) {
+        request.path.truncate(query);
+    }
+    
+    for (int i = 1; i < lines.size(); ++i) {
+        const int colon = lines[i].indexOf(':');
+        if (colon > 0) {
+            request.headers.insert(lines[i].left(colon).trimmed().toLower(), lines[i].mid(colon + 1).trimmed());
+        }
+    }
+    
+    const int contentLength = request.headers.value("content-length", "0").toInt();
+    const int bodyStart = headerEnd + 4;
+    if (buffer.size() - bodyStart < contentLength) return false;
+    
+    request.body = buffer.mid(bodyStart, contentLength);
+    buffer.remove(0, bodyStart + contentLength);
+    return true;
+}
+
+void MockOpenRouterServer::handleModels(QTcpSocket* socket, const HttpRequest& request)
+{
+    ++m_stats.modelsRequests;
+    const QByteArray etag = QByteArray("\"mock-models-") + QByteArray::number(m_config.modelCount) + "\"";
+    
+    if (request.headers.value("if-none-match") == etag) {
+        sendResponse(socket, 304, QByteArray(), QByteArray(), "ETag: " + etag + "\r\n");
+        emit requestHandled("GET", QString::fromLatin1(request.path), 304);
+        return;
+    }
+    
+    QTimer::singleShot(jittered(m_config.timeToFirstByteMs), socket, [this, socket, etag, request]() {
+        sendResponse(socket, 200, "application/json", modelsBody(), "ETag: " + etag + "\r\n");
+        emit requestHandled("GET", QString::fromLatin1(request.path), 200);
+    });
+}
+
+void MockOpenRouterServer::handleChat(QTcpSocket* socket, const HttpRequest& request)
+{
+    ++m_stats.chatRequests;
+    const QString path = QString::fromLatin1(request.path);
+    
+    const QJsonObject body = QJsonDocument::fromJson(request.body).object();
+    if (body.isEmpty()) {
+        sendResponse(socket, 400, "application/json", R"({"error":{"message":"Invalid JSON body","code":400}})");
+        emit requestHandled("POST", path, 400);
+        return;
+    }
+    
+    // Failures are rolled up front so a seed always fails the same requests
+    const bool fail = m_random.generateDouble() < m_config.errorRate;
+    const bool disconnect = m_random.generateDouble() < m_config.disconnectRate;
+    
+    if (fail) {
+        ++m_stats.errorsSent;
+        const int status = m_config.errorStatus;
+        const QByteArray retryAfter = (status == 429 || status == 503)
+            ? "Retry-After: " + QByteArray::number(m_config.retryAfterSeconds) + "\r\n" : QByteArray();
+        QTimer::singleShot(jittered(m_config.timeToFirstByteMs), socket, [this, socket, status, retryAfter, path]() {
+            sendResponse(socket, status, "application/json",
+                         "{\"error\":{\"message\":\"Mock " + statusText(status) + "\",\"code\":"
+                             + QByteArray::number(status) + "}}",
+                         retryAfter);
+            emit requestHandled("POST", path, status);
+        });
+        return;
+    }
+    
+    auto stream = std::make_shared<ChatStream>();
+    stream->completionId = "gen-mock-" + QByteArray::number(m_nextCompletionId++);
+    stream->model = body.value("model").toString();
+    stream->tokensLeft = m_config.responseTokens;
+    const int maxTokens = body.value("max_tokens").toInt();
+    if (maxTokens > 0) {
+        stream->tokensLeft = qMin(stream->tokensLeft, maxTokens);
+    }
+    stream->promptTokens = request.body.size() / 4;
+    stream->chunkIntervalMs = m_config.tokensPerSecond > 0.0
+        ? static_cast<int>(qMax(1, m_config.tokensPerChunk) * 1000.0 / m_config.tokensPerSecond) : 0;
+    if (disconnect) {
+        const int chunks = qMax(1, stream->tokensLeft / qMax(1, m_config.tokensPerChunk));
+        stream->disconnectAtChunk = m_random.bounded(chunks) + 1;
+    }
+    
+    QTimer::singleShot(jittered(m_config.timeToFirstByteMs), socket, [this, socket, stream, path]() {
+        socket->write("HTTP/1.1 200 OK\r\n"
+                      "Content-Type: text/event-stream\r\n"
+                      "Cache-Control: no-cache\r\n"
+                      "Transfer-Encoding: chunked\r\n"
+                      "Connection: keep-alive\r\n\r\n");
+        // Providers send SSE comments while the model is queued
+        writeChunk(socket, ": OPENROUTER PROCESSING\n\n");
+        emit requestHandled("POST", path, 200);
+    
+        QTimer::singleShot(jittered(m_config.timeToFirstTokenMs), socket, [this, socket, stream]() {
+            streamNext(socket, stream);
+        });
+    });
+}
+
+QString MockOpenRouterServer::expectedContent(int tokens)
+{
+    QString text;
+    for (int i = 0; i < tokens; ++i) {
+        text += QString::fromLatin1(WORDS[i % WORD_COUNT]);
+    }
+    return text;
+}
+
+void MockOpenRouterServer::streamNext(QTcpSocket* socket, std::shared_ptr<ChatStream> stream)
+{
+    if (stream->disconnectAtChunk >= 0 && stream->chunksSent >= stream->disconnectAtChunk) {
+        ++m_stats.disconnects;
+        socket->abort();
+        return;
+    }
+    
+    if (stream->tokensLeft <= 0) {
+        QJsonObject usage;
+        usage["prompt_tokens"] = stream->promptTokens;
+        usage["completion_tokens"] = stream->tokensSent;
+        usage["total_tokens"] = stream->promptTokens + stream->tokensSent;
+    
+        QJsonObject choice;
+        choice["index"] = 0;
+        choice["delta"] = QJsonObject();
+        choice["finish_reason"] = "stop";
+    
+        QJsonObject last;
+        last["id"] = QString::fromLatin1(stream->completionId);
+        last["model"] = stream->model;
+        last["choices"] = QJsonArray{choice};
+        last["usage"] = usage;
+    
+        writeChunk(socket, "data: " + QJsonDocument(last).toJson(QJsonDocument::Compact) + "\n\n");
+        writeChunk(socket, "data: [DONE]\n\n");
+        ++m_stats.completedStreams;
+        finishResponse(socket);
+        return;
+    }
+    
+    const int count = qMin(stream->tokensLeft, qMax(1, m_config.tokensPerChunk));
+    QString text;
+    for (int i = 0; i < count; ++i) {
+        text += QString::fromLatin1(WORDS[(stream->tokensSent + i) % WORD_COUNT]);
+    }
+    stream->tokensLeft -= count;
+    stream->tokensSent += count;
+    ++stream->chunksSent;
+    
+    if (m_random.generateDouble() < m_config.malformedChunkRate) {
+        ++m_stats.malformedChunks;
+        writeChunk(socket, "data: {\"id\":\"" + stream->completionId + "\",\"choices\":[{\"delta\":{\"content\":\n\n");
+    } else {
+        QJsonObject delta;
+        delta["content"] = text;
+        QJsonObject choice;
+        choice["index"] = 0;
+        choice["delta"] = delta;
+        QJsonObject chunk;
+        chunk["id"] = QString::fromLatin1(stream->completionId);
+        chunk["model"] = stream->model;
+        chunk["choices"] = QJsonArray{choice};
+        writeChunk(socket, "data: " + QJsonDocument(chunk).toJson(QJsonDocument::Compact) + "\n\n");
+    }
+    
+    QTimer::singleShot(jittered(stream->chunkIntervalMs), socket, [this, socket, stream]() {
+        streamNext(socket, stream);
+    });
+}
+
+void MockOpenRouterServer::sendResponse(QTcpSocket* socket, int status, const QByteArray& contentType,
+                                        const QByteArray& body, const QByteArray& extraHeaders)
+{
+    QByteArray response = "HTTP/1.1 " + QByteArray::number(status) + " " + statusText(status) + "\r\n";
+    if (!contentType.isEmpty()) {
+        response += "Content-Type: " + contentType + "\r\n";
+    }
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += "Connection: keep-alive\r\n";
+    response += extraHeaders;
+    response += "\r\n";
+    response += body;
+    socket->write(response);
+    
+    auto it = m_connections.find(socket);
+    if (it != m_connections.end()) {
+        it->busy = false;
+    }
+    processBuffer(socket);
+}
+
+void MockOpenRouterServer::finishResponse(QTcpSocket* socket)
+{
+    socket->write("0\r\n\r\n");
+    
+    auto it = m_connections.find(socket);
+    if (it != m_connections.end()) {
+        it->busy = false;
+    }
+    processBuffer(socket);
+}
+
+void MockOpenRouterServer::writeChunk(QTcpSocket* socket, const QByteArray& data)
+{
+    socket->write(QByteArray::number(data.size(), 16) + "\r\n" + data + "\r\n");
+}
+
+int MockOpenRouterServer::jittered(int delayMs)
+{
+    if (m_config.jitterMs <= 0) return qMax(0, delayMs);
+    return qMax(0, delayMs + m_random.bounded(-m_config.jitterMs, m_config.jitterMs + 1));
+}
+
+QByteArray MockOpenRouterServer::modelsBody() const
+{
+    QJsonArray models;
+    for (int i = 0; i < m_config.modelCount; ++i) {
+        QJsonObject pricing;
+        pricing["prompt"] = QString::number(0.000001 * (i % 10 + 1), 'f', 7);
+        pricing["completion"] = QString::number(0.000002 * (i % 10 + 1), 'f', 7);
+    
+        QJsonObject architecture;
+        architecture["input_modalities"] = (i % 3 == 0) ? QJsonArray{"text", "image"} : QJsonArray{"text"};
+        architecture["output_modalities"] = QJsonArray{"text"};
+    
+        QJsonObject model;
+        model["id"] = QString("mock/model-%1").arg(i);
+        model["name"] = QString("Mock Model %1").arg(i);
+        model["description"] = "Deterministic model served by the local mock server";
+        model["context_length"] = 8192 << (i % 5);
+        model["pricing"] = pricing;
+        model["architecture"] = architecture;
+        models.append(model);
+    }
+    
+    QJsonObject root;
+    root["data"] = models;
+    return QJsonDocument(root).toJson(QJsonDocument::Compact);
+}
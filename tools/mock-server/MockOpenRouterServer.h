@@ -0,0 +1,110 @@
+#pragma once
+
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHostAddress>
+#include <QRandomGenerator>
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <memory>
+
+// Minimal OpenRouter look-alike for offline benchmarks and regression runs.
+// Serves GET <base>/models and a streaming POST <base>/chat/completions over
+// plain HTTP/1.1 with keep-alive and chunked transfer encoding. Timing and
+// failures follow MockServerConfig and are reproducible for a given seed.
+struct MockServerConfig {
+    // Response shape
+    int responseTokens = 200;         // Content tokens per completion
+    int tokensPerChunk = 1;           // Tokens per SSE event
+    double tokensPerSecond = 100.0;   // 0 = send as fast as possible
+    int timeToFirstByteMs = 150;      // Delay before the status line
+    int timeToFirstTokenMs = 50;      // Further delay before the first token
+    int jitterMs = 0;                 // Uniform +/- jitter on every delay
+    
+    // Failures, each rolled per request (chunk for malformedChunkRate)
+    double errorRate = 0.0;           // Fraction answered with errorStatus
+    int errorStatus = 503;
+    int retryAfterSeconds = 1;        // Sent with 429 and 503
+    double disconnectRate = 0.0;      // Fraction cut off mid-stream
+    double malformedChunkRate = 0.0;  // Fraction of events with broken JSON
+    
+    // Catalogue
+    int modelCount = 50;
+    
+    quint32 seed = 1;
+};
+
+struct MockServerStats {
+    int connections = 0;
+    int modelsRequests = 0;
+    int chatRequests = 0;
+    int errorsSent = 0;
+    int disconnects = 0;
+    int malformedChunks = 0;
+    int completedStreams = 0;
+};
+
+class MockOpenRouterServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MockOpenRouterServer(QObject *parent = nullptr);
+    ~MockOpenRouterServer();
+    
+    bool listen(const QHostAddress& address = QHostAddress::LocalHost, quint16 port = 0);
+    void close();
+    quint16 port() const { return m_server.serverPort(); }
+    
+    // Value for OpenRouterAPI::setBaseURL
+    QString baseUrl() const;
+    
+    void setConfig(const MockServerConfig& config);
+    const MockServerConfig& config() const { return m_config; }
+    MockServerStats stats() const { return m_stats; }
+    
+    // Text a completion of this many tokens streams, barring malformed chunks
+    static QString expectedContent(int tokens);
+
+signals:
+    void requestHandled(const QString& method, const QString& path, int status);
+
+private slots:
+    void onNewConnection();
+
+private:
+    struct HttpRequest {
+        QByteArray method;
+        QByteArray path;
+        QHash<QByteArray, QByteArray> headers;  // Lower-case names
+        QByteArray body;
+    };
+    
+    struct ChatStream;
+    
+    struct Connection {
+        QByteArray buffer;
+        bool busy = false;   // A response is still being written
+    };
+    
+    void processBuffer(QTcpSocket* socket);
+    static bool parseRequest(QByteArray& buffer, HttpRequest& request);
+    void handleModels(QTcpSocket* socket, const HttpRequest& request);
+    void handleChat(QTcpSocket* socket, const HttpRequest& request);
+    void streamNext(QTcpSocket* socket, std::shared_ptr<ChatStream> stream);
+    void sendResponse(QTcpSocket* socket, int status, const QByteArray& contentType,
+                      const QByteArray& body, const QByteArray& extraHeaders = QByteArray());
+    void finishResponse(QTcpSocket* socket);
+    static void writeChunk(QTcpSocket* socket, const QByteArray& data);
+    int jittered(int delayMs);
+    QByteArray modelsBody() const;
+    
+    QTcpServer m_server;
+    MockServerConfig m_config;
+    MockServerStats m_stats;
+    QRandomGenerator m_random;
+    QHash<QTcpSocket*, Connection> m_connections;
+    quint64 m_nextCompletionId = 1;
+};
@@ -0,0 +1,69 @@
+#include "MockOpenRouterServer.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <cstdio>
+
+// Stand-alone mock OpenRouter endpoint. Point Chatty's base URL (or any
+// OpenAI-style client) at the printed URL to run without the real service.
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("ChattyMockServer");
+    
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local mock of the OpenRouter API for offline testing");
+    parser.addHelpOption();
+    
+    const QCommandLineOption portOption("port", "Port to listen on (0 = any free port).", "port", "8089");
+    const QCommandLineOption tokensOption("tokens", "Content tokens per completion.", "count", "200");
+    const QCommandLineOption rateOption("rate", "Tokens per second (0 = unthrottled).", "tps", "100");
+    const QCommandLineOption chunkOption("chunk", "Tokens per SSE event.", "count", "1");
+    const QCommandLineOption ttfbOption("ttfb", "Delay before response headers, in ms.", "ms", "150");
+    const QCommandLineOption ttftOption("ttft", "Further delay before the first token, in ms.", "ms", "50");
+    const QCommandLineOption jitterOption("jitter", "Uniform +/- jitter on every delay, in ms.", "ms", "0");
+    const QCommandLineOption errorRateOption("error-rate", "Fraction of chat requests that fail.", "fraction", "0");
+    const QCommandLineOption errorStatusOption("error-status", "HTTP status for failed requests.", "status", "503");
+    const QCommandLineOption disconnectOption("disconnect-rate", "Fraction of streams cut off mid-way.", "fraction", "0");
+    const QCommandLineOption malformedOption("malformed-rate", "Fraction of events with broken JSON.", "fraction", "0");
+    const QCommandLineOption modelsOption("models", "Number of models in the catalogue.", "count", "50");
+    const QCommandLineOption seedOption("seed", "Random seed for jitter and failures.", "seed", "1");
+    
+    parser.addOptions({portOption, tokensOption, rateOption, chunkOption, ttfbOption, ttftOption, jitterOption,
+                       errorRateOption, errorStatusOption, disconnectOption, malformedOption, modelsOption,
+                       seedOption});
+    parser.process(app);
+    
+    MockServerConfig config;
+    config.responseTokens = parser.value(tokensOption).toInt();
+    config.tokensPerSecond = parser.value(rateOption).toDouble();
+    config.tokensPerChunk = parser.value(chunkOption).toInt();
+    config.timeToFirstByteMs = parser.value(ttfbOption).toInt();
+    config.timeToFirstTokenMs = parser.value(ttftOption).toInt();
+    config.jitterMs = parser.value(jitterOption).toInt();
+    config.errorRate = parser.value(errorRateOption).toDouble();
+    config.errorStatus = parser.value(errorStatusOption).toInt();
+    config.disconnectRate = parser.value(disconnectOption).toDouble();
+    config.malformedChunkRate = parser.value(malformedOption).toDouble();
+    config.modelCount = parser.value(modelsOption).toInt();
+    config.seed = parser.value(seedOption).toUInt();
+    
+    MockOpenRouterServer server;
+    server.setConfig(config);
+    if (!server.listen(QHostAddress::LocalHost, static_cast<quint16>(parser.value(portOption).toUInt()))) {
+        return 1;
+    }
+    
+    QObject::connect(&server, &MockOpenRouterServer::requestHandled,
+                     [](const QString& method, const QString& path, int status) {
+        std::printf("%s %s -> %d\n", qPrintable(method), qPrintable(path), status);
+        std::fflush(stdout);
+    });
+    
+    std::printf("Mock OpenRouter listening at %s\n", qPrintable(server.baseUrl()));
+    std::fflush(stdout);
+    
+    return app.exec();
+}